@@ -5,26 +5,40 @@
  */
 #include "onnxwrapper.h"
 
+#include <unistd.h>  // getpid
+
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>  // std::numeric_limits
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <sstream>
 #include <utility>
 #include <vector>
 
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
 #include "onnxruntime_cxx_api.h"
+#include "onnxruntime_session_options_config_keys.h"
 
 namespace InferenceEngine {
 
 /** Function to perform the product of the elements of a vector */
 template <typename T>
 T vectorProduct(const std::vector<T> &v) {
-    return std::accumulate(v.begin(), v.end(), 1, std::multiplies<T>());
+    return std::accumulate(v.begin(), v.end(), T(1), std::multiplies<T>());
 }
 
 /** Function to pretty print a vector */
@@ -43,12 +57,433 @@ std::ostream &operator<<(std::ostream &os, const std::vector<T> &v) {
     return os;
 }
 
+/**
+ * Find the value of a field in one event of an ONNX Runtime profile.
+ * The profile is a JSON array with one event object per line, so each line is searched on its own.
+ */
+static bool findProfileField(const std::string &line, const std::string &key, size_t &valueBegin) {
+    size_t pos = line.find("\"" + key + "\"");
+    if (pos == std::string::npos)
+        return false;
+    pos = line.find(':', pos + key.size() + 2);
+    if (pos == std::string::npos)
+        return false;
+    valueBegin = line.find_first_not_of(' ', pos + 1);
+    return valueBegin != std::string::npos;
+}
+
+static std::string getProfileString(const std::string &line, const std::string &key) {
+    size_t begin;
+    if (!findProfileField(line, key, begin) || line[begin] != '"')
+        return "";
+    const size_t end = line.find('"', begin + 1);
+    return end == std::string::npos ? "" : line.substr(begin + 1, end - begin - 1);
+}
+
+static double getProfileNumber(const std::string &line, const std::string &key) {
+    size_t begin;
+    if (!findProfileField(line, key, begin))
+        return 0.0;
+    return std::strtod(line.c_str() + begin, nullptr);
+}
+
+/** Parse a list of typed shapes, e.g. [{"float":[1,3,32,32]},{"float":[8,3,3,3]}] */
+static std::vector<std::vector<int64_t>> getProfileShapes(const std::string &line, const std::string &key) {
+    std::vector<std::vector<int64_t>> shapes;
+    size_t begin;
+    if (!findProfileField(line, key, begin) || line[begin] != '[')
+        return shapes;
+
+    int depth = 0;
+    for (size_t i = begin; i < line.size(); ++i) {
+        const char c = line[i];
+        if (c == '[') {
+            if (++depth == 2)
+                shapes.emplace_back();
+        } else if (c == ']') {
+            if (--depth == 0)
+                break;
+        } else if (depth == 2 && (c == '-' || (c >= '0' && c <= '9'))) {
+            char *end;
+            shapes.back().push_back(std::strtoll(line.c_str() + i, &end, 10));
+            i = end - line.c_str() - 1;
+        }
+    }
+    return shapes;
+}
+
+/**
+ * Conversion between float and IEEE half precision, rounding to nearest even.
+ * With F16C (x86) or on ARMv8 the compiler emits the conversion instructions, otherwise the bits are converted
+ * (F. Giesen, "float->half variants").
+ */
+#if !defined(__F16C__) && !defined(__aarch64__)
+static uint16_t floatToHalf(float value) {
+    const uint32_t f32Infinity = 255u << 23;
+    const uint32_t f16Max = (127u + 16u) << 23;
+    const uint32_t denormMagicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint16_t half;
+    if (bits >= f16Max) {
+        half = bits > f32Infinity ? 0x7e00 : 0x7c00;  // NaN stays NaN, overflows become infinity
+    } else if (bits < (113u << 23)) {
+        // Result is subnormal (or zero): let the float addition round the mantissa
+        float denormMagic, shifted;
+        std::memcpy(&denormMagic, &denormMagicBits, sizeof(denormMagic));
+        std::memcpy(&shifted, &bits, sizeof(shifted));
+        shifted += denormMagic;
+        std::memcpy(&bits, &shifted, sizeof(bits));
+        half = (uint16_t)(bits - denormMagicBits);
+    } else {
+        const uint32_t mantissaOdd = (bits >> 13) & 1;
+        bits += ((uint32_t)(15 - 127) << 23) + 0xfff + mantissaOdd;
+        half = (uint16_t)(bits >> 13);
+    }
+    return half | (uint16_t)(sign >> 16);
+}
+
+static float halfToFloat(uint16_t half) {
+    const uint32_t shiftedExponent = 0x7c00u << 13;
+    uint32_t bits = ((uint32_t)half & 0x7fffu) << 13;
+    const uint32_t exponent = shiftedExponent & bits;
+    bits += (127u - 15u) << 23;
+    if (exponent == shiftedExponent) {
+        bits += (128u - 16u) << 23;  // Infinity/NaN
+    } else if (exponent == 0) {
+        // Subnormal: renormalize with a float subtraction
+        const uint32_t magicBits = 113u << 23;
+        float magic, value;
+        std::memcpy(&magic, &magicBits, sizeof(magic));
+        bits += 1u << 23;
+        std::memcpy(&value, &bits, sizeof(value));
+        value -= magic;
+        std::memcpy(&bits, &value, sizeof(bits));
+    }
+    bits |= ((uint32_t)half & 0x8000u) << 16;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+#endif
+
+static void floatToHalf(const float input[], uint16_t output[], size_t size) {
+#if defined(__F16C__)
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        _mm_storeu_si128((__m128i *)(output + i), _mm256_cvtps_ph(_mm256_loadu_ps(input + i), _MM_FROUND_TO_NEAREST_INT));
+    for (; i < size; ++i)
+        output[i] = _cvtss_sh(input[i], _MM_FROUND_TO_NEAREST_INT);
+#elif defined(__aarch64__)
+    __fp16 *halfOutput = (__fp16 *)output;
+    for (size_t i = 0; i < size; ++i)
+        halfOutput[i] = (__fp16)input[i];
+#else
+    for (size_t i = 0; i < size; ++i)
+        output[i] = floatToHalf(input[i]);
+#endif
+}
+
+static void halfToFloat(const uint16_t input[], float output[], size_t size) {
+#if defined(__F16C__)
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(output + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(input + i))));
+    for (; i < size; ++i)
+        output[i] = _cvtsh_ss(input[i]);
+#elif defined(__aarch64__)
+    const __fp16 *halfInput = (const __fp16 *)input;
+    for (size_t i = 0; i < size; ++i)
+        output[i] = (float)halfInput[i];
+#else
+    for (size_t i = 0; i < size; ++i)
+        output[i] = halfToFloat(input[i]);
+#endif
+}
+
+/** Quantize like the QuantizeLinear operator: round(value / scale) + zeroPoint, saturated (vectorized by the compiler) */
+template <typename T>
+static void quantize(const float input[], T output[], size_t size, float scale, int32_t zeroPoint) {
+    const float low = (float)((int32_t)std::numeric_limits<T>::min() - zeroPoint);
+    const float high = (float)((int32_t)std::numeric_limits<T>::max() - zeroPoint);
+    for (size_t i = 0; i < size; ++i) {
+        const float value = std::nearbyint(std::min(std::max(input[i] / scale, low), high));
+        output[i] = (T)((int32_t)value + zeroPoint);
+    }
+}
+
+template <typename T>
+static void dequantize(const T input[], float output[], size_t size, float scale, int32_t zeroPoint) {
+    for (size_t i = 0; i < size; ++i)
+        output[i] = scale * (float)((int32_t)input[i] - zeroPoint);
+}
+
+/** Input or output of the model, bound to a preallocated buffer */
+struct TensorBinding {
+    std::string name;
+    std::vector<int64_t> shape;
+    size_t size = 0;  // Number of elements
+
+    ONNXTensorElementDataType type = ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    float scale = 1.0f;  // int8/uint8: real = scale * (quantized - zeroPoint)
+    int32_t zeroPoint = 0;
+
+    std::vector<float> values;    // Float values of the bound API: the data of the tensor for float tensors
+    std::vector<uint8_t> data;    // Data of the tensor for the other types, converted from/to values
+
+    bool isConverted() const { return type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT; }
+    void *getTensorData() { return isConverted() ? (void *)data.data() : (void *)values.data(); }
+    size_t getTensorBytes() const { return isConverted() ? data.size() : values.size() * sizeof(float); }
+
+    /** Convert the values into the tensor data (inputs, before running) */
+    void toTensor() {
+        if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16)
+            floatToHalf(values.data(), (uint16_t *)data.data(), size);
+        else if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8)
+            quantize(values.data(), (int8_t *)data.data(), size, scale, zeroPoint);
+        else if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8)
+            quantize(values.data(), (uint8_t *)data.data(), size, scale, zeroPoint);
+    }
+
+    /** Convert the tensor data into the values (outputs, after running) */
+    void fromTensor() {
+        if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16)
+            halfToFloat((const uint16_t *)data.data(), values.data(), size);
+        else if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8)
+            dequantize((const int8_t *)data.data(), values.data(), size, scale, zeroPoint);
+        else if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8)
+            dequantize((const uint8_t *)data.data(), values.data(), size, scale, zeroPoint);
+    }
+};
+
+static const char *getTypeName(ONNXTensorElementDataType type) {
+    switch (type) {
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+        return "float";
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+        return "float16";
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+        return "int8";
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+        return "uint8";
+    default:
+        return "unsupported";
+    }
+}
+
+/** Describe an input/output of the session, with the shape and quantization given in the options */
+static TensorBinding describeTensor(Ort::Session *session, size_t index, bool isInput, const InterpreterOptions &options) {
+    Ort::AllocatorWithDefaultOptions allocator;
+    TensorBinding binding;
+    char *name = isInput ? session->GetInputName(index, allocator) : session->GetOutputName(index, allocator);
+    binding.name = name;
+    allocator.Free(name);
+    const std::string what = std::string(isInput ? "Input" : "Output") + " '" + binding.name + "'";
+
+    const TensorSpec *spec = nullptr;
+    for (const auto &tensorSpec : options.tensors)
+        if (tensorSpec.name == binding.name)
+            spec = &tensorSpec;
+
+    Ort::TypeInfo typeInfo = isInput ? session->GetInputTypeInfo(index) : session->GetOutputTypeInfo(index);
+    auto tensorInfo = typeInfo.GetTensorTypeAndShapeInfo();
+    binding.type = tensorInfo.GetElementType();
+    if (std::string(getTypeName(binding.type)) == "unsupported")
+        throw std::runtime_error(what + " has unsupported element type " + std::to_string((int)binding.type) + " (float, float16, int8 and uint8 are supported).");
+
+    binding.shape = tensorInfo.GetShape();
+    if (spec != nullptr && !spec->shape.empty()) {
+        if (spec->shape.size() != binding.shape.size())
+            throw std::invalid_argument(what + " has " + std::to_string(binding.shape.size()) + " dimensions, the given shape " + std::to_string(spec->shape.size()));
+        for (size_t i = 0; i < binding.shape.size(); ++i) {
+            if (spec->shape[i] <= 0 || (binding.shape[i] >= 0 && binding.shape[i] != spec->shape[i]))
+                throw std::invalid_argument(what + " cannot have dimension " + std::to_string(i) + " of size " + std::to_string(spec->shape[i]));
+            binding.shape[i] = spec->shape[i];
+        }
+    } else {
+        // Free dimensions (e.g. a symbolic batch size) are reported as -1, the wrapper runs one frame at a time
+        for (auto &dim : binding.shape)
+            if (dim < 0)
+                dim = 1;
+    }
+    binding.size = (size_t)vectorProduct(binding.shape);
+    binding.values.assign(binding.size, 0.0f);
+
+    switch (binding.type) {
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+        binding.data.assign(binding.size * sizeof(uint16_t), 0);
+        break;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+        if (spec == nullptr || !(spec->scale > 0.0f))
+            throw std::invalid_argument(what + " is quantized (" + getTypeName(binding.type) + "), its scale and zero point have to be given in InterpreterOptions::tensors.");
+        binding.scale = spec->scale;
+        binding.zeroPoint = spec->zeroPoint;
+        binding.data.assign(binding.size, 0);
+        break;
+    default:
+        break;
+    }
+    return binding;
+}
+
+/**
+ * Whether the interpreter runs on the global thread pools of the environment: ONNX Runtime 1.7 only disables
+ * spinning there (the pools of a session always spin). Without a pool (one intra-op thread, sequential execution)
+ * there is nothing to spin.
+ */
+static bool usesGlobalPools(const InterpreterOptions &options) {
+    return !options.allowSpinning && (options.intraOpThreads != 1 || options.parallelExecution);
+}
+
+/**
+ * The environment of ONNX Runtime, one per process, created for the first interpreter (options == nullptr only
+ * returns it). If that interpreter uses global pools, the environment gets pools with its thread counts and without
+ * spinning, shared by the next interpreters that use global pools with the same thread counts.
+ */
+static Ort::Env &getEnv(const InterpreterOptions *options = nullptr) {
+    static std::mutex mutex;
+    static std::unique_ptr<Ort::Env> env;
+    static bool globalPools = false;
+    static int poolIntraOpThreads = 0;
+    static int poolInterOpThreads = 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const bool requested = options != nullptr && usesGlobalPools(*options);
+    if (env) {
+        if (requested && !globalPools)
+            throw std::invalid_argument("The ONNX Runtime environment was created without thread pools that do not spin (create the interpreters with allowSpinning = false first)");
+        if (requested && (options->intraOpThreads != poolIntraOpThreads || options->interOpThreads != poolInterOpThreads))
+            throw std::invalid_argument("The thread pools that do not spin already exist with " + std::to_string(poolIntraOpThreads) + " intra-op and " + std::to_string(poolInterOpThreads) +
+                                        " inter-op threads (requested " + std::to_string(options->intraOpThreads) + " and " + std::to_string(options->interOpThreads) + ")");
+        return *env;
+    }
+    if (!requested) {
+        env.reset(new Ort::Env());
+        return *env;
+    }
+
+    const OrtApi &api = Ort::GetApi();
+    OrtThreadingOptions *threadingOptions = nullptr;
+    Ort::ThrowOnError(api.CreateThreadingOptions(&threadingOptions));
+    std::unique_ptr<OrtThreadingOptions, decltype(api.ReleaseThreadingOptions)> threadingOptionsGuard(threadingOptions, api.ReleaseThreadingOptions);
+    Ort::ThrowOnError(api.SetGlobalIntraOpNumThreads(threadingOptions, options->intraOpThreads));
+    Ort::ThrowOnError(api.SetGlobalInterOpNumThreads(threadingOptions, options->interOpThreads));
+    Ort::ThrowOnError(api.SetGlobalSpinControl(threadingOptions, 0));
+    env.reset(new Ort::Env(threadingOptions));
+    globalPools = true;
+    poolIntraOpThreads = options->intraOpThreads;
+    poolInterOpThreads = options->interOpThreads;
+    return *env;
+}
+
+/**
+ * Register the arena shared by the sessions with ArenaMode::Exact, the first time it is requested.
+ * Interpreters may be created by several threads at the same time (e.g. bulk-eval).
+ */
+static void registerSharedArena(size_t maxBytes) {
+    static std::mutex mutex;
+    static bool registered = false;
+    static size_t registeredMaxBytes = 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (registered) {
+        if (maxBytes != registeredMaxBytes)
+            throw std::invalid_argument("The shared arena already exists with arenaMaxBytes " + std::to_string(registeredMaxBytes) + " (requested " + std::to_string(maxBytes) + ")");
+        return;
+    }
+    // -1: default initial chunk and dead bytes per chunk, 1: kSameAsRequested extension
+    Ort::ArenaCfg arenaConfig(maxBytes, 1, -1, -1);
+    Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault);
+    getEnv().CreateAndRegisterAllocator(memoryInfo, arenaConfig);
+    registered = true;
+    registeredMaxBytes = maxBytes;
+}
+
+/** 64-bit FNV-1a hash, as 16 hex digits */
+static std::string hashBytes(const char *data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    std::ostringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return stream.str();
+}
+
+/** Name of the optimized model in the cache: the source model and everything that changes how it is optimized */
+static std::string getOptimizedModelName(const char *modelData, size_t modelSize) {
+#if defined(__aarch64__)
+    const char *architecture = "aarch64";
+#elif defined(__arm__)
+    const char *architecture = "arm";
+#elif defined(__x86_64__)
+    const char *architecture = "x86-64";
+#else
+    const char *architecture = "unknown";
+#endif
+    const std::string settings = std::string("ort=") + OrtGetApiBase()->GetVersionString() +
+                                 ";level=" + std::to_string((int)GraphOptimizationLevel::ORT_ENABLE_ALL) + ";arch=" + architecture;
+    return hashBytes(modelData, modelSize) + "-" + hashBytes(settings.data(), settings.size()) + ".ort";
+}
+
+static std::vector<char> readFile(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file)
+        throw std::runtime_error("Could not open the model " + filename);
+    std::vector<char> bytes((size_t)file.tellg());
+    file.seekg(0);
+    if (!file.read(bytes.data(), bytes.size()))
+        throw std::runtime_error("Could not read the model " + filename);
+    return bytes;
+}
+
+/** Session options for the interpreter options (the optimized model path is set by the loaders) */
+static Ort::SessionOptions createSessionOptions(const InterpreterOptions &options, bool profiling) {
+    getEnv(&options);
+    Ort::SessionOptions sessionOptions;
+    sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+    sessionOptions.SetExecutionMode(options.parallelExecution ? ExecutionMode::ORT_PARALLEL : ExecutionMode::ORT_SEQUENTIAL);
+    if (usesGlobalPools(options)) {
+        sessionOptions.DisablePerSessionThreads();
+    } else {
+        sessionOptions.SetIntraOpNumThreads(options.intraOpThreads);
+        sessionOptions.SetInterOpNumThreads(options.interOpThreads);
+    }
+    if (options.memoryPattern)
+        sessionOptions.EnableMemPattern();
+    else
+        sessionOptions.DisableMemPattern();
+
+    switch (options.arena) {
+    case ArenaMode::Grow:
+        sessionOptions.EnableCpuMemArena();
+        break;
+    case ArenaMode::Exact:
+        registerSharedArena(options.arenaMaxBytes);
+        sessionOptions.EnableCpuMemArena();
+        sessionOptions.AddConfigEntry(kOrtSessionOptionsConfigUseEnvAllocators, "1");
+        break;
+    case ArenaMode::Disabled:
+        sessionOptions.DisableCpuMemArena();
+        break;
+    }
+
+    if (profiling)
+        sessionOptions.EnableProfiling("/tmp/onnxwrapper_profile");
+    return sessionOptions;
+}
+
 // Definition of the Interpreter class
 class InterpreterWrap {
 public:
     /** Constructor */
-    InterpreterWrap(const std::string &filename, bool verbose = false);            // Construct from file path
-    InterpreterWrap(const char *buffer, size_t bufferSize, bool verbose = false);  // Construct from buffer
+    InterpreterWrap(const std::string &filename, const InterpreterOptions &options, bool verbose = false);            // Construct from file path
+    InterpreterWrap(const char *buffer, size_t bufferSize, const InterpreterOptions &options, bool verbose = false);  // Construct from buffer
     void buildAndPrime(bool verbose = false);                                      // Build and prime the interpreter | Common part to the two constructors
 
     /** Destructor */
@@ -57,34 +492,74 @@ public:
     void invoke_internal(const float inputVector[], size_t inputSize, float outputVector[], size_t outputSize, bool verbose = false);
 
 
-    size_t getInputTensorSize() const { return inputTensorSize; }    // Get the size of the input tensor
-    size_t getOutputTensorSize () const { return outputTensorSize; } // Get the size of the output tensor
+    /** Run the model on the values of the bound input buffers, results in the bound output buffers */
+    void invokeBound();
+
+    size_t getInputTensorSize() const { return inputs[0].size; }    // Get the size of the (first) input tensor
+    size_t getOutputTensorSize () const { return outputs[0].size; } // Get the size of the (first) output tensor
+
+    /** Inputs/outputs of the model, in the order of the model */
+    std::vector<TensorBinding> &getInputs() { return inputs; }
+    std::vector<TensorBinding> &getOutputs() { return outputs; }
+
+    /** Recreate the session with profiling enabled / end profiling and report the events */
+    void enableProfiling(OpEventSink sink);
+    void disableProfiling();
+
+    /** Duration of the phases of the constructor */
+    const std::vector<StartupPhase> &getStartupPhases() const { return startupPhases; }
 private:
-    size_t inputTensorSize;
-    size_t outputTensorSize;
+    /** Bind the input/output tensors to the current session */
+    void bindTensors();
 
     /** Load the .onnx model and create inference session */
-    Ort::Session *loadModel(const std::string &filename);
-    Ort::Session *loadModelFromBuffer(const char *buffer, size_t bufferSize);
+    Ort::Session *loadModel(const std::string &filename, bool profiling = false, bool verbose = false);
+    Ort::Session *loadModelFromBuffer(const char *buffer, size_t bufferSize, bool profiling = false, bool verbose = false);
+    /** Load the optimized model from the cache, or optimize the model and save it in the cache */
+    Ort::Session *loadModelCached(const char *buffer, size_t bufferSize, bool profiling, bool verbose);
+
+    /** Read the profile written by ONNX Runtime and pass the kernel events to the sink */
+    void reportProfile(const std::string &profileFilename);
+
+    // Model source, used to recreate the session when profiling is enabled
+    std::string modelFilename;
+    const char *modelBuffer = nullptr;
+    size_t modelBufferSize = 0;
+
+    InterpreterOptions options;
+
+    OpEventSink profilingSink;
+    bool profiling = false;
+
+    /** Record the time since the end of the previous phase (or the start of the constructor) */
+    void endStartupPhase(const char *name);
+
+    std::vector<StartupPhase> startupPhases;
+    std::chrono::steady_clock::time_point phaseStart;
 
     //--------------------------------------------------------------------------
     Ort::Session *session;
 
-    std::vector<float> inputTensorValues;
-    std::vector<float> outputTensorValues;
-    std::vector<const char *> inputNames;
-    std::vector<const char *> outputNames;
+    std::vector<TensorBinding> inputs, outputs;
     std::vector<Ort::Value> inputTensors;
     std::vector<Ort::Value> outputTensors;
+
+    // Created once: names are resolved when binding, so that a run only executes the graph
+    std::unique_ptr<Ort::IoBinding> ioBinding;  // Belongs to the session, released before it
+    Ort::RunOptions runOptions;
 };
 
-InterpreterWrap::InterpreterWrap(const std::string &filename, bool verbose) {
+InterpreterWrap::InterpreterWrap(const std::string &filename, const InterpreterOptions &options, bool verbose)
+    : options(options) {
+    phaseStart = std::chrono::steady_clock::now();
     // Load model
     if (verbose) {
         std::cout << std::setfill('-') << std::setw(40) << "" << std::endl;
         std::cout << "Creating environment..." << std::endl;
     }
-    this->session = loadModel(filename);
+    this->modelFilename = filename;
+    this->session = loadModel(filename, false, verbose);
+    endStartupPhase("load");
     if (verbose) {
         std::cout << "Model loaded successfully." << std::endl;
         std::cout << "File: " << filename << std::endl;
@@ -92,13 +567,18 @@ InterpreterWrap::InterpreterWrap(const std::string &filename, bool verbose) {
     buildAndPrime(verbose);
 }
 
-InterpreterWrap::InterpreterWrap(const char *buffer, size_t bufferSize, bool verbose) {
+InterpreterWrap::InterpreterWrap(const char *buffer, size_t bufferSize, const InterpreterOptions &options, bool verbose)
+    : options(options) {
+    phaseStart = std::chrono::steady_clock::now();
     // Load model
     if (verbose) {
         std::cout << std::setfill('-') << std::setw(40) << "" << std::endl;
         std::cout << "Creating environment..." << std::endl;
     }
-    this->session = loadModelFromBuffer(buffer, bufferSize);
+    this->modelBuffer = buffer;
+    this->modelBufferSize = bufferSize;
+    this->session = loadModelFromBuffer(buffer, bufferSize, false, verbose);
+    endStartupPhase("load");
     if (verbose) {
         std::cout << "Model created from buffer." << std::endl;
     }
@@ -106,23 +586,20 @@ InterpreterWrap::InterpreterWrap(const char *buffer, size_t bufferSize, bool ver
 }
 
 void InterpreterWrap::buildAndPrime(bool verbose) {
-
-    Ort::AllocatorWithDefaultOptions allocator;
-
     size_t numInputNodes = session->GetInputCount();
     size_t numOutputNodes = session->GetOutputCount();
-
-    const char *inputName = session->GetInputName(0, allocator);
-    Ort::TypeInfo inputTypeInfo = session->GetInputTypeInfo(0);
-    auto inputTensorInfo = inputTypeInfo.GetTensorTypeAndShapeInfo();
-    ONNXTensorElementDataType inputType = inputTensorInfo.GetElementType();
-    std::vector<int64_t> inputDims = inputTensorInfo.GetShape();
-
-    const char *outputName = session->GetOutputName(0, allocator);
-    Ort::TypeInfo outputTypeInfo = session->GetOutputTypeInfo(0);
-    auto outputTensorInfo = outputTypeInfo.GetTensorTypeAndShapeInfo();
-    ONNXTensorElementDataType outputType = outputTensorInfo.GetElementType();
-    std::vector<int64_t> outputDims = outputTensorInfo.GetShape();
+    if (numInputNodes == 0 || numOutputNodes == 0)
+        throw std::runtime_error("Error, the model has no input or no output.");
+
+    for (size_t i = 0; i < numInputNodes; ++i)
+        inputs.push_back(describeTensor(session, i, true, options));
+    for (size_t i = 0; i < numOutputNodes; ++i)
+        outputs.push_back(describeTensor(session, i, false, options));
+    for (const auto &spec : options.tensors) {
+        auto hasName = [&spec](const TensorBinding &binding) { return binding.name == spec.name; };
+        if (std::none_of(inputs.begin(), inputs.end(), hasName) && std::none_of(outputs.begin(), outputs.end(), hasName))
+            throw std::invalid_argument("The model has no input or output named '" + spec.name + "' (InterpreterOptions::tensors)");
+    }
 
     if (verbose) {
         std::cout << std::setfill('-') << std::setw(40) << "" << std::endl;
@@ -130,100 +607,254 @@ void InterpreterWrap::buildAndPrime(bool verbose) {
         std::cout << std::endl;
 
         std::cout << std::left << std::setfill('.') << std::setw(30) << "Number of Input Nodes: " << std::right << std::setfill('.') << std::setw(10) << numInputNodes << std::endl;
-        std::cout << std::left << std::setfill('.') << std::setw(30) << "Input Name: " << std::right << std::setfill('.') << std::setw(10) << inputName << std::endl;
-        std::cout << std::left << std::setfill('.') << std::setw(30) << "Input Type: " << std::right << std::setfill('.') << std::setw(10) << inputType << std::endl;
-        std::cout << std::left << std::setfill('.') << std::setw(30) << "Input Dimensions: " << std::right << std::setfill('.') << std::setw(10) << inputDims << std::endl;
+        for (const auto &input : inputs) {
+            std::cout << std::left << std::setfill('.') << std::setw(30) << "Input Name: " << std::right << std::setfill('.') << std::setw(10) << input.name << std::endl;
+            std::cout << std::left << std::setfill('.') << std::setw(30) << "Input Dimensions: " << std::right << std::setfill('.') << std::setw(10) << input.shape << std::endl;
+            std::cout << std::left << std::setfill('.') << std::setw(30) << "Input Type: " << std::right << std::setfill('.') << std::setw(10) << getTypeName(input.type) << std::endl;
+        }
 
         std::cout << std::endl;
 
         std::cout << std::left << std::setfill('.') << std::setw(30) << "Number of Output Nodes: " << std::right << std::setfill('.') << std::setw(10) << numOutputNodes << std::endl;
-        std::cout << std::left << std::setfill('.') << std::setw(30) << "Output Name: " << std::right << std::setfill('.') << std::setw(10) << outputName << std::endl;
-        std::cout << std::left << std::setfill('.') << std::setw(30) << "Output Type: " << std::right << std::setfill('.') << std::setw(10) << outputType << std::endl;
-        std::cout << std::left << std::setfill('.') << std::setw(30) << "Output Dimensions: " << std::right << std::setfill('.') << std::setw(10) << outputDims << std::endl;
+        for (const auto &output : outputs) {
+            std::cout << std::left << std::setfill('.') << std::setw(30) << "Output Name: " << std::right << std::setfill('.') << std::setw(10) << output.name << std::endl;
+            std::cout << std::left << std::setfill('.') << std::setw(30) << "Output Dimensions: " << std::right << std::setfill('.') << std::setw(10) << output.shape << std::endl;
+            std::cout << std::left << std::setfill('.') << std::setw(30) << "Output Type: " << std::right << std::setfill('.') << std::setw(10) << getTypeName(output.type) << std::endl;
+        }
 
         std::cout << std::endl;
 
         std::cout << std::setfill('-') << std::setw(40) << "" << std::endl;
     }
 
-    inputTensorSize = vectorProduct(inputDims);
-    inputTensorValues = std::vector<float>(inputTensorSize);
-
-    outputTensorSize = vectorProduct(outputDims);
-    outputTensorValues = std::vector<float>(outputTensorSize);
-
-    inputNames.push_back(inputName);
-    outputNames.push_back(outputName);
-
+    // Create a tensor over the buffer of every input/output (the bindings are not moved any more)
     Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault);
-    inputTensors.push_back(Ort::Value::CreateTensor<float>(
-        memoryInfo, inputTensorValues.data(), inputTensorSize, inputDims.data(),
-        inputDims.size()));
-    outputTensors.push_back(Ort::Value::CreateTensor<float>(
-        memoryInfo, outputTensorValues.data(), outputTensorSize,
-        outputDims.data(), outputDims.size()));
-
-    // Prime the classifier
-    std::vector<float> pIv(inputTensorSize);
-    std::vector<float> pOv(outputTensorSize);
-
-    this->invoke_internal(&pIv[0], pIv.size(), &pOv[0], pOv.size());
+    for (auto &input : inputs)
+        inputTensors.push_back(Ort::Value::CreateTensor(memoryInfo, input.getTensorData(), input.getTensorBytes(), input.shape.data(), input.shape.size(), input.type));
+    for (auto &output : outputs)
+        outputTensors.push_back(Ort::Value::CreateTensor(memoryInfo, output.getTensorData(), output.getTensorBytes(), output.shape.data(), output.shape.size(), output.type));
+    bindTensors();
+    endStartupPhase("allocate");
+
+    // Prime the classifier (all the input buffers are zero)
+    this->invokeBound();
+    endStartupPhase("prime");
     /*
      * The priming operation should ensure that every allocation performed
      * by the Run method is perfomed here and not in the real-time thread.
      */
 }
 
+void InterpreterWrap::endStartupPhase(const char *name) {
+    const auto now = std::chrono::steady_clock::now();
+    startupPhases.push_back({name, std::chrono::duration<double, std::micro>(now - phaseStart).count()});
+    phaseStart = now;
+}
+
+void InterpreterWrap::bindTensors() {
+    ioBinding.reset(new Ort::IoBinding(*session));
+    for (size_t i = 0; i < inputs.size(); ++i)
+        ioBinding->BindInput(inputs[i].name.c_str(), inputTensors[i]);
+    // Outputs are bound to preallocated tensors, so ONNX Runtime writes the results in place
+    for (size_t i = 0; i < outputs.size(); ++i)
+        ioBinding->BindOutput(outputs[i].name.c_str(), outputTensors[i]);
+}
+
 InterpreterWrap::~InterpreterWrap() {
+    ioBinding.reset();
     delete this->session;
 }
 
 void InterpreterWrap::invoke_internal(const float inputVector[], size_t inputSize, float outputVector[], size_t outputSize, bool verbose) {
-    if (inputSize != inputTensorSize)
-        throw std::logic_error("Error, input vector has to have size: " + std::to_string(inputTensorSize) + " (Found " + std::to_string(inputSize) + " instead)");
+    (void)verbose;
+    if (inputs.size() != 1 || outputs.size() != 1)
+        throw std::logic_error("Error, the model has " + std::to_string(inputs.size()) + " inputs and " + std::to_string(outputs.size()) + " outputs, use the bound buffers and invokeBound");
+    if (inputSize != inputs[0].size)
+        throw std::logic_error("Error, input vector has to have size: " + std::to_string(inputs[0].size) + " (Found " + std::to_string(inputSize) + " instead)");
+    if (outputSize != outputs[0].size)
+        throw std::logic_error("Error, output vector has to have size: " + std::to_string(outputs[0].size) + " (Found " + std::to_string(outputSize) + " instead)");
 
     // Fill `input`.
-    for (size_t i = 0; i < inputSize; ++i)
-        inputTensorValues[i] = inputVector[i];
+    std::memcpy(inputs[0].values.data(), inputVector, inputSize * sizeof(float));
 
     // Run inference
-    this->session->Run(Ort::RunOptions{nullptr}, inputNames.data(), inputTensors.data(), 1, outputNames.data(), outputTensors.data(), 1);
-
-    if (outputSize != outputTensorSize)
-        throw std::logic_error("Error, output vector has to have size: " + std::to_string(outputTensorSize) + " (Found " + std::to_string(outputSize) + " instead)");
+    invokeBound();
 
     // Copy output
-    for (size_t i = 0; i < outputSize; ++i)
-        outputVector[i] = outputTensorValues.at(i);
+    std::memcpy(outputVector, outputs[0].values.data(), outputSize * sizeof(float));
 }
 
-Ort::Session* InterpreterWrap::loadModel(const std::string &filename) {
-    static Ort::Env env;  //()ORT_LOGGING_LEVEL_WARNING, "onnx-test");
-    Ort::SessionOptions session_options;
-    session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-    session_options.SetOptimizedModelFilePath("optimized_model.onnx.tmp");
-    return new Ort::Session(env, filename.c_str(), session_options);
+void InterpreterWrap::invokeBound() {
+    for (auto &input : inputs)
+        input.toTensor();
+    this->session->Run(runOptions, *ioBinding);
+    for (auto &output : outputs)
+        output.fromTensor();
 }
 
+Ort::Session* InterpreterWrap::loadModel(const std::string &filename, bool profiling, bool verbose) {
+    if (!options.optimizedModelCacheDir.empty()) {
+        const std::vector<char> modelBytes = readFile(filename);
+        return loadModelCached(modelBytes.data(), modelBytes.size(), profiling, verbose);
+    }
+    Ort::SessionOptions session_options = createSessionOptions(options, profiling);
+    return new Ort::Session(getEnv(), filename.c_str(), session_options);
+}
 
-Ort::Session* InterpreterWrap::loadModelFromBuffer(const char *buffer, size_t bufferSize) {
-    static Ort::Env env;  //()ORT_LOGGING_LEVEL_WARNING, "onnx-test");
-    Ort::SessionOptions session_options;
-    session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-    session_options.SetOptimizedModelFilePath("/tmp/optimized_model.onnx.tmp");
-    return new Ort::Session(env, buffer, bufferSize, session_options);
+
+Ort::Session* InterpreterWrap::loadModelFromBuffer(const char *buffer, size_t bufferSize, bool profiling, bool verbose) {
+    if (!options.optimizedModelCacheDir.empty())
+        return loadModelCached(buffer, bufferSize, profiling, verbose);
+    Ort::SessionOptions session_options = createSessionOptions(options, profiling);
+    return new Ort::Session(getEnv(), buffer, bufferSize, session_options);
+}
+
+Ort::Session* InterpreterWrap::loadModelCached(const char *buffer, size_t bufferSize, bool profiling, bool verbose) {
+    const std::string cachedFilename = options.optimizedModelCacheDir + "/" + getOptimizedModelName(buffer, bufferSize);
+    if (std::ifstream(cachedFilename).good()) {
+        try {
+            Ort::SessionOptions session_options = createSessionOptions(options, profiling);
+            session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+            session_options.AddConfigEntry(kOrtSessionOptionsConfigLoadModelFormat, "ORT");
+            Ort::Session *cachedSession = new Ort::Session(getEnv(), cachedFilename.c_str(), session_options);
+            if (verbose)
+                std::cout << "Optimized model loaded from the cache: " << cachedFilename << std::endl;
+            return cachedSession;
+        } catch (const Ort::Exception &e) {
+            std::cerr << "WARNING: Ignoring the cached optimized model " << cachedFilename << " (" << e.what() << ")" << std::endl;
+        }
+    }
+
+    // Written under a temporary name and renamed once complete, other processes/threads may load the same model
+    static std::atomic<unsigned> temporaryCount{0};
+    const std::string temporaryFilename = cachedFilename + ".tmp" + std::to_string(getpid()) + "." + std::to_string(temporaryCount++);
+    Ort::SessionOptions session_options = createSessionOptions(options, profiling);
+    session_options.SetOptimizedModelFilePath(temporaryFilename.c_str());
+    session_options.AddConfigEntry(kOrtSessionOptionsConfigSaveModelFormat, "ORT");
+    Ort::Session *optimizedSession = new Ort::Session(getEnv(), buffer, bufferSize, session_options);
+    if (std::rename(temporaryFilename.c_str(), cachedFilename.c_str()) != 0) {
+        std::remove(temporaryFilename.c_str());
+        std::cerr << "WARNING: Could not save the optimized model in the cache: " << cachedFilename << std::endl;
+    } else if (verbose) {
+        std::cout << "Optimized model saved in the cache: " << cachedFilename << std::endl;
+    }
+    return optimizedSession;
+}
+
+void InterpreterWrap::enableProfiling(OpEventSink sink) {
+    if (profiling)
+        disableProfiling();
+
+    // Profiling is a session option, so the session has to be created again.
+    // The input/output tensors do not belong to the session and are kept, the binding is created again.
+    Ort::Session *profiledSession = modelBuffer ? loadModelFromBuffer(modelBuffer, modelBufferSize, true) : loadModel(modelFilename, true);
+    ioBinding.reset();
+    delete this->session;
+    this->session = profiledSession;
+    bindTensors();
+
+    profilingSink = std::move(sink);
+    profiling = true;
+}
+
+void InterpreterWrap::disableProfiling() {
+    if (!profiling)
+        return;
+
+    Ort::AllocatorWithDefaultOptions allocator;
+    char *profileFilename = session->EndProfiling(allocator);
+    const std::string filename(profileFilename);
+    allocator.Free(profileFilename);
+    profiling = false;
+
+    reportProfile(filename);
+    std::remove(filename.c_str());
+    profilingSink = nullptr;
+}
+
+void InterpreterWrap::reportProfile(const std::string &profileFilename) {
+    std::ifstream profileFile(profileFilename);
+    if (!profileFile)
+        throw std::runtime_error("Could not open the ONNX Runtime profile " + profileFilename);
+
+    const std::string kernelSuffix = "_kernel_time";
+    int invocation = 0;
+    std::string line;
+    while (std::getline(profileFile, line)) {
+        const std::string category = getProfileString(line, "cat");
+        const std::string name = getProfileString(line, "name");
+
+        // Each run ends with a "model_run" session event, after the events of its nodes
+        if (category == "Session" && name == "model_run") {
+            ++invocation;
+            continue;
+        }
+        // Nodes also have "_fence_before"/"_fence_after" events, only the kernel time is reported
+        if (category != "Node" || name.size() <= kernelSuffix.size() || name.compare(name.size() - kernelSuffix.size(), kernelSuffix.size(), kernelSuffix) != 0)
+            continue;
+
+        OpEvent event;
+        event.op = getProfileString(line, "op_name");
+        event.node = name.substr(0, name.size() - kernelSuffix.size());
+        event.invocation = invocation;
+        event.durationUs = getProfileNumber(line, "dur");
+        event.inputShapes = getProfileShapes(line, "input_type_shape");
+        if (profilingSink)
+            profilingSink(event);
+    }
 }
 
 /***** Handle functions *****/
 InterpreterPtr createInterpreter(const std::string &filename, bool verbose) {
-    return new InterpreterWrap(filename, verbose);
+    return createInterpreter(filename, InterpreterOptions(), verbose);
+}
+
+InterpreterPtr createInterpreter(const std::string &filename, const InterpreterOptions &options, bool verbose) {
+    return new InterpreterWrap(filename, options, verbose);
 }
 
 InterpreterPtr createInterpreterFromBuffer(const char *buffer, size_t bufferSize, bool verbose) {
-    InterpreterPtr res = new InterpreterWrap(buffer, bufferSize, verbose);
+    return createInterpreterFromBuffer(buffer, bufferSize, InterpreterOptions(), verbose);
+}
+
+InterpreterPtr createInterpreterFromBuffer(const char *buffer, size_t bufferSize, const InterpreterOptions &options, bool verbose) {
+    InterpreterPtr res = new InterpreterWrap(buffer, bufferSize, options, verbose);
     return res;
 }
 
+InterpreterOptions getTuningProfile(const std::string &name, size_t arenaMaxBytes) {
+    InterpreterOptions options;
+    if (name == "default")
+        return options;
+    if (name == "realtime-single-core") {
+        options.intraOpThreads = 1;
+        options.interOpThreads = 1;
+        options.parallelExecution = false;
+        options.allowSpinning = false;
+        options.memoryPattern = true;
+        options.arena = ArenaMode::Exact;
+        options.arenaMaxBytes = arenaMaxBytes;
+        return options;
+    }
+    if (name == "throughput") {
+        options.intraOpThreads = 0;
+        options.interOpThreads = 0;
+        options.parallelExecution = true;
+        options.allowSpinning = true;
+        options.memoryPattern = true;
+        options.arena = ArenaMode::Grow;
+        return options;
+    }
+    std::string names;
+    for (const auto &profileName : getTuningProfileNames())
+        names += (names.empty() ? "" : ", ") + profileName;
+    throw std::invalid_argument("Unknown tuning profile '" + name + "' (available: " + names + ")");
+}
+
+std::vector<std::string> getTuningProfileNames() {
+    return {"default", "realtime-single-core", "throughput"};
+}
+
 void deleteInterpreter(InterpreterPtr cls) {
     if (cls)
         delete cls;
@@ -254,4 +885,67 @@ size_t getModelOutputSize(InterpreterPtr inp) {
     return inp->getOutputTensorSize();
 }
 
+static TensorInfo getTensorInfo(const TensorBinding &binding) {
+    TensorInfo info;
+    info.name = binding.name;
+    info.shape = binding.shape;
+    info.size = binding.size;
+    return info;
+}
+
+static size_t findTensor(const std::vector<TensorBinding> &tensors, const std::string &name, const char *what) {
+    for (size_t i = 0; i < tensors.size(); ++i)
+        if (tensors[i].name == name)
+            return i;
+    throw std::out_of_range(std::string("The model has no ") + what + " named '" + name + "'");
+}
+
+size_t getInputCount(InterpreterPtr inp) {
+    return inp->getInputs().size();
+}
+
+size_t getOutputCount(InterpreterPtr inp) {
+    return inp->getOutputs().size();
+}
+
+TensorInfo getInputInfo(InterpreterPtr inp, size_t index) {
+    return getTensorInfo(inp->getInputs().at(index));
+}
+
+TensorInfo getOutputInfo(InterpreterPtr inp, size_t index) {
+    return getTensorInfo(inp->getOutputs().at(index));
+}
+
+size_t getInputIndex(InterpreterPtr inp, const std::string &name) {
+    return findTensor(inp->getInputs(), name, "input");
+}
+
+size_t getOutputIndex(InterpreterPtr inp, const std::string &name) {
+    return findTensor(inp->getOutputs(), name, "output");
+}
+
+float *getInputBuffer(InterpreterPtr inp, size_t index) {
+    return inp->getInputs().at(index).values.data();
+}
+
+const float *getOutputBuffer(InterpreterPtr inp, size_t index) {
+    return inp->getOutputs().at(index).values.data();
+}
+
+void invokeBound(InterpreterPtr inp) {
+    inp->invokeBound();
+}
+
+void enableProfiling(InterpreterPtr inp, OpEventSink sink) {
+    inp->enableProfiling(std::move(sink));
+}
+
+void disableProfiling(InterpreterPtr inp) {
+    inp->disableProfiling();
+}
+
+std::vector<StartupPhase> getStartupPhases(InterpreterPtr inp) {
+    return inp->getStartupPhases();
+}
+
 }  // namespace InferenceEngine
\ No newline at end of file
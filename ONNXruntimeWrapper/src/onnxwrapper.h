@@ -11,7 +11,9 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
+#include <functional>
 #include <iostream>
 #include <limits>  // std::numeric_limits
 #include <string>
@@ -35,6 +37,75 @@ InterpreterPtr createInterpreter(const std::string& filename, bool verbose = fal
  */
 InterpreterPtr createInterpreterFromBuffer(const char* buffer, size_t bufferSize, bool verbose = false);
 
+/** Allocation strategy of the CPU memory arena of ONNX Runtime */
+enum class ArenaMode {
+    Grow,     // ONNX Runtime default: one arena per session, extended by powers of two
+    Exact,    // One arena shared by the interpreters of the process, extended by exactly the requested size
+    Disabled  // No arena, buffers are allocated with malloc when needed (not real-time safe)
+};
+
+/**
+ * @brief What the model does not say about one of its inputs/outputs
+ * Inputs and outputs can be float, fp16 or int8/uint8 tensors, the API of the wrapper stays float: the other types are
+ * converted by invoke/invokeBound. ONNX models do not store the scale and zero point of quantized inputs/outputs
+ * (they are parameters of the QuantizeLinear/DequantizeLinear nodes), so they have to be given here.
+ */
+struct TensorSpec {
+    std::string name;            // Name of the input/output in the model
+    std::vector<int64_t> shape;  // Replaces the free (dynamic) dimensions of the model, empty to set them to 1
+    float scale = 0.0f;          // int8/uint8 tensors: real = scale * (quantized - zeroPoint)
+    int32_t zeroPoint = 0;
+};
+
+/**
+ * @brief Settings of the ONNX Runtime session, applied when the interpreter is created
+ * The defaults are the ONNX Runtime defaults, getTuningProfile returns tested combinations.
+ */
+struct InterpreterOptions {
+    int intraOpThreads = 0;          // Threads running an operator: 0 one per physical core, 1 only the calling thread (no pool)
+    int interOpThreads = 0;          // Threads running independent nodes with parallelExecution, 0 ONNX Runtime default
+    bool parallelExecution = false;  // Run independent branches of the graph concurrently (ORT_PARALLEL)
+    bool allowSpinning = true;       // Idle pool threads spin instead of sleeping (*)
+    bool memoryPattern = true;       // Plan the intermediate buffers in the first run and reuse the plan
+    ArenaMode arena = ArenaMode::Grow;
+    size_t arenaMaxBytes = 0;        // Limit of the shared arena of ArenaMode::Exact, 0 for none (**)
+    std::string optimizedModelCacheDir;  // Existing directory for the optimized models (***), empty to optimize at every load
+    std::vector<TensorSpec> tensors;     // Shapes and quantization of inputs/outputs, by name (throws if a name is not in the model)
+
+    // (*) ONNX Runtime 1.7 only disables spinning for the global thread pools of the environment, the pools of a
+    //     session always spin. With allowSpinning = false the interpreter runs on global pools without spinning,
+    //     created by the first interpreter (before any other) with its intraOpThreads/interOpThreads; the next ones
+    //     have to use the same counts (throws std::invalid_argument otherwise). With intraOpThreads = 1 and
+    //     sequential execution there is no pool to spin, and the setting has no effect.
+    // (**) The arena is created by the first interpreter that uses it. With a limit, a run that needs more memory
+    //      than the arena holds after priming fails instead of growing it in the real-time thread. ONNX Runtime 1.7
+    //      does not report how much of the arena priming used, so the limit is set by the caller: priming fails
+    //      when it is too low for the model.
+    // (***) The first load optimizes the model and saves it in ORT format as <model hash>-<settings hash>.ort, the
+    //       settings being the ONNX Runtime version, the optimization level and the CPU architecture. The next loads
+    //       of the same model read that file with the optimizations disabled. A cache file that cannot be loaded is
+    //       ignored and written again.
+};
+
+/**
+ * @brief Named InterpreterOptions (throws std::invalid_argument for unknown names)
+ * "default": the ONNX Runtime defaults, as createInterpreter without options.
+ * "realtime-single-core": everything runs in the calling (audio) thread, no pool threads competing with it,
+ *                         memory planned and arena filled by priming, extended by exactly what is needed and
+ *                         limited to arenaMaxBytes (0 for no limit, see InterpreterOptions::arenaMaxBytes).
+ * "throughput": all the cores with spinning threads and parallel branches, for offline evaluation on a
+ *               machine that does nothing else (worst jitter when sharing the cores).
+ * Measure them on the target with: latency-bench <model> --profile <name> (WrapperTools, onnx backend).
+ */
+InterpreterOptions getTuningProfile(const std::string& name, size_t arenaMaxBytes = 0);
+
+/** Names accepted by getTuningProfile */
+std::vector<std::string> getTuningProfileNames();
+
+/** createInterpreter/createInterpreterFromBuffer with explicit session settings */
+InterpreterPtr createInterpreter(const std::string& filename, const InterpreterOptions& options, bool verbose = false);
+InterpreterPtr createInterpreterFromBuffer(const char* buffer, size_t bufferSize, const InterpreterOptions& options, bool verbose = false);
+
 /** Feed a feature array (C Array) to the model, perform inference and return the prediction */
 void invoke(InterpreterPtr cls, const float featureVector[], size_t numFeatures, float outputVector[], size_t numClasses);
 
@@ -89,4 +160,102 @@ size_t getModelInputSize1d(InterpreterPtr inp);
  */
 size_t getModelOutputSize(InterpreterPtr inp);
 
-}  // namespace InferenceEngine
\ No newline at end of file
+/** Name and shape of an input or output tensor of the model */
+struct TensorInfo {
+    std::string name;            // Name of the tensor in the model
+    std::vector<int64_t> shape;  // Dimensions, including the batch dimension
+    size_t size = 0;             // Number of elements
+};
+
+/** Number of input tensors of the model */
+size_t getInputCount(InterpreterPtr inp);
+
+/** Number of output tensors of the model */
+size_t getOutputCount(InterpreterPtr inp);
+
+/** Name and shape of an input (index < getInputCount) */
+TensorInfo getInputInfo(InterpreterPtr inp, size_t index);
+
+/** Name and shape of an output (index < getOutputCount) */
+TensorInfo getOutputInfo(InterpreterPtr inp, size_t index);
+
+/** Index of the input with the given name, throws std::out_of_range if there is none (do not use in real time threads) */
+size_t getInputIndex(InterpreterPtr inp, const std::string& name);
+
+/** Index of the output with the given name, throws std::out_of_range if there is none (do not use in real time threads) */
+size_t getOutputIndex(InterpreterPtr inp, const std::string& name);
+
+/**
+ * @brief Bound buffers, for models with several inputs and/or outputs
+ * Every input and output has a preallocated float buffer of getInputInfo(inp, i).size / getOutputInfo(inp, i).size
+ * elements, valid until deleteInterpreter. The buffers are looked up once, then every frame the inputs are written
+ * in place, invokeBound runs the model and the outputs are read in place:
+ *
+ *     float* spectrogram = getInputBuffer(inp, getInputIndex(inp, "spectrogram"));
+ *     float* descriptors = getInputBuffer(inp, getInputIndex(inp, "descriptors"));
+ *     const float* classes = getOutputBuffer(inp, getOutputIndex(inp, "classes"));
+ *     ...
+ *     // Real-time thread
+ *     computeSpectrogram(spectrogram);
+ *     computeDescriptors(descriptors);
+ *     invokeBound(inp);
+ *
+ * The sizes are checked when the interpreter is created, invokeBound does no check.
+ */
+float* getInputBuffer(InterpreterPtr inp, size_t index);
+const float* getOutputBuffer(InterpreterPtr inp, size_t index);
+
+/** Run the model on the values of the bound input buffers, the results are in the bound output buffers */
+void invokeBound(InterpreterPtr inp);
+
+/**
+ * @brief One operator execution, as reported by the native profiler of the runtime
+ * The same structure is used by all the wrappers, so that per-operator profiles can be compared.
+ */
+struct OpEvent {
+    std::string op;                                 // Operator type (e.g. "Conv")
+    std::string node;                               // Name of the node in the graph (empty if not reported by the runtime)
+    int invocation = 0;                             // Index of the invoke call since enableProfiling
+    double durationUs = 0.0;                        // Execution time in microseconds
+    std::vector<std::vector<int64_t>> inputShapes;  // Shape of every input tensor of the operator
+};
+
+/** Callback that receives the operator events */
+using OpEventSink = std::function<void(const OpEvent&)>;
+
+/**
+ * @brief Enable the ONNX Runtime profiler (do not use in real time threads)
+ * The inference session is recreated with profiling enabled, so the first invocations after this call are not primed.
+ * Interpreters created from a buffer need the buffer to still be valid.
+ * ONNX Runtime writes the events to a trace file that is only complete when profiling ends, so
+ * the events of all invocations are passed to the sink by disableProfiling.
+ *
+ * @param inp  Interpreter object
+ * @param sink Callback for the operator events
+ */
+void enableProfiling(InterpreterPtr inp, OpEventSink sink);
+
+/**
+ * @brief Stop the profiler and pass the recorded operator events to the sink, in execution order (do not use in real time threads)
+ *
+ * @param inp Interpreter object
+ */
+void disableProfiling(InterpreterPtr inp);
+
+/** Duration of one phase of the creation of an interpreter */
+struct StartupPhase {
+    std::string name;         // "load", "allocate" or "prime"
+    double durationUs = 0.0;  // Wall time in microseconds
+};
+
+/**
+ * @brief Get the time spent in each phase of createInterpreter/createInterpreterFromBuffer
+ * load: creation of the Ort::Session, which parses the model, applies the graph optimizations and creates the kernels
+ * (ONNX Runtime does not expose these steps separately), allocate: input/output names and tensors, prime: the first Run.
+ *
+ * @param inp Interpreter object
+ * @return The phases, in execution order
+ */
+std::vector<StartupPhase> getStartupPhases(InterpreterPtr inp);
+
+}  // namespace InferenceEngine
@@ -2,6 +2,9 @@ option(RTNEURAL_EIGEN "Use Eigen library for vector operations" OFF)
 option(RTNEURAL_XSIMD "Use xsimd library for vector operations" OFF)
 option(RTNEURAL_ACCELERATE "Use Accelerate library for vector operations (Apple only)" OFF)
 option(RTNEURAL_STL "Use STL for all operations" OFF)
+if(RTNEURAL_RUNTIME_DISPATCH AND (RTNEURAL_EIGEN OR RTNEURAL_XSIMD OR RTNEURAL_ACCELERATE))
+    message(FATAL_ERROR "RTNeural -- Runtime dispatch is only supported by the STL backend!")
+endif()
 if(RTNEURAL_EIGEN)
     message(STATUS "RTNeural -- Using Eigen backend")
     target_compile_definitions(RTNeural PUBLIC RTNEURAL_USE_EIGEN=1)
@@ -17,7 +20,7 @@ elseif(RTNEURAL_ACCELERATE)
     message(STATUS "RTNeural -- Using Accelerate backend")
     target_compile_definitions(RTNeural PUBLIC RTNEURAL_USE_ACCELERATE=1)
     target_link_libraries(RTNeural PUBLIC "-framework Accelerate")
-elseif(RTNEURAL_STL)
+elseif(RTNEURAL_STL OR RTNEURAL_RUNTIME_DISPATCH)
     message(STATUS "RTNeural -- Using STL backend")
 else()
     message(STATUS "RTNeural -- Using Eigen backend (Default)")
@@ -0,0 +1,32 @@
+# rtneural_add_microbench(<backend> <definitions> [<include-dirs>...])
+#
+# Builds src/bench/microbench.cpp together with its own copy of the RTNeural
+# sources for one backend, so that all the backends can be compared from a
+# single build tree (the RTNeural target itself only has one backend)
+function(rtneural_add_microbench backend definitions)
+    set(target rtneural_microbench_${backend})
+    add_executable(${target}
+                   ${CMAKE_CURRENT_SOURCE_DIR}/src/bench/microbench.cpp
+                   ${CMAKE_CURRENT_SOURCE_DIR}/libs/RTNeural/RTNeural.cpp)
+    target_include_directories(${target} PRIVATE
+                               ${CMAKE_CURRENT_SOURCE_DIR}/libs/RTNeural
+                               ${CMAKE_CURRENT_SOURCE_DIR}/libs/modules/json
+                               ${ARGN})
+    target_compile_definitions(${target} PRIVATE ${definitions})
+    # Same instruction set and alignment as the RTNeural library
+    target_compile_options(${target} PRIVATE $<TARGET_PROPERTY:RTNeural,INTERFACE_COMPILE_OPTIONS>)
+    if(RTNEURAL_USE_AVX2 AND NOT MSVC AND COMPILER_OPT_ARCH_NATIVE_SUPPORTED)
+        target_compile_definitions(${target} PRIVATE RTNEURAL_DEFAULT_ALIGNMENT=32)
+    else()
+        target_compile_definitions(${target} PRIVATE RTNEURAL_DEFAULT_ALIGNMENT=16)
+    endif()
+endfunction()
+
+message(STATUS "RTNeural -- Building microbenchmarks")
+rtneural_add_microbench(eigen RTNEURAL_USE_EIGEN=1 ${CMAKE_CURRENT_SOURCE_DIR}/libs/modules/Eigen)
+rtneural_add_microbench(stl "")
+if(EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/libs/modules/xsimd/include)
+    rtneural_add_microbench(xsimd RTNEURAL_USE_XSIMD=1 ${CMAKE_CURRENT_SOURCE_DIR}/libs/modules/xsimd/include)
+else()
+    message(STATUS "RTNeural -- xsimd not found in libs/modules/xsimd, skipping its microbenchmark")
+endif()
@@ -1,5 +1,45 @@
 option(RTNEURAL_USE_AVX2 "Enables AVX2 SIMD Support" OFF)
-if(NOT RTNEURAL_USE_AVX2)
+option(RTNEURAL_RUNTIME_DISPATCH "Compiles the STL kernels for several instruction sets and selects them at runtime" OFF)
+
+# rtneural_add_dispatch_kernels(<isa> [<compile-options>...])
+#
+# Compiles libs/RTNeural/dispatch/kernels_<isa>.cpp with its own target flags
+# and adds the resulting object to RTNeural
+function(rtneural_add_dispatch_kernels isa)
+    add_library(rtneural_kernels_${isa} OBJECT libs/RTNeural/dispatch/kernels_${isa}.cpp)
+    set_property(TARGET rtneural_kernels_${isa} PROPERTY POSITION_INDEPENDENT_CODE ON)
+    if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+        target_compile_options(rtneural_kernels_${isa} PRIVATE -fopenmp-simd ${ARGN})
+    endif()
+    if(RTNEURAL_DISPATCH_X86)
+        target_compile_definitions(rtneural_kernels_${isa} PRIVATE RTNEURAL_DISPATCH_X86=1)
+    endif()
+    target_sources(RTNeural PRIVATE $<TARGET_OBJECTS:rtneural_kernels_${isa}>)
+endfunction()
+
+if(RTNEURAL_RUNTIME_DISPATCH)
+    if(RTNEURAL_USE_AVX2)
+        message(FATAL_ERROR "RTNeural -- RTNEURAL_RUNTIME_DISPATCH and RTNEURAL_USE_AVX2 are mutually exclusive!")
+    endif()
+
+    message(STATUS "RTNeural -- Enabling runtime CPU feature dispatch")
+    target_compile_definitions(RTNeural PUBLIC RTNEURAL_RUNTIME_DISPATCH=1)
+    target_compile_definitions(RTNeural PUBLIC RTNEURAL_DEFAULT_ALIGNMENT=16)
+
+    # Each ISA gets its own translation unit, the baseline build flags are left untouched
+    if(CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64|amd64|i.86" AND CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+        message(STATUS "RTNeural -- Runtime dispatch kernels: generic, SSE4.2, AVX2, AVX-512")
+        set(RTNEURAL_DISPATCH_X86 ON)
+        target_compile_definitions(RTNeural PUBLIC RTNEURAL_DISPATCH_X86=1)
+        rtneural_add_dispatch_kernels(generic)
+        rtneural_add_dispatch_kernels(sse42 -msse4.2)
+        rtneural_add_dispatch_kernels(avx2 -mavx2 -mfma)
+        rtneural_add_dispatch_kernels(avx512 -mavx512f -mavx2 -mfma -mprefer-vector-width=512)
+    else()
+        message(STATUS "RTNeural -- Runtime dispatch kernels: generic only on ${CMAKE_SYSTEM_PROCESSOR}")
+        rtneural_add_dispatch_kernels(generic)
+    endif()
+elseif(NOT RTNEURAL_USE_AVX2)
     target_compile_definitions(RTNeural PUBLIC RTNEURAL_DEFAULT_ALIGNMENT=16)
 else()
     message(STATUS "RTNeural -- Attempting to enable AVX2...")
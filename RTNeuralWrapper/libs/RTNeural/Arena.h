@@ -0,0 +1,165 @@
+#ifndef ARENA_H_INCLUDED
+#define ARENA_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace RTNeural
+{
+
+/**
+ * A single aligned block of memory, handed out with a bump allocator.
+ *
+ * `Model::planMemory()` uses one arena to place the weights of all
+ * layers and the activation buffers of the model contiguously. On Linux
+ * the arena can optionally be backed by huge pages, which keeps a large
+ * model inside a handful of TLB entries.
+ */
+class AlignedArena
+{
+public:
+    /** Alignment of every allocation made from the arena (one cache line). */
+    static constexpr size_t alignment = 64;
+
+    /** Size of the huge pages requested when huge page backing is enabled. */
+    static constexpr size_t hugePageSize = (size_t)2 << 20;
+
+    /** Rounds a number of bytes up to the arena alignment. */
+    static constexpr size_t alignUp(size_t numBytes) noexcept
+    {
+        return (numBytes + alignment - 1) & ~(alignment - 1);
+    }
+
+    /** Constructs an empty arena. */
+    AlignedArena() = default;
+
+    /**
+     * Constructs a zero-initialised arena of at least numBytes bytes.
+     * If useHugePages is set, the arena is backed by huge pages when the
+     * system allows it (MAP_HUGETLB, then transparent huge pages), and by
+     * regular pages otherwise.
+     */
+    AlignedArena(size_t numBytes, bool useHugePages = false)
+    {
+        capacity = alignUp(numBytes);
+        if(capacity == 0)
+            return;
+
+#if defined(__linux__)
+        if(useHugePages)
+        {
+            const auto mapSize = (capacity + hugePageSize - 1) & ~(hugePageSize - 1);
+            void* ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+            ptr = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            hugePages = ptr != MAP_FAILED;
+#endif
+            if(ptr == MAP_FAILED)
+            {
+                ptr = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+                if(ptr != MAP_FAILED)
+                    hugePages = madvise(ptr, mapSize, MADV_HUGEPAGE) == 0;
+#endif
+            }
+
+            if(ptr != MAP_FAILED)
+            {
+                base = ptr;
+                data = static_cast<char*>(ptr);
+                mappedSize = mapSize;
+                return;
+            }
+        }
+#endif
+
+        base = std::calloc(capacity + alignment, 1);
+        if(base == nullptr)
+            throw std::bad_alloc();
+
+        const auto address = reinterpret_cast<uintptr_t>(base);
+        data = reinterpret_cast<char*>((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+
+    AlignedArena(const AlignedArena&) = delete;
+    AlignedArena& operator=(const AlignedArena&) = delete;
+
+    AlignedArena(AlignedArena&& other) noexcept { swap(other); }
+
+    AlignedArena& operator=(AlignedArena&& other) noexcept
+    {
+        AlignedArena(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~AlignedArena() { release(); }
+
+    /**
+     * Returns an aligned block of count values from the arena,
+     * or nullptr if the arena is too small.
+     */
+    template <typename T>
+    T* allocate(size_t count) noexcept
+    {
+        const auto numBytes = alignUp(count * sizeof(T));
+        if(used + numBytes > capacity)
+            return nullptr;
+
+        auto* ptr = reinterpret_cast<T*>(data + used);
+        used += numBytes;
+        return ptr;
+    }
+
+    /** Returns the number of bytes reserved for this arena. */
+    size_t size() const noexcept { return capacity; }
+
+    /** Returns the number of bytes that have been allocated from this arena. */
+    size_t bytesUsed() const noexcept { return used; }
+
+    /** Returns true if the arena memory is backed by huge pages. */
+    bool isHugePageBacked() const noexcept { return hugePages; }
+
+private:
+    void swap(AlignedArena& other) noexcept
+    {
+        std::swap(base, other.base);
+        std::swap(data, other.data);
+        std::swap(capacity, other.capacity);
+        std::swap(used, other.used);
+        std::swap(mappedSize, other.mappedSize);
+        std::swap(hugePages, other.hugePages);
+    }
+
+    void release() noexcept
+    {
+#if defined(__linux__)
+        if(mappedSize > 0)
+            munmap(base, mappedSize);
+        else
+#endif
+            std::free(base);
+
+        base = nullptr;
+        data = nullptr;
+        capacity = used = mappedSize = 0;
+        hugePages = false;
+    }
+
+    void* base = nullptr;
+    char* data = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t mappedSize = 0;
+    bool hugePages = false;
+};
+
+} // namespace RTNeural
+
+#endif // ARENA_H_INCLUDED
@@ -0,0 +1,223 @@
+#ifndef EXECUTIONPLAN_H_INCLUDED
+#define EXECUTIONPLAN_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "Layer.h"
+#include "activation/activation.h"
+#include "dense/dense.h"
+
+#if RTNEURAL_ENABLE_PROFILING
+#include "Profiler.h"
+#include "conv1d/conv1d.h"
+#include "conv2d/conv2d.h"
+#include "conv2d/streaming_conv2d.h"
+#endif
+
+#if RTNEURAL_USE_EIGEN || !(RTNEURAL_USE_XSIMD || RTNEURAL_USE_ACCELERATE)
+#define RTNEURAL_PLAN_FIXED_DENSE 1
+#endif
+
+namespace RTNeural
+{
+
+/**
+ * A flat list of operations compiled from the layers of a dynamic `Model`.
+ *
+ * Layers whose concrete type is known (dense and the element-wise
+ * activations) are run through a switch with qualified, non-virtual
+ * calls, so their forward methods can be inlined into the loop. Dense
+ * layers with an input width of 8, 16, 32, 64 or 128 use a kernel
+ * specialized for that width. All other layers go through the virtual
+ * `Layer::forward()`.
+ *
+ * The plan stores the buffer pointers of every operation, so it must be
+ * recompiled whenever the model moves its activation buffers.
+ *
+ * With RTNEURAL_ENABLE_PROFILING, every operation is timed by the profiler
+ * of the plan.
+ */
+template <typename T>
+class ExecutionPlan
+{
+public:
+    /** Operation codes of the plan. */
+    enum class OpCode : uint8_t
+    {
+        Virtual,
+        Dense,
+        Dense8,
+        Dense16,
+        Dense32,
+        Dense64,
+        Dense128,
+        Tanh,
+        FastTanh,
+        ReLu,
+        Sigmoid,
+        Softmax,
+    };
+
+    /** A single step of the plan. */
+    struct Op
+    {
+        OpCode code;
+        Layer<T>* layer;
+        const T* in;
+        T* out;
+    };
+
+    /**
+     * Compiles the plan for a list of layers. Layer i reads the output of
+     * layer i - 1 and writes to outs[i % 2]; the first layer reads the model input.
+     */
+    void compile(const std::vector<Layer<T>*>& layers, T* const (&outs)[2])
+    {
+        ops.clear();
+        ops.reserve(layers.size());
+
+        for(size_t i = 0; i < layers.size(); ++i)
+        {
+            const T* in = i == 0 ? nullptr : outs[(i - 1) & 1];
+            ops.push_back({ getOpCode(layers[i]), layers[i], in, outs[i & 1] });
+        }
+
+#if RTNEURAL_ENABLE_PROFILING
+        profiler.clear();
+        for(auto* l : layers)
+        {
+            const Conv2DShape* shape = nullptr;
+            if(const auto* conv2d = dynamic_cast<const Conv2D<T>*>(l))
+                shape = &conv2d->getShape();
+            else if(const auto* streamingConv2d = dynamic_cast<const StreamingConv2D<T>*>(l))
+                shape = &streamingConv2d->getShape();
+
+            if(shape != nullptr)
+            {
+                profiler.template addLayer<T>(l->getName(), l->in_size, l->out_size, shape->numWeights(), shape->flopsPerCall());
+                continue;
+            }
+
+            const auto* conv = dynamic_cast<const Conv1D<T>*>(l);
+            profiler.template addLayer<T>(l->getName(), l->in_size, l->out_size, conv != nullptr ? conv->getKernelSize() : 1);
+        }
+#endif
+    }
+
+    /** Returns the compiled operations. */
+    const std::vector<Op>& getOps() const noexcept { return ops; }
+
+    /** Runs the plan on an input. */
+    inline void run(const T* input) noexcept
+    {
+        if(ops.empty())
+            return;
+
+        ops[0].in = input;
+        for(size_t i = 0; i < ops.size(); ++i)
+        {
+            const auto& op = ops[i];
+#if RTNEURAL_ENABLE_PROFILING
+            profiler.begin();
+#endif
+            switch(op.code)
+            {
+            case OpCode::Dense:
+                static_cast<Dense<T>*>(op.layer)->Dense<T>::forward(op.in, op.out);
+                break;
+#if RTNEURAL_PLAN_FIXED_DENSE
+            case OpCode::Dense8:
+                static_cast<Dense<T>*>(op.layer)->template forwardN<8>(op.in, op.out);
+                break;
+            case OpCode::Dense16:
+                static_cast<Dense<T>*>(op.layer)->template forwardN<16>(op.in, op.out);
+                break;
+            case OpCode::Dense32:
+                static_cast<Dense<T>*>(op.layer)->template forwardN<32>(op.in, op.out);
+                break;
+            case OpCode::Dense64:
+                static_cast<Dense<T>*>(op.layer)->template forwardN<64>(op.in, op.out);
+                break;
+            case OpCode::Dense128:
+                static_cast<Dense<T>*>(op.layer)->template forwardN<128>(op.in, op.out);
+                break;
+#endif
+            case OpCode::Tanh:
+                static_cast<TanhActivation<T>*>(op.layer)->TanhActivation<T>::forward(op.in, op.out);
+                break;
+#if !RTNEURAL_USE_ACCELERATE
+            case OpCode::FastTanh:
+                static_cast<FastTanh<T>*>(op.layer)->FastTanh<T>::forward(op.in, op.out);
+                break;
+#endif
+            case OpCode::ReLu:
+                static_cast<ReLuActivation<T>*>(op.layer)->ReLuActivation<T>::forward(op.in, op.out);
+                break;
+            case OpCode::Sigmoid:
+                static_cast<SigmoidActivation<T>*>(op.layer)->SigmoidActivation<T>::forward(op.in, op.out);
+                break;
+            case OpCode::Softmax:
+                static_cast<SoftmaxActivation<T>*>(op.layer)->SoftmaxActivation<T>::forward(op.in, op.out);
+                break;
+            default:
+                op.layer->forward(op.in, op.out);
+                break;
+            }
+#if RTNEURAL_ENABLE_PROFILING
+            profiler.end(i);
+#endif
+        }
+    }
+
+#if RTNEURAL_ENABLE_PROFILING
+    /** Returns the per-layer profiler of the plan. */
+    profiling::Profiler& getProfiler() noexcept { return profiler; }
+#endif
+
+private:
+    /** Finds the most specialized operation that can run a layer. */
+    static OpCode getOpCode(Layer<T>* layer)
+    {
+        if(dynamic_cast<Dense<T>*>(layer) != nullptr)
+        {
+#if RTNEURAL_PLAN_FIXED_DENSE
+            switch(layer->in_size)
+            {
+            case 8: return OpCode::Dense8;
+            case 16: return OpCode::Dense16;
+            case 32: return OpCode::Dense32;
+            case 64: return OpCode::Dense64;
+            case 128: return OpCode::Dense128;
+            default: break;
+            }
+#endif
+            return OpCode::Dense;
+        }
+
+        if(dynamic_cast<TanhActivation<T>*>(layer) != nullptr)
+            return OpCode::Tanh;
+#if !RTNEURAL_USE_ACCELERATE
+        if(dynamic_cast<FastTanh<T>*>(layer) != nullptr)
+            return OpCode::FastTanh;
+#endif
+        if(dynamic_cast<ReLuActivation<T>*>(layer) != nullptr)
+            return OpCode::ReLu;
+        if(dynamic_cast<SigmoidActivation<T>*>(layer) != nullptr)
+            return OpCode::Sigmoid;
+        if(dynamic_cast<SoftmaxActivation<T>*>(layer) != nullptr)
+            return OpCode::Softmax;
+
+        return OpCode::Virtual;
+    }
+
+    std::vector<Op> ops;
+
+#if RTNEURAL_ENABLE_PROFILING
+    profiling::Profiler profiler;
+#endif
+};
+
+} // namespace RTNeural
+
+#endif // EXECUTIONPLAN_H_INCLUDED
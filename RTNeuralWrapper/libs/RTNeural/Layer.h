@@ -39,6 +39,18 @@ public:
     /** Implements the forward propagation step for this layer. */
     virtual void forward(const T* input, T* out) = 0;
 
+    /**
+     * Returns the number of values this layer would like to place in the
+     * weights arena of the model, or zero if the layer keeps its own storage.
+     */
+    virtual size_t getArenaSize() const noexcept { return 0; }
+
+    /**
+     * Moves the parameters of this layer into a block of `getArenaSize()`
+     * values owned by the model. The block is aligned to `AlignedArena::alignment`.
+     */
+    virtual void bindArena(T* /*block*/) { }
+
     const int in_size;
     const int out_size;
 };
@@ -1,13 +1,19 @@
 #ifndef MODEL_H_INCLUDED
 #define MODEL_H_INCLUDED
 
+#include <algorithm>
 #include <iostream>
+#include <string>
 #include <vector>
 
+#include "Arena.h"
+#include "ExecutionPlan.h"
 #include "Layer.h"
 #include "activation/activation.h"
 #include "conv1d/conv1d.h"
 #include "conv1d/conv1d.tpp"
+#include "conv2d/conv2d.h"
+#include "conv2d/streaming_conv2d.h"
 #include "dense/dense.h"
 #include "gru/gru.h"
 #include "gru/gru.tpp"
@@ -17,11 +23,23 @@
 namespace RTNeural
 {
 
+/** Options of `Model::planMemory()`, which json_parser passes on when it creates a model. */
+struct MemoryPlanOptions
+{
+    bool useHugePages = false; // back the arena with huge pages when the platform supports them
+};
+
 /** 
  *  A dynamic sequential neural network model.
  *  
  *  Instances of this class should typically be created
  *  `json_parser::parseJson`.
+ *
+ *  Intermediate activations alternate between two buffers sized to the
+ *  widest layer. Once all layers have been added, `planMemory()` moves
+ *  the layer weights and those two buffers into a single aligned arena.
+ *  The layers are run through an `ExecutionPlan`, which avoids virtual
+ *  calls for the common layer types.
  */
 template <typename T>
 class Model
@@ -39,8 +57,6 @@ public:
         for(auto l : layers)
             delete l;
         layers.clear();
-
-        outs.clear();
     }
 
     /** Returns the required input size for the next layer being added to the network. */
@@ -56,7 +72,71 @@ public:
     void addLayer(Layer<T>* layer)
     {
         layers.push_back(layer);
-        outs.push_back(vec_type(layer->out_size, (T)0));
+
+        maxWidth = std::max(maxWidth, layer->out_size);
+        for(auto& buffer : pingPong)
+            buffer.resize(maxWidth, (T)0);
+
+        outs[0] = pingPong[0].data();
+        outs[1] = pingPong[1].data();
+        plan.compile(layers, outs);
+    }
+
+    /**
+     * Places the weights and state of all layers and the two activation buffers
+     * contiguously in one aligned arena, optionally backed by huge pages.
+     * Layers without arena support keep their own storage, see `getLayersOutsideArena()`.
+     *
+     * This allocates memory, so it must be called after the last layer has
+     * been added and before the model is used on the real-time thread.
+     */
+    void planMemory(bool useHugePages = false)
+    {
+        size_t numBytes = 2 * AlignedArena::alignUp(sizeof(T) * (size_t)maxWidth);
+        for(auto* l : layers)
+            numBytes += AlignedArena::alignUp(sizeof(T) * l->getArenaSize());
+
+        AlignedArena newArena(numBytes, useHugePages);
+        for(auto* l : layers)
+        {
+            if(l->getArenaSize() > 0)
+                l->bindArena(newArena.template allocate<T>(l->getArenaSize()));
+        }
+
+        outs[0] = newArena.template allocate<T>((size_t)maxWidth);
+        outs[1] = newArena.template allocate<T>((size_t)maxWidth);
+
+        arena = std::move(newArena);
+        for(auto& buffer : pingPong)
+            vec_type().swap(buffer);
+
+        plan.compile(layers, outs);
+    }
+
+    /** Places the model memory in one arena, see `planMemory(bool)`. */
+    void planMemory(const MemoryPlanOptions& options)
+    {
+        planMemory(options.useHugePages);
+    }
+
+    /** Returns the arena holding the model memory (empty until `planMemory()` is called). */
+    const AlignedArena& getArena() const noexcept { return arena; }
+
+    /**
+     * Returns the names of the layers that keep their parameters in their
+     * own storage instead of the arena, e.g. the layers of the xsimd and
+     * Accelerate backends. Activation layers hold no parameters and are not listed.
+     */
+    std::vector<std::string> getLayersOutsideArena() const
+    {
+        std::vector<std::string> names;
+        for(const auto* l : layers)
+        {
+            if(l->getArenaSize() == 0 && dynamic_cast<const Activation<T>*>(l) == nullptr)
+                names.push_back(l->getName());
+        }
+
+        return names;
     }
 
     /** Resets the state of the network layers. */
@@ -69,20 +149,19 @@ public:
     /** Performs forward propagation for this model. */
     inline T forward(const T* input)
     {
-        layers[0]->forward(input, outs[0].data());
-
-        for(int i = 1; i < (int)layers.size(); ++i)
-        {
-            layers[i]->forward(outs[i - 1].data(), outs[i].data());
-        }
-
-        return outs.back()[0];
+        plan.run(input);
+        return getOutputs()[0];
     }
 
+#if RTNEURAL_ENABLE_PROFILING
+    /** Returns the per-layer profiler, which times every call to `forward()`. */
+    profiling::Profiler& getProfiler() noexcept { return plan.getProfiler(); }
+#endif
+
     /** Returns a pointer to the output of the final layer in the network. */
     inline const T* getOutputs() const noexcept
     {
-        return outs.back().data();
+        return outs[(layers.size() - 1) & 1];
     }
 
     /** A vector storing the network layers in sequential order. */
@@ -98,7 +177,12 @@ private:
 #endif
 
     const int in_size;
-    std::vector<vec_type> outs;
+    int maxWidth = 0;
+
+    vec_type pingPong[2]; // activation buffers used until planMemory() is called
+    T* outs[2] = { nullptr, nullptr };
+    AlignedArena arena;
+    ExecutionPlan<T> plan;
 };
 
 } // namespace RTNeural
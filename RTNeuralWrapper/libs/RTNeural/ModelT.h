@@ -2,6 +2,10 @@
 
 #include "model_loader.h"
 
+#if RTNEURAL_ENABLE_PROFILING
+#include "Profiler.h"
+#endif
+
 #define MODELT_AVAILABLE (!RTNEURAL_USE_ACCELERATE)
 
 #if MODELT_AVAILABLE
@@ -75,6 +79,58 @@ namespace modelt_detail
         static void call(T&) { }
     };
 
+#if RTNEURAL_ENABLE_PROFILING
+    // unrolled loop for forward inferencing, timing each layer
+    template <size_t idx, size_t Niter>
+    struct forward_unroll_profiled
+    {
+        template <typename T>
+        static void call(T& t, profiling::Profiler& profiler)
+        {
+            profiler.begin();
+            std::get<idx>(t).forward(std::get<idx - 1>(t).outs);
+            profiler.end(idx);
+
+            forward_unroll_profiled<idx + 1, Niter - 1>::call(t, profiler);
+        }
+    };
+
+    template <size_t idx>
+    struct forward_unroll_profiled<idx, 0>
+    {
+        template <typename T>
+        static void call(T&, profiling::Profiler&) { }
+    };
+
+    /** Returns the kernel size of convolutional layers, and 1 for other layers. */
+    template <typename LayerType>
+    auto kernelSizeOf(const LayerType& layer, int) -> decltype(layer.getKernelSize())
+    {
+        return layer.getKernelSize();
+    }
+
+    template <typename LayerType>
+    int kernelSizeOf(const LayerType&, long)
+    {
+        return 1;
+    }
+
+    /** Adds a layer to the profiler, with the exact cost of layers that know their shape (2D convolutions). */
+    template <typename T, typename LayerType>
+    auto addProfiledLayer(profiling::Profiler& profiler, const LayerType& layer, int)
+        -> decltype(layer.getShape().flopsPerCall(), void())
+    {
+        const auto shape = layer.getShape();
+        profiler.template addLayer<T>(layer.getName(), layer.in_size, layer.out_size, shape.numWeights(), shape.flopsPerCall());
+    }
+
+    template <typename T, typename LayerType>
+    void addProfiledLayer(profiling::Profiler& profiler, const LayerType& layer, long)
+    {
+        profiler.template addLayer<T>(layer.getName(), layer.in_size, layer.out_size, kernelSizeOf(layer, 0));
+    }
+#endif
+
     template <typename T, typename LayerType>
     void loadLayer(LayerType&, int&, const nlohmann::json&, const std::string&, int, bool debug)
     {
@@ -133,6 +189,36 @@ namespace modelt_detail
         }
     }
 
+    template <typename T, int num_filters_in, int num_filters_out, int in_rows, int in_cols, int kernel_rows, int kernel_cols,
+        int stride_rows, int stride_cols, int dilation_rows, int dilation_cols, bool valid_pad>
+    void loadLayer(Conv2DT<T, num_filters_in, num_filters_out, in_rows, in_cols, kernel_rows, kernel_cols,
+                       stride_rows, stride_cols, dilation_rows, dilation_cols, valid_pad>& conv,
+        int& json_stream_idx, const nlohmann::json& l, const std::string& type, int layerDims, bool debug)
+    {
+        using namespace json_parser;
+
+        debug_print("Layer: " + type, debug);
+        debug_print("  Dims: " + std::to_string(layerDims), debug);
+        const auto weights = l["weights"];
+
+        // the convolution parameters can only be read from conv2d layers
+        if(type != "conv2d")
+            debug_print("Wrong layer type! Expected: Conv2D", debug);
+        else if(checkConv2D<T>(conv, type, getConv2DShape(l, in_rows, in_cols, num_filters_in), debug))
+            loadConv2D<T>(conv, weights);
+
+        if(!l.contains("activation"))
+        {
+            json_stream_idx++;
+        }
+        else
+        {
+            const auto activationType = l["activation"].get<std::string>();
+            if(activationType.empty())
+                json_stream_idx++;
+        }
+    }
+
     template <typename T, int in_size, int out_size>
     void loadLayer(GRULayerT<T, in_size, out_size>& gru, int& json_stream_idx, const nlohmann::json& l,
         const std::string& type, int layerDims, bool debug)
@@ -193,6 +279,13 @@ public:
         auto& layer_outs = get<n_layers - 1>().outs;
         new(&layer_outs) Eigen::Map<Eigen::Matrix<T, out_size, 1>, Eigen::Aligned16>(outs);
 #endif
+
+#if RTNEURAL_ENABLE_PROFILING
+        modelt_detail::forEachInTuple([&](auto& layer, size_t) {
+            modelt_detail::addProfiledLayer<T>(profiler, layer, 0);
+        },
+            layers);
+#endif
     }
 
     /** Get a reference to the layer at index `Index`. */
@@ -209,6 +302,11 @@ public:
         return std::get<Index>(layers);
     }
 
+#if RTNEURAL_ENABLE_PROFILING
+    /** Returns the per-layer profiler, which times every call to `forward()`. */
+    profiling::Profiler& getProfiler() noexcept { return profiler; }
+#endif
+
     /** Resets the state of the network layers. */
     void reset()
     {
@@ -228,8 +326,15 @@ public:
 #else // RTNEURAL_USE_STL
         std::copy(input, input + in_size, v_ins);
 #endif
+#if RTNEURAL_ENABLE_PROFILING
+        profiler.begin();
+        std::get<0>(layers).forward(v_ins);
+        profiler.end(0);
+        modelt_detail::forward_unroll_profiled<1, n_layers - 1>::call(layers, profiler);
+#else
         std::get<0>(layers).forward(v_ins);
         modelt_detail::forward_unroll<1, n_layers - 1>::call(layers);
+#endif
 
 #if RTNEURAL_USE_XSIMD
         for(int i = 0; i < v_out_size; ++i)
@@ -255,8 +360,15 @@ public:
         v_ins[0] = input[0];
 #endif
 
+#if RTNEURAL_ENABLE_PROFILING
+        profiler.begin();
+        std::get<0>(layers).forward(v_ins);
+        profiler.end(0);
+        modelt_detail::forward_unroll_profiled<1, n_layers - 1>::call(layers, profiler);
+#else
         std::get<0>(layers).forward(v_ins);
         modelt_detail::forward_unroll<1, n_layers - 1>::call(layers);
+#endif
 
 #if RTNEURAL_USE_XSIMD
         for(int i = 0; i < v_out_size; ++i)
@@ -286,7 +398,7 @@ public:
         if(!shape.is_array() || !json_layers.is_array())
             return;
 
-        const auto nDims = shape.back().get<int>();
+        const auto nDims = getModelInSize(parent);
         debug_print("# dimensions: " + std::to_string(nDims), debug);
 
         if(nDims != in_size)
@@ -305,8 +417,7 @@ public:
 
             const auto l = json_layers.at(json_stream_idx);
             const auto type = l["type"].get<std::string>();
-            const auto layerShape = l["shape"];
-            const auto layerDims = layerShape.back().get<int>();
+            const auto layerDims = getLayerOutSize(l);
 
             if(layer.isActivation()) // activation layers don't need initialisation
             {
@@ -357,6 +468,10 @@ private:
 
     std::tuple<Layers...> layers;
     static constexpr size_t n_layers = sizeof...(Layers);
+
+#if RTNEURAL_ENABLE_PROFILING
+    profiling::Profiler profiler;
+#endif
 };
 
 } // namespace RTNeural
@@ -0,0 +1,236 @@
+#ifndef PROFILER_H_INCLUDED
+#define PROFILER_H_INCLUDED
+
+#include "../modules/json/json.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace RTNeural
+{
+/**
+ * Per-layer profiling for `Model` and `ModelT`.
+ *
+ * Only compiled when RTNEURAL_ENABLE_PROFILING is set: without it the
+ * models contain no profiling code or data at all.
+ */
+namespace profiling
+{
+
+    /**
+     * Reads the CPU time stamp counter (rdtsc on x86, the virtual counter
+     * on aarch64), or steady clock nanoseconds on other platforms.
+     */
+    inline uint64_t readCycleCounter() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t value;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    /** Statistics accumulated for one layer of a model. */
+    struct LayerStats
+    {
+        std::string name;
+        int in_size = 0;
+        int out_size = 0;
+
+        /** Bytes of weights read by each forward call. */
+        size_t weightBytes = 0;
+
+        /** Estimated floating point operations of each forward call. */
+        double flopsPerCall = 0.0;
+
+        uint64_t calls = 0;
+        uint64_t cycles = 0;
+        uint64_t nanoseconds = 0;
+
+        double getAverageCycles() const noexcept { return calls > 0 ? (double)cycles / (double)calls : 0.0; }
+        double getAverageNanoseconds() const noexcept { return calls > 0 ? (double)nanoseconds / (double)calls : 0.0; }
+        double getGFlops() const noexcept { return nanoseconds > 0 ? flopsPerCall * (double)calls / (double)nanoseconds : 0.0; }
+    };
+
+    /**
+     * Returns the number of weights and the floating point operations of one
+     * forward call of a layer, from its name and sizes. Activations count as
+     * one operation per element (four for the exponential ones).
+     */
+    inline void estimateLayerCost(const std::string& name, int in_size, int out_size, int kernel_size,
+        size_t& numWeights, double& flops) noexcept
+    {
+        const auto in = (double)in_size;
+        const auto out = (double)out_size;
+
+        if(name == "dense")
+        {
+            numWeights = (size_t)in_size * out_size + out_size;
+            flops = 2.0 * in * out + out;
+        }
+        else if(name == "conv1d")
+        {
+            numWeights = (size_t)in_size * out_size * kernel_size + out_size;
+            flops = 2.0 * in * out * kernel_size + out;
+        }
+        else if(name == "gru")
+        {
+            numWeights = (size_t)3 * out_size * (in_size + out_size) + 6 * out_size;
+            flops = 6.0 * out * (in + out) + 12.0 * out;
+        }
+        else if(name == "lstm")
+        {
+            numWeights = (size_t)4 * out_size * (in_size + out_size) + 4 * out_size;
+            flops = 8.0 * out * (in + out) + 12.0 * out;
+        }
+        else if(name == "streaming-window")
+        {
+            numWeights = 0;
+            flops = 0.0;
+        }
+        else
+        {
+            numWeights = 0;
+            flops = (name == "relu" ? 1.0 : 4.0) * out;
+        }
+    }
+
+    /** Collects per-layer timings over many forward calls. */
+    class Profiler
+    {
+    public:
+        /** Removes all layers. */
+        void clear() { layers.clear(); }
+
+        /** Adds a layer to profile, the layers must be added in forward order. */
+        template <typename T>
+        void addLayer(const std::string& name, int in_size, int out_size, int kernel_size = 1)
+        {
+            size_t numWeights = 0;
+            double flops = 0.0;
+            estimateLayerCost(name, in_size, out_size, kernel_size, numWeights, flops);
+            addLayer<T>(name, in_size, out_size, numWeights, flops);
+        }
+
+        /** Adds a layer whose cost cannot be estimated from its sizes (e.g. 2D convolutions). */
+        template <typename T>
+        void addLayer(const std::string& name, int in_size, int out_size, size_t numWeights, double flopsPerCall)
+        {
+            LayerStats stats;
+            stats.name = name;
+            stats.in_size = in_size;
+            stats.out_size = out_size;
+            stats.flopsPerCall = flopsPerCall;
+            stats.weightBytes = numWeights * sizeof(T);
+
+            layers.push_back(stats);
+        }
+
+        /** Resets the counters of all layers. */
+        void reset() noexcept
+        {
+            for(auto& l : layers)
+                l.calls = l.cycles = l.nanoseconds = 0;
+        }
+
+        /** Starts timing a layer. */
+        inline void begin() noexcept
+        {
+            startTime = std::chrono::steady_clock::now();
+            startCycles = readCycleCounter();
+        }
+
+        /** Stops timing a layer and accumulates the result into its counters. */
+        inline void end(size_t layerIndex) noexcept
+        {
+            const auto cycles = readCycleCounter() - startCycles;
+            const auto elapsed = std::chrono::steady_clock::now() - startTime;
+
+            auto& stats = layers[layerIndex];
+            stats.calls++;
+            stats.cycles += cycles;
+            stats.nanoseconds += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        }
+
+        /** Returns the statistics of every layer. */
+        const std::vector<LayerStats>& getLayers() const noexcept { return layers; }
+
+        /** Prints a table with one row per layer. */
+        void print(std::ostream& os) const
+        {
+            const auto oldFlags = os.flags();
+            const auto oldFill = os.fill(' ');
+            const auto oldPrecision = os.precision();
+
+            uint64_t totalNanoseconds = 0;
+            for(const auto& l : layers)
+                totalNanoseconds += l.nanoseconds;
+
+            os << std::left << std::setw(4) << "#" << std::setw(10) << "layer" << std::setw(12) << "shape"
+               << std::right << std::setw(10) << "calls" << std::setw(12) << "cycles" << std::setw(12) << "ns"
+               << std::setw(8) << "%" << std::setw(12) << "weight KiB" << std::setw(10) << "GFLOP/s" << "\n";
+
+            for(size_t i = 0; i < layers.size(); ++i)
+            {
+                const auto& l = layers[i];
+                const auto share = totalNanoseconds > 0 ? 100.0 * (double)l.nanoseconds / (double)totalNanoseconds : 0.0;
+                const auto shape = std::to_string(l.in_size) + "->" + std::to_string(l.out_size);
+
+                os << std::left << std::setw(4) << i << std::setw(10) << l.name << std::setw(12) << shape
+                   << std::right << std::setw(10) << l.calls << std::fixed << std::setprecision(0)
+                   << std::setw(12) << l.getAverageCycles() << std::setw(12) << l.getAverageNanoseconds()
+                   << std::setprecision(1) << std::setw(8) << share << std::setw(12) << (double)l.weightBytes / 1024.0
+                   << std::setprecision(2) << std::setw(10) << l.getGFlops() << "\n";
+            }
+
+            os.flags(oldFlags);
+            os.fill(oldFill);
+            os.precision(oldPrecision);
+        }
+
+        /** Exports the statistics of every layer (cycles and ns are averages per call). */
+        nlohmann::json toJson() const
+        {
+            auto result = nlohmann::json::array();
+            for(const auto& l : layers)
+            {
+                result.push_back({
+                    { "name", l.name },
+                    { "in_size", l.in_size },
+                    { "out_size", l.out_size },
+                    { "calls", l.calls },
+                    { "cycles", l.getAverageCycles() },
+                    { "ns", l.getAverageNanoseconds() },
+                    { "weight_bytes", l.weightBytes },
+                    { "flops", l.flopsPerCall },
+                    { "gflops", l.getGFlops() },
+                });
+            }
+            return result;
+        }
+
+    private:
+        std::vector<LayerStats> layers;
+
+        std::chrono::steady_clock::time_point startTime;
+        uint64_t startCycles = 0;
+    };
+
+} // namespace profiling
+} // namespace RTNeural
+
+#endif // PROFILER_H_INCLUDED
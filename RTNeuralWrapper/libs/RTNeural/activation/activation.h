@@ -73,8 +73,12 @@ public:
     /** Performs forward propagation for tanh activation. */
     inline void forward(const T* input, T* out) override
     {
+#if RTNEURAL_RUNTIME_DISPATCH
+        dispatch::kernels<T>().tanh(input, out, Layer<T>::out_size);
+#else
         for(int i = 0; i < Layer<T>::out_size; ++i)
             out[i] = std::tanh(input[i]);
+#endif
     }
 };
 
@@ -126,8 +130,12 @@ public:
     /** Performs forward propagation for tanh activation. */
     inline void forward(const T* input, T* out) override
     {
+#if RTNEURAL_RUNTIME_DISPATCH
+        dispatch::kernels<T>().fast_tanh(input, out, Layer<T>::out_size);
+#else
         for(int i = 0; i < Layer<T>::out_size; ++i)
             out[i] = tanh_approx(input[i]);
+#endif
     }
 };
 
@@ -175,6 +183,14 @@ public:
         : ReLuActivation(*sizes.begin())
     {
     }
+
+#if RTNEURAL_RUNTIME_DISPATCH
+    /** Performs forward propagation for ReLU activation. */
+    inline void forward(const T* input, T* out) override
+    {
+        dispatch::kernels<T>().relu(input, out, Layer<T>::out_size);
+    }
+#endif
 };
 
 /** Static implementation of a ReLU activation layer. */
@@ -221,6 +237,14 @@ public:
         : SigmoidActivation(*sizes.begin())
     {
     }
+
+#if RTNEURAL_RUNTIME_DISPATCH
+    /** Performs forward propagation for sigmoid activation. */
+    inline void forward(const T* input, T* out) override
+    {
+        dispatch::kernels<T>().sigmoid(input, out, Layer<T>::out_size);
+    }
+#endif
 };
 
 /** Static implementation of a sigmoid activation layer. */
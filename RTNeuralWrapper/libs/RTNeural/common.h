@@ -38,6 +38,13 @@ sigmoid(Eigen::Matrix<T, Eigen::Dynamic, 1>& vector) noexcept
     vector = (T)1 / (((T)-1 * vector.array()).array().exp() + (T)1);
 }
 
+template <typename T>
+static inline void
+sigmoid(Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>>& vector) noexcept
+{
+    vector = (T)1 / (((T)-1 * vector.array()).array().exp() + (T)1);
+}
+
 template <typename T>
 static inline void
 softmax(Eigen::Matrix<T, Eigen::Dynamic, 1>& vector) noexcept
@@ -327,13 +334,21 @@ static inline void softmax(const double* in, double* out, int dim) noexcept
 #include <cmath>
 #include <numeric>
 
+#if RTNEURAL_RUNTIME_DISPATCH
+#include "dispatch/dispatch.h"
+#endif
+
 namespace RTNeural
 {
 
 template <typename T>
 static inline T vMult(const T* arg1, const T* arg2, int dim) noexcept
 {
+#if RTNEURAL_RUNTIME_DISPATCH
+    return dispatch::kernels<T>().dot(arg1, arg2, dim);
+#else
     return std::inner_product(arg1, arg1 + dim, arg2, (T)0);
+#endif
 }
 
 template <typename T>
@@ -52,6 +52,12 @@ public:
     /** Returns the name of this layer. */
     std::string getName() const noexcept override { return "conv1d"; }
 
+    /** Returns the number of weights and state values of this layer. */
+    size_t getArenaSize() const noexcept override { return numValues(); }
+
+    /** Moves the weights, bias and input state into the given block. */
+    void bindArena(T* block) override;
+
     /** Performs forward propagation for this layer. */
     virtual inline void forward(const T* input, T* h) override
     {
@@ -101,10 +107,22 @@ public:
     int getDilationRate() const noexcept { return dilation_rate; }
 
 private:
+    /** Number of weights and state values held in `storage` or in the arena. */
+    size_t numValues() const noexcept
+    {
+        return ((size_t)Layer<T>::out_size * state_size + 2 * state_size) * Layer<T>::in_size + Layer<T>::out_size;
+    }
+
+    /** Points the weight, bias and state rows at the given block of `numValues()` values. */
+    void mapValues(T* block);
+
     const int dilation_rate;
     const int kernel_size;
     const int state_size;
 
+    std::vector<T> storage; // owns the weights and state until they are bound to an arena
+    T* values; // start of the weights and state
+
     T*** kernelWeights;
     T* bias;
     T** state;
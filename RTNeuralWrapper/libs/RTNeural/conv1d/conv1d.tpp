@@ -11,23 +11,15 @@ Conv1D<T>::Conv1D(int in_size, int out_size, int kernel_size, int dilation)
     , dilation_rate(dilation)
     , kernel_size(kernel_size)
     , state_size(kernel_size * dilation)
+    , storage(numValues(), (T)0)
 {
     kernelWeights = new T**[out_size];
     for(int i = 0; i < out_size; ++i)
-    {
         kernelWeights[i] = new T*[in_size];
-        for(int k = 0; k < in_size; ++k)
-        {
-            kernelWeights[i][k] = new T[state_size];
-            std::fill(kernelWeights[i][k], &kernelWeights[i][k][state_size], (T)0);
-        }
-    }
-
-    bias = new T[out_size];
 
     state = new T*[in_size];
-    for(int k = 0; k < in_size; ++k)
-        state[k] = new T[2 * state_size];
+
+    mapValues(storage.data());
 }
 
 template <typename T>
@@ -51,20 +43,42 @@ Conv1D<T>& Conv1D<T>::operator=(const Conv1D<T>& other)
 template <typename T>
 Conv1D<T>::~Conv1D()
 {
+    for(int i = 0; i < Layer<T>::out_size; ++i)
+        delete[] kernelWeights[i];
+
+    delete[] kernelWeights;
+    delete[] state;
+}
+
+template <typename T>
+void Conv1D<T>::mapValues(T* block)
+{
+    values = block;
+
     for(int i = 0; i < Layer<T>::out_size; ++i)
     {
         for(int k = 0; k < Layer<T>::in_size; ++k)
-            delete[] kernelWeights[i][k];
-
-        delete[] kernelWeights[i];
+        {
+            kernelWeights[i][k] = block;
+            block += state_size;
+        }
     }
 
-    delete[] kernelWeights;
-    delete[] bias;
+    bias = block;
+    block += Layer<T>::out_size;
 
     for(int k = 0; k < Layer<T>::in_size; ++k)
-        delete[] state[k];
-    delete[] state;
+        state[k] = block + (size_t)k * 2 * state_size;
+}
+
+template <typename T>
+void Conv1D<T>::bindArena(T* block)
+{
+    std::copy(values, values + numValues(), block);
+    mapValues(block);
+
+    storage.clear();
+    storage.shrink_to_fit();
 }
 
 template <typename T>
@@ -3,6 +3,7 @@
 
 #include "../Layer.h"
 #include <Eigen/Dense>
+#include <vector>
 
 namespace RTNeural
 {
@@ -41,6 +42,12 @@ public:
     /** Returns the name of this layer. */
     std::string getName() const noexcept override { return "conv1d"; }
 
+    /** Returns the number of weights and state values of this layer. */
+    size_t getArenaSize() const noexcept override { return numValues(); }
+
+    /** Moves the weights, bias and input state into the given block. */
+    void bindArena(T* block) override;
+
     /** Performs forward propagation for this layer. */
     virtual inline void forward(const T* input, T* h) override
     {
@@ -81,18 +88,33 @@ public:
     int getDilationRate() const noexcept { return dilation_rate; }
 
 private:
+    using MatrixMap = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>>;
+    using VectorMap = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>>;
+
+    /** Number of weights and state values held in `storage` or in the arena. */
+    size_t numValues() const noexcept
+    {
+        return ((size_t)Layer<T>::out_size * state_size + 2 * state_size + 1) * Layer<T>::in_size
+            + 2 * (size_t)Layer<T>::out_size;
+    }
+
+    /** Points the weight matrices, bias and state at the given block of `numValues()` values. */
+    void mapValues(T* block);
+
     const int dilation_rate;
     const int kernel_size;
     const int state_size;
 
-    std::vector<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>> kernelWeights;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> bias;
+    std::vector<T, Eigen::aligned_allocator<T>> storage; // owns the weights and state until they are bound to an arena
+
+    std::vector<MatrixMap> kernelWeights;
+    VectorMap bias;
 
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> state;
+    MatrixMap state;
     int state_ptr = 0;
 
-    Eigen::Matrix<T, Eigen::Dynamic, 1> inVec;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> outVec;
+    VectorMap inVec;
+    VectorMap outVec;
 };
 
 //====================================================
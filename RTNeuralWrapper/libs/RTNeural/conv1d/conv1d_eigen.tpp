@@ -9,15 +9,14 @@ Conv1D<T>::Conv1D(int in_size, int out_size, int kernel_size, int dilation)
     , dilation_rate(dilation)
     , kernel_size(kernel_size)
     , state_size(kernel_size * dilation)
+    , storage(numValues(), (T)0)
+    , kernelWeights(out_size, MatrixMap(nullptr, in_size, state_size))
+    , bias(nullptr, out_size)
+    , state(nullptr, in_size, 2 * state_size)
+    , inVec(nullptr, in_size)
+    , outVec(nullptr, out_size)
 {
-    kernelWeights.resize(out_size);
-    for(int i = 0; i < out_size; ++i)
-        kernelWeights[i] = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(in_size, state_size);
-
-    bias = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    state = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(in_size, 2 * state_size);
-    inVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(in_size, 1);
-    outVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
+    mapValues(storage.data());
 }
 
 template <typename T>
@@ -43,11 +42,41 @@ Conv1D<T>::~Conv1D()
 {
 }
 
+template <typename T>
+void Conv1D<T>::mapValues(T* block)
+{
+    const auto in_size = Layer<T>::in_size;
+    const auto out_size = Layer<T>::out_size;
+    auto next = [&block](size_t size) {
+        auto* values = block;
+        block += size;
+        return values;
+    };
+
+    for(auto& weights : kernelWeights)
+        new(&weights) MatrixMap(next((size_t)in_size * state_size), in_size, state_size);
+
+    new(&bias) VectorMap(next(out_size), out_size);
+    new(&state) MatrixMap(next((size_t)in_size * 2 * state_size), in_size, 2 * state_size);
+    new(&inVec) VectorMap(next(in_size), in_size);
+    new(&outVec) VectorMap(next(out_size), out_size);
+}
+
+template <typename T>
+void Conv1D<T>::bindArena(T* block)
+{
+    std::copy(kernelWeights[0].data(), kernelWeights[0].data() + numValues(), block);
+    mapValues(block);
+
+    storage.clear();
+    storage.shrink_to_fit();
+}
+
 template <typename T>
 void Conv1D<T>::reset()
 {
     state_ptr = 0;
-    state = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(Layer<T>::in_size, 2 * state_size);
+    state.setZero();
 }
 
 template <typename T>
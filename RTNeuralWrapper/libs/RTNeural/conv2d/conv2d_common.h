@@ -0,0 +1,141 @@
+#ifndef CONV2DCOMMON_H_INCLUDED
+#define CONV2DCOMMON_H_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+
+namespace RTNeural
+{
+
+/**
+ * Geometry of a 2-dimensional convolution, shared by all the backends.
+ *
+ * Feature maps are stored channels-last, as TensorFlow does:
+ * value (row, col, channel) is at index (row * cols + col) * channels + channel.
+ * The output size and the padding follow TensorFlow's "valid" and "same" rules.
+ */
+struct Conv2DShape
+{
+    int num_filters_in;
+    int num_filters_out;
+    int in_rows;
+    int in_cols;
+    int kernel_rows;
+    int kernel_cols;
+    int stride_rows;
+    int stride_cols;
+    int dilation_rows;
+    int dilation_cols;
+    bool valid_pad;
+
+    static constexpr int outputSize(int in, int kernel, int stride, int dilation, bool valid) noexcept
+    {
+        return valid ? std::max((in - (kernel - 1) * dilation + stride - 1) / stride, 0) : (in + stride - 1) / stride;
+    }
+
+    static constexpr int padBefore(int in, int kernel, int stride, int dilation, bool valid) noexcept
+    {
+        return valid ? 0 : std::max((outputSize(in, kernel, stride, dilation, valid) - 1) * stride + (kernel - 1) * dilation + 1 - in, 0) / 2;
+    }
+
+    constexpr int outRows() const noexcept { return outputSize(in_rows, kernel_rows, stride_rows, dilation_rows, valid_pad); }
+    constexpr int outCols() const noexcept { return outputSize(in_cols, kernel_cols, stride_cols, dilation_cols, valid_pad); }
+    constexpr int padTop() const noexcept { return padBefore(in_rows, kernel_rows, stride_rows, dilation_rows, valid_pad); }
+    constexpr int padLeft() const noexcept { return padBefore(in_cols, kernel_cols, stride_cols, dilation_cols, valid_pad); }
+
+    /** Number of values of the input and output feature maps. */
+    constexpr int inSize() const noexcept { return in_rows * in_cols * num_filters_in; }
+    constexpr int outSize() const noexcept { return outRows() * outCols() * num_filters_out; }
+
+    /** Number of weights and biases, and floating point operations of one forward call. */
+    constexpr size_t numWeights() const noexcept { return (size_t)kernel_rows * kernel_cols * num_filters_in * num_filters_out + num_filters_out; }
+    constexpr double flopsPerCall() const noexcept { return (2.0 * kernel_rows * kernel_cols * num_filters_in + 1.0) * outSize(); }
+
+    /** First output column that reads an input column (not the padding) through kernel column kc. */
+    constexpr int firstValidCol(int kc) const noexcept
+    {
+        return std::max(padLeft() - kc * dilation_cols + stride_cols - 1, 0) / stride_cols;
+    }
+
+    /** One past the last output column that reads an input column through kernel column kc. */
+    constexpr int endValidCol(int kc) const noexcept
+    {
+        return in_cols - 1 + padLeft() - kc * dilation_cols < 0 ? 0 : std::min(outCols(), (in_cols - 1 + padLeft() - kc * dilation_cols) / stride_cols + 1);
+    }
+};
+
+#ifndef DOXYGEN
+namespace conv2d_detail
+{
+    /**
+     * Direct convolution, without an im2col copy of the input.
+     *
+     * Each output row is computed one kernel tap (kr, kc) at a time: the
+     * num_filters_in x num_filters_out weights of the tap stay in cache
+     * while they are applied to every column of the row, and the row of
+     * the output is accumulated in place. Columns that would read the
+     * padding are skipped instead of multiplied by zero.
+     *
+     * For every tap, tapProduct(x, xStride, y, numCols, w) must add to the
+     * numCols output pixels starting at y (num_filters_out values each, contiguous)
+     * the product of the input pixels starting at x (num_filters_in values each,
+     * xStride values apart) with the weights w[num_filters_in][num_filters_out].
+     *
+     * The weights are stored as weights[kernel_rows][kernel_cols][num_filters_in][num_filters_out].
+     */
+    template <typename T, typename TapProduct>
+    inline void forward(const Conv2DShape& s, const T* input, T* output, const T* weights, const T* bias,
+        TapProduct&& tapProduct) noexcept
+    {
+        const int outRows = s.outRows();
+        const int outCols = s.outCols();
+        const int padTop = s.padTop();
+        const int padLeft = s.padLeft();
+        const int xStride = s.stride_cols * s.num_filters_in;
+        const size_t tapSize = (size_t)s.num_filters_in * s.num_filters_out;
+
+        for(int orow = 0; orow < outRows; ++orow)
+        {
+            T* outRow = output + (size_t)orow * outCols * s.num_filters_out;
+            for(int ocol = 0; ocol < outCols; ++ocol)
+                std::copy(bias, bias + s.num_filters_out, outRow + (size_t)ocol * s.num_filters_out);
+
+            for(int kr = 0; kr < s.kernel_rows; ++kr)
+            {
+                const int irow = orow * s.stride_rows - padTop + kr * s.dilation_rows;
+                if(irow < 0 || irow >= s.in_rows)
+                    continue;
+
+                const T* inRow = input + (size_t)irow * s.in_cols * s.num_filters_in;
+                for(int kc = 0; kc < s.kernel_cols; ++kc)
+                {
+                    const int colBegin = s.firstValidCol(kc);
+                    const int colEnd = s.endValidCol(kc);
+                    if(colBegin >= colEnd)
+                        continue;
+
+                    const int icol = colBegin * s.stride_cols - padLeft + kc * s.dilation_cols;
+                    tapProduct(inRow + (size_t)icol * s.num_filters_in, xStride,
+                        outRow + (size_t)colBegin * s.num_filters_out, colEnd - colBegin,
+                        weights + (size_t)(kr * s.kernel_cols + kc) * tapSize);
+                }
+            }
+        }
+    }
+
+    /** Reorders weights[num_filters_out][num_filters_in][kernel_rows][kernel_cols] into the layout of forward(). */
+    template <typename T, typename WeightsType>
+    inline void setWeights(const Conv2DShape& s, const WeightsType& weights, T* dest) noexcept
+    {
+        for(int kr = 0; kr < s.kernel_rows; ++kr)
+            for(int kc = 0; kc < s.kernel_cols; ++kc)
+                for(int i = 0; i < s.num_filters_in; ++i)
+                    for(int o = 0; o < s.num_filters_out; ++o)
+                        *dest++ = weights[o][i][kr][kc];
+    }
+} // namespace conv2d_detail
+#endif // DOXYGEN
+
+} // namespace RTNeural
+
+#endif // CONV2DCOMMON_H_INCLUDED
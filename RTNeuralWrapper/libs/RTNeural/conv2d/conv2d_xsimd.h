@@ -0,0 +1,244 @@
+#ifndef CONV2DXSIMD_H_INCLUDED
+#define CONV2DXSIMD_H_INCLUDED
+
+#include "../Layer.h"
+#include "../common.h"
+#include "conv2d_common.h"
+#include <vector>
+#include <xsimd/xsimd.hpp>
+
+namespace RTNeural
+{
+
+#ifndef DOXYGEN
+namespace conv2d_detail
+{
+    /** y += alpha * x */
+    template <typename T>
+    static inline void axpy(T alpha, const T* x, T* y, int dim) noexcept
+    {
+        using b_type = xsimd::simd_type<T>;
+        constexpr auto inc = (int)b_type::size;
+        const auto vec_size = dim - dim % inc;
+
+        const b_type alpha_v(alpha);
+        for(int i = 0; i < vec_size; i += inc)
+            xsimd::store_unaligned(&y[i], xsimd::fma(alpha_v, xsimd::load_unaligned(&x[i]), xsimd::load_unaligned(&y[i])));
+
+        for(int i = vec_size; i < dim; ++i)
+            y[i] += alpha * x[i];
+    }
+
+    /** Product of one kernel tap with a row of input pixels, see forward(). */
+    template <typename T>
+    static inline void xsimdTapProduct(const T* x, int xStride, T* y, int numCols, const T* w, int nIn, int nOut) noexcept
+    {
+        for(int c = 0; c < numCols; ++c, x += xStride, y += nOut)
+            for(int i = 0; i < nIn; ++i)
+                axpy(x[i], w + (size_t)i * nOut, y, nOut);
+    }
+} // namespace conv2d_detail
+#endif // DOXYGEN
+
+/**
+ * Dynamic implementation of a 2-dimensional convolution layer
+ * with no activation.
+ *
+ * The layer convolves a whole feature map of in_rows x in_cols pixels
+ * with num_filters_in channels at each call, and has no state.
+ * Input and output are stored channels-last (see `Conv2DShape`),
+ * so a following dense layer reads the output as a flattened
+ * TensorFlow feature map.
+ */
+template <typename T>
+class Conv2D final : public Layer<T>
+{
+public:
+    /**
+     * Constructs a 2D convolution layer for the given dimensions.
+     *
+     * @param num_filters_in: the number of channels of the input
+     * @param num_filters_out: the number of filters (channels of the output)
+     * @param in_rows: the number of rows of the input
+     * @param in_cols: the number of columns of the input
+     * @param kernel_rows: the number of rows of the kernel
+     * @param kernel_cols: the number of columns of the kernel
+     * @param stride_rows: the stride along the rows
+     * @param stride_cols: the stride along the columns
+     * @param dilation_rows: the dilation rate along the rows
+     * @param dilation_cols: the dilation rate along the columns
+     * @param valid_pad: true for "valid" padding, false for "same" padding
+     */
+    Conv2D(int num_filters_in, int num_filters_out, int in_rows, int in_cols, int kernel_rows, int kernel_cols,
+        int stride_rows, int stride_cols, int dilation_rows, int dilation_cols, bool valid_pad)
+        : Conv2D(Conv2DShape { num_filters_in, num_filters_out, in_rows, in_cols, kernel_rows, kernel_cols,
+            stride_rows, stride_cols, dilation_rows, dilation_cols, valid_pad })
+    {
+    }
+
+    /** Constructs a 2D convolution layer for the given shape. */
+    explicit Conv2D(const Conv2DShape& shape)
+        : Layer<T>(shape.inSize(), shape.outSize())
+        , shape(shape)
+        , weights(shape.numWeights() - shape.num_filters_out, (T)0)
+        , bias(shape.num_filters_out, (T)0)
+    {
+    }
+
+    Conv2D(const Conv2D& other)
+        : Conv2D(other.shape)
+    {
+    }
+
+    virtual ~Conv2D() { }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "conv2d"; }
+
+    /** Performs forward propagation for this layer. */
+    inline void forward(const T* input, T* h) override
+    {
+        const int nIn = shape.num_filters_in;
+        const int nOut = shape.num_filters_out;
+        conv2d_detail::forward(shape, input, h, weights.data(), bias.data(),
+            [nIn, nOut](const T* x, int xStride, T* y, int numCols, const T* w) noexcept {
+                conv2d_detail::xsimdTapProduct(x, xStride, y, numCols, w, nIn, nOut);
+            });
+    }
+
+    /**
+     * Sets the layer weights.
+     *
+     * The weights vector must have size weights[num_filters_out][num_filters_in][kernel_rows][kernel_cols]
+     */
+    void setWeights(const std::vector<std::vector<std::vector<std::vector<T>>>>& newWeights)
+    {
+        conv2d_detail::setWeights(shape, newWeights, weights.data());
+    }
+
+    /**
+     * Sets the layer biases.
+     *
+     * The bias vector must have size bias[num_filters_out]
+     */
+    void setBias(const std::vector<T>& biasVals)
+    {
+        std::copy(biasVals.begin(), biasVals.begin() + shape.num_filters_out, bias.begin());
+    }
+
+    /** Returns the dimensions of the convolution. */
+    const Conv2DShape& getShape() const noexcept { return shape; }
+
+private:
+    using vec_type = std::vector<T, XSIMD_DEFAULT_ALLOCATOR(T)>;
+
+    const Conv2DShape shape;
+
+    vec_type weights; // [kernel_rows][kernel_cols][num_filters_in][num_filters_out]
+    vec_type bias; // [num_filters_out]
+};
+
+//====================================================
+/**
+ * Static implementation of a 2-dimensional convolution layer
+ * with no activation.
+ *
+ * The layer convolves a whole feature map at each call, see `Conv2D`.
+ *
+ * @param num_filters_in_t: the number of channels of the input
+ * @param num_filters_out_t: the number of filters (channels of the output)
+ * @param in_rows_t: the number of rows of the input
+ * @param in_cols_t: the number of columns of the input
+ * @param kernel_rows_t: the number of rows of the kernel
+ * @param kernel_cols_t: the number of columns of the kernel
+ * @param stride_rows_t: the stride along the rows
+ * @param stride_cols_t: the stride along the columns
+ * @param dilation_rows_t: the dilation rate along the rows
+ * @param dilation_cols_t: the dilation rate along the columns
+ * @param valid_pad_t: true for "valid" padding, false for "same" padding
+ */
+template <typename T, int num_filters_in_t, int num_filters_out_t, int in_rows_t, int in_cols_t, int kernel_rows_t, int kernel_cols_t,
+    int stride_rows_t = 1, int stride_cols_t = 1, int dilation_rows_t = 1, int dilation_cols_t = 1, bool valid_pad_t = true>
+class Conv2DT
+{
+    using v_type = xsimd::simd_type<T>;
+    static constexpr auto v_size = (int)v_type::size;
+
+    static constexpr auto out_rows = Conv2DShape::outputSize(in_rows_t, kernel_rows_t, stride_rows_t, dilation_rows_t, valid_pad_t);
+    static constexpr auto out_cols = Conv2DShape::outputSize(in_cols_t, kernel_cols_t, stride_cols_t, dilation_cols_t, valid_pad_t);
+    static constexpr auto weights_size = kernel_rows_t * kernel_cols_t * num_filters_in_t * num_filters_out_t;
+
+public:
+    static constexpr auto in_size = in_rows_t * in_cols_t * num_filters_in_t;
+    static constexpr auto out_size = out_rows * out_cols * num_filters_out_t;
+
+private:
+    static constexpr auto v_in_size = ceil_div(in_size, v_size);
+    static constexpr auto v_out_size = ceil_div(out_size, v_size);
+
+public:
+    Conv2DT()
+    {
+        std::fill(weights, weights + weights_size, (T)0);
+        std::fill(bias, bias + num_filters_out_t, (T)0);
+
+        for(int i = 0; i < v_out_size; ++i)
+            outs[i] = v_type((T)0.0);
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept { return "conv2d"; }
+
+    /** Returns false since convolution is not an activation layer. */
+    constexpr bool isActivation() const noexcept { return false; }
+
+    /** Reset is a no-op, since Conv2D does not have state. */
+    void reset() { }
+
+    /** Performs forward propagation for this layer. */
+    inline void forward(const v_type (&ins)[v_in_size])
+    {
+        // the feature maps are contiguous inside the batches, the padding of the last batch stays zero
+        conv2d_detail::forward(getShape(), reinterpret_cast<const T*>(ins), reinterpret_cast<T*>(outs), weights, bias,
+            [](const T* x, int xStride, T* y, int numCols, const T* w) noexcept {
+                conv2d_detail::xsimdTapProduct(x, xStride, y, numCols, w, num_filters_in_t, num_filters_out_t);
+            });
+    }
+
+    /**
+     * Sets the layer weights.
+     *
+     * The weights vector must have size weights[num_filters_out][num_filters_in][kernel_rows][kernel_cols]
+     */
+    void setWeights(const std::vector<std::vector<std::vector<std::vector<T>>>>& newWeights)
+    {
+        conv2d_detail::setWeights(getShape(), newWeights, weights);
+    }
+
+    /**
+     * Sets the layer biases.
+     *
+     * The bias vector must have size bias[num_filters_out]
+     */
+    void setBias(const std::vector<T>& biasVals)
+    {
+        std::copy(biasVals.begin(), biasVals.begin() + num_filters_out_t, bias);
+    }
+
+    /** Returns the dimensions of the convolution. */
+    static constexpr Conv2DShape getShape() noexcept
+    {
+        return { num_filters_in_t, num_filters_out_t, in_rows_t, in_cols_t, kernel_rows_t, kernel_cols_t,
+            stride_rows_t, stride_cols_t, dilation_rows_t, dilation_cols_t, valid_pad_t };
+    }
+
+    v_type outs[v_out_size];
+
+private:
+    T weights alignas(RTNEURAL_DEFAULT_ALIGNMENT)[weights_size];
+    T bias[num_filters_out_t];
+};
+
+} // namespace RTNeural
+
+#endif // CONV2DXSIMD_H_INCLUDED
@@ -0,0 +1,209 @@
+#ifndef STREAMINGCONV2D_H_INCLUDED
+#define STREAMINGCONV2D_H_INCLUDED
+
+#include "conv2d.h"
+#include <algorithm>
+#include <vector>
+
+namespace RTNeural
+{
+
+/**
+ * Streaming (causal in time) version of `Conv2D`, for feature maps
+ * that slide along their rows, e.g. a spectrogram with one row per frame.
+ *
+ * Each call takes only the newest num_frames input rows (frames) and
+ * returns the num_frames output rows they complete, so the cost of a call
+ * does not depend on the length of the window. The layer keeps the last
+ * (kernel_rows - 1) * dilation_rows input frames, which were computed
+ * by the previous layer on the previous calls.
+ *
+ * The rows must have stride 1 and no padding: the shape must use "valid"
+ * padding, or have kernel_rows == 1. in_rows is ignored. Like `Conv1D`,
+ * the history is zero after `reset()`: the outputs match the whole-window
+ * `Conv2D` once the receptive field has been filled with real frames.
+ */
+template <typename T>
+class StreamingConv2D final : public Layer<T>
+{
+public:
+    /**
+     * Constructs a streaming 2D convolution layer.
+     *
+     * @param shape: the dimensions of the convolution
+     * @param num_frames: the number of frames of each call
+     */
+    StreamingConv2D(const Conv2DShape& shape, int num_frames = 1)
+        : Layer<T>(num_frames * shape.in_cols * shape.num_filters_in, num_frames * shape.outCols() * shape.num_filters_out)
+        , num_frames(num_frames)
+        , history_frames((shape.kernel_rows - 1) * shape.dilation_rows)
+        , frame_size(shape.in_cols * shape.num_filters_in)
+        , conv(getFrameShape(shape, history_frames + num_frames))
+        , frames((size_t)(history_frames + num_frames) * frame_size, (T)0)
+    {
+    }
+
+    StreamingConv2D(const StreamingConv2D& other)
+        : StreamingConv2D(other.conv.getShape(), other.num_frames)
+    {
+    }
+
+    virtual ~StreamingConv2D() { }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "streaming-conv2d"; }
+
+    /** Resets the layer state. */
+    void reset() override
+    {
+        std::fill(frames.begin(), frames.end(), (T)0);
+    }
+
+    /** Performs forward propagation for this layer. */
+    inline void forward(const T* input, T* h) override
+    {
+        const auto historySize = (size_t)history_frames * frame_size;
+        std::copy(input, input + Layer<T>::in_size, frames.begin() + historySize);
+
+        conv.forward(frames.data(), h);
+
+        // keep the newest frames as the history of the next call
+        std::copy(frames.end() - historySize, frames.end(), frames.begin());
+    }
+
+    /** Returns the number of values needed to store the weights and bias. */
+    size_t getArenaSize() const noexcept override { return conv.getArenaSize(); }
+
+    /** Moves the weights and bias into the given block. */
+    void bindArena(T* block) override { conv.bindArena(block); }
+
+    /**
+     * Sets the layer weights.
+     *
+     * The weights vector must have size weights[num_filters_out][num_filters_in][kernel_rows][kernel_cols]
+     */
+    void setWeights(const std::vector<std::vector<std::vector<std::vector<T>>>>& newWeights)
+    {
+        conv.setWeights(newWeights);
+    }
+
+    /**
+     * Sets the layer biases.
+     *
+     * The bias vector must have size bias[num_filters_out]
+     */
+    void setBias(const std::vector<T>& biasVals)
+    {
+        conv.setBias(biasVals);
+    }
+
+    /** Returns the dimensions of the convolution run by each call (history and new frames). */
+    const Conv2DShape& getShape() const noexcept { return conv.getShape(); }
+
+    /** Returns the number of frames of each call. */
+    int getNumFrames() const noexcept { return num_frames; }
+
+private:
+    static Conv2DShape getFrameShape(Conv2DShape shape, int rows) noexcept
+    {
+        shape.in_rows = rows;
+        return shape;
+    }
+
+    const int num_frames;
+    const int history_frames;
+    const int frame_size;
+
+    Conv2D<T> conv;
+    std::vector<T> frames; // [history_frames + num_frames][frame_size], oldest first
+};
+
+/**
+ * Ring buffer of the last window_frames frames of a stream, returned
+ * as one feature map (oldest frame first) at each call.
+ *
+ * Placed after the `StreamingConv2D` layers of a model, it rebuilds the
+ * whole-window feature map read by the following (dense) layers.
+ */
+template <typename T>
+class StreamingWindow final : public Layer<T>
+{
+public:
+    /**
+     * Constructs a window layer.
+     *
+     * @param frame_size: the number of values of a frame
+     * @param window_frames: the number of frames of the window (output)
+     * @param num_frames: the number of frames of each call (input)
+     */
+    StreamingWindow(int frame_size, int window_frames, int num_frames = 1)
+        : Layer<T>(num_frames * frame_size, window_frames * frame_size)
+        , frame_size(frame_size)
+        , window_frames(window_frames)
+        , num_frames(num_frames)
+        , storage((size_t)window_frames * frame_size, (T)0)
+        , window(storage.data())
+    {
+    }
+
+    virtual ~StreamingWindow() { }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "streaming-window"; }
+
+    /** Resets the layer state. */
+    void reset() override
+    {
+        std::fill(window, window + windowSize(), (T)0);
+        oldest = 0;
+    }
+
+    /** Returns the number of values of the ring buffer. */
+    size_t getArenaSize() const noexcept override { return windowSize(); }
+
+    /** Moves the ring buffer into the given block. */
+    void bindArena(T* block) override
+    {
+        std::copy(window, window + windowSize(), block);
+        window = block;
+
+        storage.clear();
+        storage.shrink_to_fit();
+    }
+
+    /** Performs forward propagation for this layer. */
+    inline void forward(const T* input, T* out) override
+    {
+        // frames that would be overwritten by the same call are skipped
+        const int first = std::max(num_frames - window_frames, 0);
+        for(int f = first; f < num_frames; ++f)
+        {
+            std::copy(input + (size_t)f * frame_size, input + (size_t)(f + 1) * frame_size,
+                window + (size_t)oldest * frame_size);
+            oldest = oldest + 1 == window_frames ? 0 : oldest + 1;
+        }
+
+        auto* split = window + (size_t)oldest * frame_size;
+        auto* end = window + windowSize();
+        std::copy(split, end, out);
+        std::copy(window, split, out + (end - split));
+    }
+
+    /** Returns the number of frames of the window. */
+    int getWindowFrames() const noexcept { return window_frames; }
+
+private:
+    size_t windowSize() const noexcept { return (size_t)window_frames * frame_size; }
+
+    const int frame_size;
+    const int window_frames;
+    const int num_frames;
+
+    std::vector<T> storage; // owns the ring buffer until it is bound to an arena
+    T* window; // ring buffer of window_frames frames
+    int oldest = 0;
+};
+
+} // namespace RTNeural
+
+#endif // STREAMINGCONV2D_H_INCLUDED
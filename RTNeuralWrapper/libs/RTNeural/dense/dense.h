@@ -13,49 +13,11 @@
 #include "dense_accelerate.h"
 #else
 #include "../Layer.h"
+#include "../common.h"
 
 namespace RTNeural
 {
 
-#ifndef DOXYGEN
-/** Single-output dense layer used internally */
-template <typename T>
-class Dense1
-{
-public:
-    Dense1(int in_size)
-        : in_size(in_size)
-    {
-        weights = new T[in_size];
-    }
-
-    ~Dense1() { delete[] weights; }
-
-    inline T forward(const T* input)
-    {
-        return std::inner_product(weights, weights + in_size, input, (T)0) + bias;
-    }
-
-    void setWeights(const T* newWeights)
-    {
-        for(int i = 0; i < in_size; ++i)
-            weights[i] = newWeights[i];
-    }
-
-    void setBias(T b) { bias = b; }
-
-    T getWeight(int i) const noexcept { return weights[i]; }
-
-    T getBias() const noexcept { return bias; }
-
-private:
-    const int in_size;
-    T bias;
-
-    T* weights;
-};
-#endif // DOXYGEN
-
 /**
  * Dynamic implementation of a fully-connected (dense) layer,
  * with no activation.
@@ -67,10 +29,10 @@ public:
     /** Constructs a dense layer for a given input and output size. */
     Dense(int in_size, int out_size)
         : Layer<T>(in_size, out_size)
+        , storage((size_t)(in_size + 1) * out_size, (T)0)
     {
-        subLayers = new Dense1<T>*[out_size];
-        for(int i = 0; i < out_size; ++i)
-            subLayers[i] = new Dense1<T>(in_size);
+        weights = storage.data();
+        bias = weights + (size_t)in_size * out_size;
     }
 
     Dense(std::initializer_list<int> sizes)
@@ -88,13 +50,7 @@ public:
         return *this = Dense(other);
     }
 
-    virtual ~Dense()
-    {
-        for(int i = 0; i < Layer<T>::out_size; ++i)
-            delete subLayers[i];
-
-        delete[] subLayers;
-    }
+    virtual ~Dense() { }
 
     /** Returns the name of this layer. */
     std::string getName() const noexcept override { return "dense"; }
@@ -102,8 +58,52 @@ public:
     /** Performs forward propagation for this layer. */
     inline void forward(const T* input, T* out) override
     {
+#if RTNEURAL_RUNTIME_DISPATCH
+        dispatch::kernels<T>().gemv(weights, bias, input, out, Layer<T>::in_size, Layer<T>::out_size);
+#else
+        for(int i = 0; i < Layer<T>::out_size; ++i)
+            out[i] = vMult(&weights[i * Layer<T>::in_size], input, Layer<T>::in_size) + bias[i];
+#endif
+    }
+
+    /**
+     * Performs forward propagation for an input size known at compile time.
+     * Used by the execution plan of `Model` for common layer widths.
+     */
+    template <int N>
+    inline void forwardN(const T* input, T* out) noexcept
+    {
+#if RTNEURAL_RUNTIME_DISPATCH
+        dispatch::kernels<T>().gemv(weights, bias, input, out, N, Layer<T>::out_size);
+#else
+        static_assert(N % 8 == 0, "Input size must be a multiple of 8");
         for(int i = 0; i < Layer<T>::out_size; ++i)
-            out[i] = subLayers[i]->forward(input);
+        {
+            const T* row = &weights[i * N];
+
+            // eight independent partial sums, so the loop vectorizes without fast-math
+            T sums[8] = {};
+            for(int k = 0; k < N; k += 8)
+                for(int j = 0; j < 8; ++j)
+                    sums[j] += row[k + j] * input[k + j];
+
+            out[i] = ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7])) + bias[i];
+        }
+#endif
+    }
+
+    /** Returns the number of values needed to store the weights and bias. */
+    size_t getArenaSize() const noexcept override { return numParameters(); }
+
+    /** Moves the weights (row-major) and bias into the given block. */
+    void bindArena(T* block) override
+    {
+        std::copy(weights, weights + numParameters(), block);
+        weights = block;
+        bias = block + (size_t)Layer<T>::in_size * Layer<T>::out_size;
+
+        storage.clear();
+        storage.shrink_to_fit();
     }
 
     /**
@@ -115,7 +115,7 @@ public:
     void setWeights(const std::vector<std::vector<T>>& newWeights)
     {
         for(int i = 0; i < Layer<T>::out_size; ++i)
-            subLayers[i]->setWeights(newWeights[i].data());
+            std::copy(newWeights[i].begin(), newWeights[i].begin() + Layer<T>::in_size, &weights[i * Layer<T>::in_size]);
     }
 
     /**
@@ -127,7 +127,7 @@ public:
     void setWeights(T** newWeights)
     {
         for(int i = 0; i < Layer<T>::out_size; ++i)
-            subLayers[i]->setWeights(newWeights[i]);
+            std::copy(newWeights[i], newWeights[i] + Layer<T>::in_size, &weights[i * Layer<T>::in_size]);
     }
 
     /**
@@ -136,21 +136,24 @@ public:
      */
     void setBias(T* b)
     {
-        for(int i = 0; i < Layer<T>::out_size; ++i)
-            subLayers[i]->setBias(b[i]);
+        std::copy(b, b + Layer<T>::out_size, bias);
     }
 
     /** Returns the weights value at the given indices. */
     T getWeight(int i, int k) const noexcept
     {
-        return subLayers[i]->getWeight(k);
+        return weights[i * Layer<T>::in_size + k];
     }
 
     /** Returns the bias value at the given index. */
-    T getBias(int i) const noexcept { return subLayers[i]->getBias(); }
+    T getBias(int i) const noexcept { return bias[i]; }
 
 private:
-    Dense1<T>** subLayers;
+    size_t numParameters() const noexcept { return (size_t)(Layer<T>::in_size + 1) * Layer<T>::out_size; }
+
+    std::vector<T> storage; // owns the parameters until they are bound to an arena
+    T* weights; // [out_size][in_size]
+    T* bias; // [out_size]
 };
 
 //====================================================
@@ -3,6 +3,7 @@
 
 #include "../Layer.h"
 #include <Eigen/Dense>
+#include <vector>
 
 namespace RTNeural
 {
@@ -18,12 +19,11 @@ public:
     /** Constructs a dense layer for a given input and output size. */
     Dense(int in_size, int out_size)
         : Layer<T>(in_size, out_size)
+        , storage((size_t)(in_size + 1) * out_size, (T)0)
+        , weights(nullptr, out_size, in_size)
+        , bias(nullptr, out_size)
     {
-        weights = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, in_size);
-        bias = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-
-        inVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(in_size, 1);
-        outVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
+        mapParameters(storage.data());
     }
 
     Dense(std::initializer_list<int> sizes)
@@ -49,11 +49,43 @@ public:
     /** Performs forward propagation for this layer. */
     inline void forward(const T* input, T* out) override
     {
-        inVec = Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, 1>, Eigen::Aligned16>(
+        auto inVec = Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, 1>, Eigen::Aligned16>(
             input, Layer<T>::in_size, 1);
-        outVec = weights * inVec + bias;
+        auto outVec = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>>(out, Layer<T>::out_size, 1);
+
+        // bias first, then accumulate the product in place: "weights * inVec + bias"
+        // would evaluate the product into a heap temporary
+        outVec = bias;
+        outVec.noalias() += weights * inVec;
+    }
+
+    /**
+     * Performs forward propagation for an input size known at compile time.
+     * Used by the execution plan of `Model` for common layer widths.
+     */
+    template <int N>
+    inline void forwardN(const T* input, T* out) noexcept
+    {
+        auto fixedWeights = Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, N>, Eigen::Aligned16>(
+            weights.data(), Layer<T>::out_size, N);
+        auto inVec = Eigen::Map<const Eigen::Matrix<T, N, 1>, Eigen::Aligned16>(input);
+        auto outVec = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>>(out, Layer<T>::out_size, 1);
+
+        outVec = bias;
+        outVec.noalias() += fixedWeights * inVec;
+    }
+
+    /** Returns the number of values needed to store the weights and bias. */
+    size_t getArenaSize() const noexcept override { return numParameters(); }
+
+    /** Moves the weights (column-major) and bias into the given block. */
+    void bindArena(T* block) override
+    {
+        std::copy(weights.data(), weights.data() + numParameters(), block);
+        mapParameters(block);
 
-        std::copy(outVec.data(), outVec.data() + Layer<T>::out_size, out);
+        storage.clear();
+        storage.shrink_to_fit();
     }
 
     /**
@@ -99,11 +131,21 @@ public:
     T getBias(int i) const noexcept { return bias(i, 0); }
 
 private:
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> weights;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> bias;
+    size_t numParameters() const noexcept { return (size_t)(Layer<T>::in_size + 1) * Layer<T>::out_size; }
+
+    /** Points the weights and bias at a block of numParameters() values. */
+    void mapParameters(T* block)
+    {
+        new(&weights) WeightsMap(block, Layer<T>::out_size, Layer<T>::in_size);
+        new(&bias) BiasMap(block + (size_t)Layer<T>::in_size * Layer<T>::out_size, Layer<T>::out_size);
+    }
+
+    using WeightsMap = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>, Eigen::Aligned16>;
+    using BiasMap = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>>;
 
-    Eigen::Matrix<T, Eigen::Dynamic, 1> inVec;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> outVec;
+    std::vector<T, Eigen::aligned_allocator<T>> storage; // owns the parameters until they are bound to an arena
+    WeightsMap weights;
+    BiasMap bias;
 };
 
 //====================================================
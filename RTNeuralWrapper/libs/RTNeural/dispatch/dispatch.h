@@ -0,0 +1,109 @@
+#ifndef DISPATCH_H_INCLUDED
+#define DISPATCH_H_INCLUDED
+
+#include <atomic>
+
+namespace RTNeural
+{
+/**
+ * Runtime CPU feature dispatch for the hot kernels of the dynamic (STL) layers.
+ *
+ * The kernels are compiled once per instruction set (see cmake/SIMDExtensions.cmake,
+ * option RTNEURAL_RUNTIME_DISPATCH) and the fastest table supported by the host
+ * is chosen by `selectKernels()`. Until `selectKernels()` is called, the generic
+ * (baseline ISA) kernels are used.
+ */
+namespace dispatch
+{
+
+    /** Instruction set levels that the kernels are compiled for. */
+    enum class ISA
+    {
+        Generic = 0,
+        SSE42,
+        AVX2,
+        AVX512,
+    };
+
+    /** Table of kernels compiled for one instruction set. */
+    template <typename T>
+    struct KernelTable
+    {
+        /** Returns the inner product of two vectors of size dim. */
+        T (*dot)(const T* a, const T* b, int dim);
+
+        /** out = weights * in + bias, with weights stored row-major as weights[out_size][in_size]. */
+        void (*gemv)(const T* weights, const T* bias, const T* in, T* out, int in_size, int out_size);
+
+        /** y += alpha * x, for vectors of size dim. */
+        void (*axpy)(T alpha, const T* x, T* y, int dim);
+
+        /** Element-wise activations, in and out may alias. */
+        void (*relu)(const T* in, T* out, int dim);
+        void (*tanh)(const T* in, T* out, int dim);
+        void (*fast_tanh)(const T* in, T* out, int dim);
+        void (*sigmoid)(const T* in, T* out, int dim);
+
+        /** Instruction set this table was compiled for. */
+        ISA isa;
+    };
+
+#ifndef DOXYGEN
+    namespace detail
+    {
+        extern const KernelTable<float> genericFloatKernels;
+        extern const KernelTable<double> genericDoubleKernels;
+#if RTNEURAL_DISPATCH_X86
+        extern const KernelTable<float> sse42FloatKernels;
+        extern const KernelTable<double> sse42DoubleKernels;
+        extern const KernelTable<float> avx2FloatKernels;
+        extern const KernelTable<double> avx2DoubleKernels;
+        extern const KernelTable<float> avx512FloatKernels;
+        extern const KernelTable<double> avx512DoubleKernels;
+#endif
+
+        // read by the layers of every thread, written by selectKernels()
+        extern std::atomic<const KernelTable<float>*> activeFloatKernels;
+        extern std::atomic<const KernelTable<double>*> activeDoubleKernels;
+    } // namespace detail
+#endif // DOXYGEN
+
+    /** Returns the best instruction set supported by the host CPU (and compiled into the library). */
+    ISA detectISA() noexcept;
+
+    /**
+     * Selects the kernel tables for the best instruction set supported by the host,
+     * capped to maxISA, and returns the selected instruction set.
+     *
+     * Not real-time safe on its first call: call it while creating the model.
+     * Thread safe, but models running on other threads may use the previous
+     * or the new kernels until the call returns: select once, at startup.
+     */
+    ISA selectKernels(ISA maxISA = ISA::AVX512) noexcept;
+
+    /** Returns the instruction set of the currently selected kernels. */
+    ISA getSelectedISA() noexcept;
+
+    /** Returns a printable name for an instruction set. */
+    const char* getISAName(ISA isa) noexcept;
+
+    /** Returns the currently selected kernel table. */
+    template <typename T>
+    inline const KernelTable<T>& kernels() noexcept;
+
+    template <>
+    inline const KernelTable<float>& kernels<float>() noexcept
+    {
+        return *detail::activeFloatKernels.load(std::memory_order_acquire);
+    }
+
+    template <>
+    inline const KernelTable<double>& kernels<double>() noexcept
+    {
+        return *detail::activeDoubleKernels.load(std::memory_order_acquire);
+    }
+
+} // namespace dispatch
+} // namespace RTNeural
+
+#endif // DISPATCH_H_INCLUDED
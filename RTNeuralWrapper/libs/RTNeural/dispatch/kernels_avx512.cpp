@@ -0,0 +1,14 @@
+#define RTNEURAL_DISPATCH_ISA ISA::AVX512
+#include "kernels_impl.h"
+
+namespace RTNeural
+{
+namespace dispatch
+{
+    namespace detail
+    {
+        const KernelTable<float> avx512FloatKernels = makeKernelTable<float>();
+        const KernelTable<double> avx512DoubleKernels = makeKernelTable<double>();
+    } // namespace detail
+} // namespace dispatch
+} // namespace RTNeural
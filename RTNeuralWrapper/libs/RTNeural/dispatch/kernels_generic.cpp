@@ -0,0 +1,80 @@
+#define RTNEURAL_DISPATCH_ISA ISA::Generic
+#include "kernels_impl.h"
+
+namespace RTNeural
+{
+namespace dispatch
+{
+    namespace detail
+    {
+        const KernelTable<float> genericFloatKernels = makeKernelTable<float>();
+        const KernelTable<double> genericDoubleKernels = makeKernelTable<double>();
+
+        std::atomic<const KernelTable<float>*> activeFloatKernels { &genericFloatKernels };
+        std::atomic<const KernelTable<double>*> activeDoubleKernels { &genericDoubleKernels };
+    } // namespace detail
+
+    ISA detectISA() noexcept
+    {
+#if RTNEURAL_DISPATCH_X86
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return ISA::AVX512;
+        if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return ISA::AVX2;
+        if(__builtin_cpu_supports("sse4.2"))
+            return ISA::SSE42;
+#endif
+        return ISA::Generic;
+    }
+
+    ISA selectKernels(ISA maxISA) noexcept
+    {
+        const auto isa = (int)detectISA() < (int)maxISA ? detectISA() : maxISA;
+
+        const KernelTable<float>* floatKernels = &detail::genericFloatKernels;
+        const KernelTable<double>* doubleKernels = &detail::genericDoubleKernels;
+        switch(isa)
+        {
+#if RTNEURAL_DISPATCH_X86
+        case ISA::AVX512:
+            floatKernels = &detail::avx512FloatKernels;
+            doubleKernels = &detail::avx512DoubleKernels;
+            break;
+        case ISA::AVX2:
+            floatKernels = &detail::avx2FloatKernels;
+            doubleKernels = &detail::avx2DoubleKernels;
+            break;
+        case ISA::SSE42:
+            floatKernels = &detail::sse42FloatKernels;
+            doubleKernels = &detail::sse42DoubleKernels;
+            break;
+#endif
+        default:
+            break;
+        }
+
+        detail::activeFloatKernels.store(floatKernels, std::memory_order_release);
+        detail::activeDoubleKernels.store(doubleKernels, std::memory_order_release);
+
+        return getSelectedISA();
+    }
+
+    ISA getSelectedISA() noexcept
+    {
+        return detail::activeFloatKernels.load(std::memory_order_acquire)->isa;
+    }
+
+    const char* getISAName(ISA isa) noexcept
+    {
+        switch(isa)
+        {
+        case ISA::SSE42: return "SSE4.2";
+        case ISA::AVX2: return "AVX2";
+        case ISA::AVX512: return "AVX-512";
+        default: return "generic";
+        }
+    }
+
+} // namespace dispatch
+} // namespace RTNeural
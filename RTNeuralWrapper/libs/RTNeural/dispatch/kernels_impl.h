@@ -0,0 +1,100 @@
+/**
+ * Kernel implementations shared by the per-ISA translation units.
+ *
+ * This file is included once by each kernels_<isa>.cpp, which is compiled
+ * with the matching target flags. Everything here lives in an anonymous
+ * namespace so that code generated for one instruction set can never be
+ * merged by the linker into the translation unit of another one.
+ */
+#include "dispatch.h"
+
+#include <math.h>
+
+#ifndef RTNEURAL_DISPATCH_ISA
+#error "RTNEURAL_DISPATCH_ISA must be defined before including kernels_impl.h"
+#endif
+
+namespace RTNeural
+{
+namespace dispatch
+{
+    namespace
+    {
+        // libm entry points are called directly (rather than through the inline
+        // std:: overloads) so no inline function is shared between the ISA units.
+        inline float tanhScalar(float x) { return ::tanhf(x); }
+        inline double tanhScalar(double x) { return ::tanh(x); }
+        inline float expScalar(float x) { return ::expf(x); }
+        inline double expScalar(double x) { return ::exp(x); }
+
+        template <typename T>
+        T dot(const T* a, const T* b, int dim)
+        {
+            T sum = (T)0;
+#pragma omp simd reduction(+ : sum)
+            for(int i = 0; i < dim; ++i)
+                sum += a[i] * b[i];
+            return sum;
+        }
+
+        template <typename T>
+        void gemv(const T* weights, const T* bias, const T* in, T* out, int in_size, int out_size)
+        {
+            for(int i = 0; i < out_size; ++i)
+                out[i] = dot(weights + (long)i * in_size, in, in_size) + bias[i];
+        }
+
+        template <typename T>
+        void axpy(T alpha, const T* x, T* y, int dim)
+        {
+#pragma omp simd
+            for(int i = 0; i < dim; ++i)
+                y[i] += alpha * x[i];
+        }
+
+        template <typename T>
+        void relu(const T* in, T* out, int dim)
+        {
+#pragma omp simd
+            for(int i = 0; i < dim; ++i)
+                out[i] = in[i] > (T)0 ? in[i] : (T)0;
+        }
+
+        template <typename T>
+        void tanh(const T* in, T* out, int dim)
+        {
+            for(int i = 0; i < dim; ++i)
+                out[i] = tanhScalar(in[i]);
+        }
+
+        /** Same Pade approximation as RTNeural::tanh_approx(), written so that it vectorizes. */
+        template <typename T>
+        void fast_tanh(const T* in, T* out, int dim)
+        {
+#pragma omp simd
+            for(int i = 0; i < dim; ++i)
+            {
+                T x = in[i];
+                x = x > (T)5.7 ? (T)5.7 : (x < (T)-5.7 ? (T)-5.7 : x);
+                const T x2 = x * x;
+                const T numerator = x * ((T)2027025 + x2 * ((T)270270 + x2 * ((T)6930 + (T)36 * x2)));
+                const T denominator = (T)2027025 + x2 * ((T)945945 + x2 * ((T)51975 + x2 * ((T)630 + x2)));
+                out[i] = numerator / denominator;
+            }
+        }
+
+        template <typename T>
+        void sigmoid(const T* in, T* out, int dim)
+        {
+            for(int i = 0; i < dim; ++i)
+                out[i] = (T)1 / ((T)1 + expScalar(-in[i]));
+        }
+
+        template <typename T>
+        constexpr KernelTable<T> makeKernelTable()
+        {
+            return { &dot<T>, &gemv<T>, &axpy<T>, &relu<T>, &tanh<T>, &fast_tanh<T>, &sigmoid<T>, RTNEURAL_DISPATCH_ISA };
+        }
+    } // namespace
+} // namespace dispatch
+} // namespace RTNeural
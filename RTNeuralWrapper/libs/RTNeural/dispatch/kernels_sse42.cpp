@@ -0,0 +1,14 @@
+#define RTNEURAL_DISPATCH_ISA ISA::SSE42
+#include "kernels_impl.h"
+
+namespace RTNeural
+{
+namespace dispatch
+{
+    namespace detail
+    {
+        const KernelTable<float> sse42FloatKernels = makeKernelTable<float>();
+        const KernelTable<double> sse42DoubleKernels = makeKernelTable<double>();
+    } // namespace detail
+} // namespace dispatch
+} // namespace RTNeural
@@ -45,6 +45,12 @@ public:
     /** Returns the name of this layer. */
     std::string getName() const noexcept override { return "gru"; }
 
+    /** Returns the number of weights and state values of this layer. */
+    size_t getArenaSize() const noexcept override { return numValues(); }
+
+    /** Moves the weights and the recurrent state into the given block. */
+    void bindArena(T* block) override;
+
     /** Performs forward propagation for this layer. */
     virtual inline void forward(const T* input, T* h) override
     {
@@ -111,6 +117,15 @@ public:
     T getBVal(int i, int k) const noexcept;
 
 protected:
+    /** Number of weights and state values held in `storage` or in the arena. */
+    size_t numValues() const noexcept { return 3 * zWeights.numValues() + 4 * (size_t)Layer<T>::out_size; }
+
+    /** Points the weight sets and the state vectors at the given block of `numValues()` values. */
+    void mapValues(T* block);
+
+    std::vector<T> storage; // owns the weights and state until they are bound to an arena
+    T* values; // start of the weights and state
+
     T* ht1;
 
     /** Struct to hold layer weights (used internally) */
@@ -119,9 +134,16 @@ protected:
         WeightSet(int in_size, int out_size);
         ~WeightSet();
 
+        /** Returns the number of weights in this set. */
+        size_t numValues() const noexcept { return (size_t)out_size * (in_size + out_size + kNumBiasLayers); }
+
+        /** Points the rows of this set at the given block of `numValues()` values. */
+        void mapValues(T* block);
+
         T** W; // kernel weights
         T** U; // recurrent weights
         T** b; // bias
+        const int in_size;
         const int out_size;
     };
 
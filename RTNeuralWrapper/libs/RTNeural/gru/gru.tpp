@@ -11,10 +11,8 @@ GRULayer<T>::GRULayer(int in_size, int out_size)
     , rWeights(in_size, out_size)
     , cWeights(in_size, out_size)
 {
-    ht1 = new T[out_size];
-    zVec = new T[out_size];
-    rVec = new T[out_size];
-    cVec = new T[out_size];
+    storage.resize(numValues(), (T)0);
+    mapValues(storage.data());
 }
 
 template <typename T>
@@ -36,53 +34,68 @@ GRULayer<T>& GRULayer<T>::operator=(const GRULayer<T>& other)
 }
 
 template <typename T>
-GRULayer<T>::~GRULayer()
+GRULayer<T>::~GRULayer() = default;
+
+template <typename T>
+void GRULayer<T>::mapValues(T* block)
+{
+    values = block;
+
+    for(auto* set : { &zWeights, &rWeights, &cWeights })
+    {
+        set->mapValues(block);
+        block += set->numValues();
+    }
+
+    ht1 = block;
+    zVec = ht1 + Layer<T>::out_size;
+    rVec = zVec + Layer<T>::out_size;
+    cVec = rVec + Layer<T>::out_size;
+}
+
+template <typename T>
+void GRULayer<T>::bindArena(T* block)
 {
-    delete[] ht1;
-    delete[] zVec;
-    delete[] rVec;
-    delete[] cVec;
+    std::copy(values, values + numValues(), block);
+    mapValues(block);
+
+    storage.clear();
+    storage.shrink_to_fit();
 }
 
 template <typename T>
 GRULayer<T>::WeightSet::WeightSet(int in_size, int out_size)
-    : out_size(out_size)
+    : in_size(in_size)
+    , out_size(out_size)
 {
     W = new T*[out_size];
     U = new T*[out_size];
     b = new T*[kNumBiasLayers];
-
-    for(int i = 0; i < kNumBiasLayers; ++i)
-    {
-        b[i] = new T[out_size];
-    }
-
-    for(int i = 0; i < out_size; ++i)
-    {
-        W[i] = new T[in_size];
-        U[i] = new T[out_size];
-    }
 }
 
 template <typename T>
 GRULayer<T>::WeightSet::~WeightSet()
 {
-    for(int i = 0; i < kNumBiasLayers; ++i)
-    {
-        delete[] b[i];
-    }
-
-    for(int i = 0; i < out_size; ++i)
-    {
-        delete[] W[i];
-        delete[] U[i];
-    }
-
     delete[] b;
     delete[] W;
     delete[] U;
 }
 
+template <typename T>
+void GRULayer<T>::WeightSet::mapValues(T* block)
+{
+    for(int i = 0; i < out_size; ++i)
+        W[i] = block + (size_t)i * in_size;
+
+    block += (size_t)out_size * in_size;
+    for(int i = 0; i < out_size; ++i)
+        U[i] = block + (size_t)i * out_size;
+
+    block += (size_t)out_size * out_size;
+    for(int i = 0; i < kNumBiasLayers; ++i)
+        b[i] = block + (size_t)i * out_size;
+}
+
 template <typename T>
 void GRULayer<T>::setWVals(const std::vector<std::vector<T>>& wVals)
 {
@@ -3,6 +3,7 @@
 
 #include "../Layer.h"
 #include "../common.h"
+#include <vector>
 
 namespace RTNeural
 {
@@ -35,6 +36,12 @@ public:
     /** Returns the name of this layer. */
     std::string getName() const noexcept override { return "gru"; }
 
+    /** Returns the number of weights and state values of this layer. */
+    size_t getArenaSize() const noexcept override { return numValues(); }
+
+    /** Moves the weights and the recurrent state into the given block. */
+    void bindArena(T* block) override;
+
     /** Performs forward propagation for this layer. */
     inline void forward(const T* input, T* h) override
     {
@@ -88,23 +95,39 @@ public:
     T getBVal(int i, int k) const noexcept;
 
 private:
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> wVec_z;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> wVec_r;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> wVec_c;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> uVec_z;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> uVec_r;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> uVec_c;
-    Eigen::Matrix<T, Eigen::Dynamic, 2> bVec_z;
-    Eigen::Matrix<T, Eigen::Dynamic, 2> bVec_r;
-    Eigen::Matrix<T, Eigen::Dynamic, 2> bVec_c;
-
-    Eigen::Matrix<T, Eigen::Dynamic, 1> ht1;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> zVec;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> rVec;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> cVec;
-
-    Eigen::Matrix<T, Eigen::Dynamic, 1> inVec;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> ones;
+    using MatrixMap = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>>;
+    using BiasMap = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 2>>;
+    using VectorMap = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>>;
+
+    /** Number of weights and state values held in `storage` or in the arena. */
+    size_t numValues() const noexcept
+    {
+        return 3 * (size_t)Layer<T>::out_size * (Layer<T>::in_size + Layer<T>::out_size + 2)
+            + 5 * (size_t)Layer<T>::out_size + Layer<T>::in_size;
+    }
+
+    /** Points the weight matrices and the state vectors at the given block of `numValues()` values. */
+    void mapValues(T* block);
+
+    std::vector<T, Eigen::aligned_allocator<T>> storage; // owns the weights and state until they are bound to an arena
+
+    MatrixMap wVec_z;
+    MatrixMap wVec_r;
+    MatrixMap wVec_c;
+    MatrixMap uVec_z;
+    MatrixMap uVec_r;
+    MatrixMap uVec_c;
+    BiasMap bVec_z;
+    BiasMap bVec_r;
+    BiasMap bVec_c;
+
+    VectorMap ht1;
+    VectorMap zVec;
+    VectorMap rVec;
+    VectorMap cVec;
+
+    VectorMap inVec;
+    VectorMap ones;
 };
 
 //====================================================
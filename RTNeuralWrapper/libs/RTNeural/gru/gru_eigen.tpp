@@ -8,24 +8,62 @@ namespace RTNeural
 template <typename T>
 GRULayer<T>::GRULayer(int in_size, int out_size)
     : Layer<T>(in_size, out_size)
+    , storage(numValues(), (T)0)
+    , wVec_z(nullptr, out_size, in_size)
+    , wVec_r(nullptr, out_size, in_size)
+    , wVec_c(nullptr, out_size, in_size)
+    , uVec_z(nullptr, out_size, out_size)
+    , uVec_r(nullptr, out_size, out_size)
+    , uVec_c(nullptr, out_size, out_size)
+    , bVec_z(nullptr, out_size, 2)
+    , bVec_r(nullptr, out_size, 2)
+    , bVec_c(nullptr, out_size, 2)
+    , ht1(nullptr, out_size)
+    , zVec(nullptr, out_size)
+    , rVec(nullptr, out_size)
+    , cVec(nullptr, out_size)
+    , inVec(nullptr, in_size)
+    , ones(nullptr, out_size)
 {
-    wVec_z = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, in_size);
-    wVec_r = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, in_size);
-    wVec_c = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, in_size);
-    uVec_z = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, out_size);
-    uVec_r = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, out_size);
-    uVec_c = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, out_size);
-    bVec_z = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 2);
-    bVec_r = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 2);
-    bVec_c = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 2);
-
-    ht1 = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    zVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    rVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    cVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-
-    inVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(in_size, 1);
-    ones = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Ones(out_size, 1);
+    mapValues(storage.data());
+    ones.setOnes();
+}
+
+template <typename T>
+void GRULayer<T>::mapValues(T* block)
+{
+    const auto in_size = Layer<T>::in_size;
+    const auto out_size = Layer<T>::out_size;
+    auto next = [&block](size_t size) {
+        auto* values = block;
+        block += size;
+        return values;
+    };
+
+    for(auto* W : { &wVec_z, &wVec_r, &wVec_c })
+        new(W) MatrixMap(next((size_t)out_size * in_size), out_size, in_size);
+
+    for(auto* U : { &uVec_z, &uVec_r, &uVec_c })
+        new(U) MatrixMap(next((size_t)out_size * out_size), out_size, out_size);
+
+    for(auto* b : { &bVec_z, &bVec_r, &bVec_c })
+        new(b) BiasMap(next((size_t)out_size * 2), out_size, 2);
+
+    for(auto* vec : { &ht1, &zVec, &rVec, &cVec })
+        new(vec) VectorMap(next(out_size), out_size);
+
+    new(&inVec) VectorMap(next(in_size), in_size);
+    new(&ones) VectorMap(next(out_size), out_size);
+}
+
+template <typename T>
+void GRULayer<T>::bindArena(T* block)
+{
+    std::copy(wVec_z.data(), wVec_z.data() + numValues(), block);
+    mapValues(block);
+
+    storage.clear();
+    storage.shrink_to_fit();
 }
 
 template <typename T>
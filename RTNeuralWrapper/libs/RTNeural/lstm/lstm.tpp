@@ -13,14 +13,8 @@ LSTMLayer<T>::LSTMLayer(int in_size, int out_size)
     , oWeights(in_size, out_size)
     , cWeights(in_size, out_size)
 {
-    ht1 = new T[out_size];
-    ct1 = new T[out_size];
-
-    fVec = new T[out_size];
-    iVec = new T[out_size];
-    oVec = new T[out_size];
-    ctVec = new T[out_size];
-    cVec = new T[out_size];
+    storage.resize(numValues(), (T)0);
+    mapValues(storage.data());
 }
 
 template <typename T>
@@ -42,16 +36,37 @@ LSTMLayer<T>& LSTMLayer<T>::operator=(const LSTMLayer<T>& other)
 }
 
 template <typename T>
-LSTMLayer<T>::~LSTMLayer()
+LSTMLayer<T>::~LSTMLayer() = default;
+
+template <typename T>
+void LSTMLayer<T>::mapValues(T* block)
+{
+    values = block;
+
+    for(auto* set : { &fWeights, &iWeights, &oWeights, &cWeights })
+    {
+        set->mapValues(block);
+        block += set->numValues();
+    }
+
+    ht1 = block;
+    ct1 = ht1 + Layer<T>::out_size;
+
+    fVec = ct1 + Layer<T>::out_size;
+    iVec = fVec + Layer<T>::out_size;
+    oVec = iVec + Layer<T>::out_size;
+    ctVec = oVec + Layer<T>::out_size;
+    cVec = ctVec + Layer<T>::out_size;
+}
+
+template <typename T>
+void LSTMLayer<T>::bindArena(T* block)
 {
-    delete[] ht1;
-    delete[] ct1;
+    std::copy(values, values + numValues(), block);
+    mapValues(block);
 
-    delete[] fVec;
-    delete[] iVec;
-    delete[] oVec;
-    delete[] ctVec;
-    delete[] cVec;
+    storage.clear();
+    storage.shrink_to_fit();
 }
 
 template <typename T>
@@ -63,32 +78,31 @@ void LSTMLayer<T>::reset()
 
 template <typename T>
 LSTMLayer<T>::WeightSet::WeightSet(int in_size, int out_size)
-    : out_size(out_size)
+    : in_size(in_size)
+    , out_size(out_size)
 {
     W = new T*[out_size];
     U = new T*[out_size];
-    b = new T[out_size];
-
-    for(int i = 0; i < out_size; ++i)
-    {
-        W[i] = new T[in_size];
-        U[i] = new T[out_size];
-    }
 }
 
 template <typename T>
 LSTMLayer<T>::WeightSet::~WeightSet()
 {
-    delete[] b;
+    delete[] W;
+    delete[] U;
+}
 
+template <typename T>
+void LSTMLayer<T>::WeightSet::mapValues(T* block)
+{
     for(int i = 0; i < out_size; ++i)
-    {
-        delete[] W[i];
-        delete[] U[i];
-    }
+        W[i] = block + (size_t)i * in_size;
 
-    delete[] W;
-    delete[] U;
+    block += (size_t)out_size * in_size;
+    for(int i = 0; i < out_size; ++i)
+        U[i] = block + (size_t)i * out_size;
+
+    b = block + (size_t)out_size * out_size;
 }
 
 template <typename T>
@@ -3,6 +3,7 @@
 
 #include "../Layer.h"
 #include "../common.h"
+#include <vector>
 
 namespace RTNeural
 {
@@ -32,6 +33,12 @@ public:
     /** Resets the state of the LSTM. */
     void reset() override;
 
+    /** Returns the number of weights and state values of this layer. */
+    size_t getArenaSize() const noexcept override { return numValues(); }
+
+    /** Moves the weights and the recurrent state into the given block. */
+    void bindArena(T* block) override;
+
     /** Performs forward propagation for this layer. */
     inline void forward(const T* input, T* h) override
     {
@@ -77,28 +84,43 @@ public:
     void setBVals(const std::vector<T>& bVals);
 
 private:
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> Wf;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> Wi;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> Wo;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> Wc;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> Uf;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> Ui;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> Uo;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> Uc;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> bf;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> bi;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> bo;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> bc;
-
-    Eigen::Matrix<T, Eigen::Dynamic, 1> fVec;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> iVec;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> oVec;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> ctVec;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> cVec;
-
-    Eigen::Matrix<T, Eigen::Dynamic, 1> inVec;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> ht1;
-    Eigen::Matrix<T, Eigen::Dynamic, 1> ct1;
+    using MatrixMap = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>>;
+    using VectorMap = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>>;
+
+    /** Number of weights and state values held in `storage` or in the arena. */
+    size_t numValues() const noexcept
+    {
+        return 4 * (size_t)Layer<T>::out_size * (Layer<T>::in_size + Layer<T>::out_size + 1)
+            + 7 * (size_t)Layer<T>::out_size + Layer<T>::in_size;
+    }
+
+    /** Points the weight matrices and the state vectors at the given block of `numValues()` values. */
+    void mapValues(T* block);
+
+    std::vector<T, Eigen::aligned_allocator<T>> storage; // owns the weights and state until they are bound to an arena
+
+    MatrixMap Wf;
+    MatrixMap Wi;
+    MatrixMap Wo;
+    MatrixMap Wc;
+    MatrixMap Uf;
+    MatrixMap Ui;
+    MatrixMap Uo;
+    MatrixMap Uc;
+    VectorMap bf;
+    VectorMap bi;
+    VectorMap bo;
+    VectorMap bc;
+
+    VectorMap fVec;
+    VectorMap iVec;
+    VectorMap oVec;
+    VectorMap ctVec;
+    VectorMap cVec;
+
+    VectorMap inVec;
+    VectorMap ht1;
+    VectorMap ct1;
 };
 
 //====================================================
@@ -6,31 +6,64 @@ namespace RTNeural
 template <typename T>
 LSTMLayer<T>::LSTMLayer(int in_size, int out_size)
     : Layer<T>(in_size, out_size)
+    , storage(numValues(), (T)0)
+    , Wf(nullptr, out_size, in_size)
+    , Wi(nullptr, out_size, in_size)
+    , Wo(nullptr, out_size, in_size)
+    , Wc(nullptr, out_size, in_size)
+    , Uf(nullptr, out_size, out_size)
+    , Ui(nullptr, out_size, out_size)
+    , Uo(nullptr, out_size, out_size)
+    , Uc(nullptr, out_size, out_size)
+    , bf(nullptr, out_size)
+    , bi(nullptr, out_size)
+    , bo(nullptr, out_size)
+    , bc(nullptr, out_size)
+    , fVec(nullptr, out_size)
+    , iVec(nullptr, out_size)
+    , oVec(nullptr, out_size)
+    , ctVec(nullptr, out_size)
+    , cVec(nullptr, out_size)
+    , inVec(nullptr, in_size)
+    , ht1(nullptr, out_size)
+    , ct1(nullptr, out_size)
 {
-    Wf = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, in_size);
-    Wi = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, in_size);
-    Wo = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, in_size);
-    Wc = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, in_size);
-
-    Uf = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, out_size);
-    Ui = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, out_size);
-    Uo = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, out_size);
-    Uc = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, out_size);
-
-    bf = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    bi = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    bo = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    bc = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-
-    fVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    iVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    oVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    ctVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    cVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-
-    inVec = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    ht1 = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
-    ct1 = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, 1);
+    mapValues(storage.data());
+}
+
+template <typename T>
+void LSTMLayer<T>::mapValues(T* block)
+{
+    const auto in_size = Layer<T>::in_size;
+    const auto out_size = Layer<T>::out_size;
+    auto next = [&block](size_t size) {
+        auto* values = block;
+        block += size;
+        return values;
+    };
+
+    for(auto* W : { &Wf, &Wi, &Wo, &Wc })
+        new(W) MatrixMap(next((size_t)out_size * in_size), out_size, in_size);
+
+    for(auto* U : { &Uf, &Ui, &Uo, &Uc })
+        new(U) MatrixMap(next((size_t)out_size * out_size), out_size, out_size);
+
+    for(auto* vec : { &bf, &bi, &bo, &bc, &fVec, &iVec, &oVec, &ctVec, &cVec })
+        new(vec) VectorMap(next(out_size), out_size);
+
+    new(&inVec) VectorMap(next(in_size), in_size);
+    new(&ht1) VectorMap(next(out_size), out_size);
+    new(&ct1) VectorMap(next(out_size), out_size);
+}
+
+template <typename T>
+void LSTMLayer<T>::bindArena(T* block)
+{
+    std::copy(Wf.data(), Wf.data() + numValues(), block);
+    mapValues(block);
+
+    storage.clear();
+    storage.shrink_to_fit();
 }
 
 template <typename T>
@@ -146,6 +146,158 @@ namespace json_parser
         return true;
     }
 
+    /** Reads the rows, columns and channels of a feature map shape [None, rows, cols(, channels)]. */
+    inline bool getFeatureMapShape(const nlohmann::json& shape, int& rows, int& cols, int& channels)
+    {
+        if(!shape.is_array() || (shape.size() != 3 && shape.size() != 4))
+            return false;
+
+        for(size_t i = 1; i < shape.size(); ++i)
+            if(!shape[i].is_number_integer())
+                return false;
+
+        rows = shape[1].get<int>();
+        cols = shape[2].get<int>();
+        channels = shape.size() == 4 ? shape[3].get<int>() : 1;
+        return true;
+    }
+
+    /**
+     * Returns the input size of a model: the whole feature map when
+     * the first layer is a 2D convolution, the last dimension otherwise.
+     */
+    inline int getModelInSize(const nlohmann::json& parent)
+    {
+        const auto shape = parent["in_shape"];
+        const auto layers = parent["layers"];
+
+        int rows, cols, channels;
+        if(!layers.empty() && layers[0]["type"] == "conv2d" && getFeatureMapShape(shape, rows, cols, channels))
+            return rows * cols * channels;
+
+        return shape.back().get<int>();
+    }
+
+    /**
+     * Returns the output size of a layer: the whole feature map for
+     * a 2D convolution, the last dimension otherwise.
+     */
+    inline int getLayerOutSize(const nlohmann::json& l)
+    {
+        const auto layerShape = l["shape"];
+
+        int rows, cols, channels;
+        if(l["type"] == "conv2d" && getFeatureMapShape(layerShape, rows, cols, channels))
+            return rows * cols * channels;
+
+        return layerShape.back().get<int>();
+    }
+
+    /**
+     * Reads the dimensions of a 2D convolution from its json representation,
+     * for an input feature map of the given size.
+     */
+    inline Conv2DShape getConv2DShape(const nlohmann::json& l, int in_rows, int in_cols, int num_filters_in)
+    {
+        const auto kernel = l["kernel_size"];
+        const auto strides = l.contains("strides") ? l["strides"] : nlohmann::json { 1, 1 };
+        const auto dilation = l.contains("dilation") ? l["dilation"] : nlohmann::json { 1, 1 };
+        const auto padding = l.contains("padding") ? l["padding"].get<std::string>() : std::string("valid");
+
+        return { num_filters_in, l["shape"].back().get<int>(), in_rows, in_cols,
+            kernel[0].get<int>(), kernel[1].get<int>(),
+            strides[0].get<int>(), strides[1].get<int>(),
+            dilation[0].get<int>(), dilation[1].get<int>(),
+            padding != "same" };
+    }
+
+    /** Loads weights for a Conv2D (or Conv2DT) layer from a json representation of the layer weights. */
+    template <typename T, typename Conv2DType>
+    void loadConv2D(Conv2DType& conv, const nlohmann::json& weights)
+    {
+        const Conv2DShape s = conv.getShape();
+
+        // TensorFlow stores the kernel as [kernel_rows][kernel_cols][num_filters_in][num_filters_out]
+        std::vector<std::vector<std::vector<std::vector<T>>>> convWeights(s.num_filters_out,
+            std::vector<std::vector<std::vector<T>>>(s.num_filters_in,
+                std::vector<std::vector<T>>(s.kernel_rows, std::vector<T>(s.kernel_cols, (T)0))));
+
+        const auto& layerWeights = weights[0];
+        for(int kr = 0; kr < s.kernel_rows; ++kr)
+            for(int kc = 0; kc < s.kernel_cols; ++kc)
+                for(int i = 0; i < s.num_filters_in; ++i)
+                    for(int o = 0; o < s.num_filters_out; ++o)
+                        convWeights[o][i][kr][kc] = layerWeights[kr][kc][i][o].get<T>();
+
+        conv.setWeights(convWeights);
+
+        // load biases
+        std::vector<T> convBias = weights[1].get<std::vector<T>>();
+        conv.setBias(convBias);
+    }
+
+    /** Creates a Conv2D layer from a json representation of the layer weights. */
+    template <typename T>
+    std::unique_ptr<Conv2D<T>> createConv2D(const Conv2DShape& shape, const nlohmann::json& weights)
+    {
+        auto conv = std::make_unique<Conv2D<T>>(shape);
+        loadConv2D<T>(*conv.get(), weights);
+        return std::move(conv);
+    }
+
+    /** Creates a StreamingConv2D layer from a json representation of the layer weights. */
+    template <typename T>
+    std::unique_ptr<StreamingConv2D<T>> createStreamingConv2D(const Conv2DShape& shape, int num_frames, const nlohmann::json& weights)
+    {
+        auto conv = std::make_unique<StreamingConv2D<T>>(shape, num_frames);
+        loadConv2D<T>(*conv.get(), weights);
+        return std::move(conv);
+    }
+
+    /** Checks that a Conv2D (or Conv2DT) layer has the given dimensions. */
+    template <typename T, typename Conv2DType>
+    bool checkConv2D(const Conv2DType& conv, const std::string& type, const Conv2DShape& shape, const bool debug)
+    {
+        if(type != "conv2d")
+        {
+            debug_print("Wrong layer type! Expected: Conv2D", debug);
+            return false;
+        }
+
+        const Conv2DShape s = conv.getShape();
+        if(shape.num_filters_out != s.num_filters_out)
+        {
+            debug_print("Wrong number of filters! Expected: " + std::to_string(s.num_filters_out), debug);
+            return false;
+        }
+
+        if(shape.kernel_rows != s.kernel_rows || shape.kernel_cols != s.kernel_cols)
+        {
+            debug_print("Wrong kernel size! Expected: " + std::to_string(s.kernel_rows) + "x" + std::to_string(s.kernel_cols), debug);
+            return false;
+        }
+
+        if(shape.stride_rows != s.stride_rows || shape.stride_cols != s.stride_cols)
+        {
+            debug_print("Wrong strides! Expected: " + std::to_string(s.stride_rows) + "x" + std::to_string(s.stride_cols), debug);
+            return false;
+        }
+
+        if(shape.dilation_rows != s.dilation_rows || shape.dilation_cols != s.dilation_cols)
+        {
+            debug_print("Wrong dilation_rate! Expected: " + std::to_string(s.dilation_rows) + "x" + std::to_string(s.dilation_cols), debug);
+            return false;
+        }
+
+        if(shape.valid_pad != s.valid_pad)
+        {
+            debug_print(std::string("Wrong padding! Expected: ") + (s.valid_pad ? "valid" : "same"), debug);
+            return false;
+        }
+
+        return true;
+    }
+
     /** Loads weights for a GRULayer (or GRULayerT) from a json representation of the layer weights. */
     template <typename T, typename GRUType>
     void loadGRU(GRUType& gru, const nlohmann::json& weights)
@@ -330,9 +482,13 @@ namespace json_parser
         return true;
     }
 
-    /** Creates a neural network model from a json stream. */
+    /**
+     * Creates a neural network model from a json stream, see parseJson() and
+     * parseStreamingJson(). num_frames is 0 for a whole-window model.
+     */
     template <typename T>
-    std::unique_ptr<Model<T>> parseJson(const nlohmann::json& parent, const bool debug = false)
+    std::unique_ptr<Model<T>> createModel(const nlohmann::json& parent, int num_frames, const bool debug,
+        const MemoryPlanOptions& memoryOptions)
     {
         auto shape = parent["in_shape"];
         auto layers = parent["layers"];
@@ -340,14 +496,37 @@ namespace json_parser
         if(!shape.is_array() || !layers.is_array())
             return {};
 
-        const auto nDims = shape.back().get<int>();
+        // feature map entering the next layer, for 2D convolutions
+        int mapRows = 0, mapCols = 0, mapChannels = 0;
+        bool hasFeatureMap = getFeatureMapShape(shape, mapRows, mapCols, mapChannels);
+
+        // the leading conv2d layers of a streaming model take num_frames rows of the feature map at each call
+        bool streaming = num_frames > 0;
+        if(streaming && (!hasFeatureMap || layers.empty() || layers[0]["type"] != "conv2d"))
+        {
+            debug_print("Streaming models must start with a conv2d layer!", debug);
+            return {};
+        }
+
+        const auto nDims = streaming ? num_frames * mapCols * mapChannels : getModelInSize(parent);
         debug_print("# dimensions: " + std::to_string(nDims), debug);
 
         auto model = std::make_unique<Model<T>>(nDims);
 
+        // rebuilds the whole-window feature map of the last streaming layer
+        auto add_window = [&]() {
+            debug_print("Layer: streaming-window (" + std::to_string(mapRows) + " frames)", debug);
+            auto window = std::make_unique<StreamingWindow<T>>(mapCols * mapChannels, mapRows, num_frames);
+            model->addLayer(window.release());
+            streaming = false;
+        };
+
         for(const auto& l : layers)
         {
             const auto type = l["type"].get<std::string>();
+            if(streaming && type != "conv2d")
+                add_window();
+
             debug_print("Layer: " + type, debug);
 
             const auto layerShape = l["shape"];
@@ -363,7 +542,7 @@ namespace json_parser
                     if(!activationType.empty())
                     {
                         debug_print("  activation: " + activationType, debug);
-                        auto activation = createActivation<T>(activationType, layerDims);
+                        auto activation = createActivation<T>(activationType, _model->getNextInSize());
                         _model->addLayer(activation.release());
                     }
                 }
@@ -384,6 +563,50 @@ namespace json_parser
                 model->addLayer(conv.release());
                 add_activation(model, l);
             }
+            else if(type == "conv2d")
+            {
+                if(!hasFeatureMap)
+                {
+                    debug_print("Conv2D input must be a feature map [None, rows, cols(, channels)]!", debug);
+                    return {};
+                }
+
+                const auto convShape = getConv2DShape(l, mapRows, mapCols, mapChannels);
+                if(convShape.kernel_rows <= 0 || convShape.kernel_cols <= 0 || convShape.stride_rows <= 0
+                    || convShape.stride_cols <= 0 || convShape.dilation_rows <= 0 || convShape.dilation_cols <= 0
+                    || convShape.outRows() <= 0 || convShape.outCols() <= 0)
+                {
+                    debug_print("Invalid Conv2D dimensions!", debug);
+                    return {};
+                }
+
+                debug_print("  Output: " + std::to_string(convShape.outRows()) + "x" + std::to_string(convShape.outCols())
+                        + "x" + std::to_string(convShape.num_filters_out),
+                    debug);
+
+                if(streaming)
+                {
+                    if(convShape.stride_rows != 1 || !(convShape.valid_pad || convShape.kernel_rows == 1))
+                    {
+                        debug_print("Streaming Conv2D needs a stride of 1 and no padding along the rows!", debug);
+                        return {};
+                    }
+
+                    auto conv = createStreamingConv2D<T>(convShape, num_frames, weights);
+                    model->addLayer(conv.release());
+                }
+                else
+                {
+                    auto conv = createConv2D<T>(convShape, weights);
+                    model->addLayer(conv.release());
+                }
+                add_activation(model, l);
+
+                mapRows = convShape.outRows();
+                mapCols = convShape.outCols();
+                mapChannels = convShape.num_filters_out;
+                continue;
+            }
             else if(type == "gru")
             {
                 auto gru = createGRU<T>(model->getNextInSize(), layerDims, weights);
@@ -394,18 +617,77 @@ namespace json_parser
                 auto lstm = createLSTM<T>(model->getNextInSize(), layerDims, weights);
                 model->addLayer(lstm.release());
             }
+
+            hasFeatureMap = false;
         }
 
+        if(streaming)
+            add_window();
+
+        model->planMemory(memoryOptions);
+        debug_print("Memory arena: " + std::to_string(model->getArena().size()) + " bytes"
+                + (model->getArena().isHugePageBacked() ? " (huge pages)" : ""),
+            debug);
+
+        for(const auto& name : model->getLayersOutsideArena())
+            debug_print("  Layer outside the arena: " + name, debug);
+
         return std::move(model);
     }
 
+    /**
+     * Creates a neural network model from a json stream.
+     * The memory of the model is placed in one arena with the given options, see `Model::planMemory()`.
+     */
+    template <typename T>
+    std::unique_ptr<Model<T>> parseJson(const nlohmann::json& parent, const bool debug = false,
+        const MemoryPlanOptions& memoryOptions = {})
+    {
+        return createModel<T>(parent, 0, debug, memoryOptions);
+    }
+
     /** Creates a neural network model from a json stream. */
     template <typename T>
-    std::unique_ptr<Model<T>> parseJson(std::ifstream& jsonStream, const bool debug = false)
+    std::unique_ptr<Model<T>> parseJson(std::ifstream& jsonStream, const bool debug = false,
+        const MemoryPlanOptions& memoryOptions = {})
+    {
+        nlohmann::json parent;
+        jsonStream >> parent;
+        return parseJson<T>(parent, debug, memoryOptions);
+    }
+
+    /**
+     * Creates a streaming model from a json stream, for a model whose input
+     * feature map slides along its rows (e.g. frames of a spectrogram).
+     *
+     * The leading conv2d layers become `StreamingConv2D` layers, followed by a
+     * `StreamingWindow` that rebuilds their whole-window output for the next
+     * layers. The model input is the newest num_frames rows of the feature map,
+     * and its output matches the model of parseJson() on the last in_shape rows
+     * once that many rows have been passed since `reset()`.
+     * Returns null if the leading conv2d layers have strides or padding along the rows.
+     */
+    template <typename T>
+    std::unique_ptr<Model<T>> parseStreamingJson(const nlohmann::json& parent, int num_frames = 1, const bool debug = false,
+        const MemoryPlanOptions& memoryOptions = {})
+    {
+        if(num_frames <= 0)
+        {
+            debug_print("Invalid number of frames!", debug);
+            return {};
+        }
+
+        return createModel<T>(parent, num_frames, debug, memoryOptions);
+    }
+
+    /** Creates a streaming model from a json stream. */
+    template <typename T>
+    std::unique_ptr<Model<T>> parseStreamingJson(std::ifstream& jsonStream, int num_frames = 1, const bool debug = false,
+        const MemoryPlanOptions& memoryOptions = {})
     {
         nlohmann::json parent;
         jsonStream >> parent;
-        return parseJson<T>(parent, debug);
+        return parseStreamingJson<T>(parent, num_frames, debug, memoryOptions);
     }
 
 } // namespace json_parser
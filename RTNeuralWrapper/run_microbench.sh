@@ -0,0 +1,35 @@
+#!/bin/bash
+# Runs every rtneural_microbench_<backend> of a build directory and merges their
+# results into a single CSV (one row per backend/api/layer/size)
+#
+# Usage: ./run_microbench.sh <build dir> [output csv] [microbench options...]
+set -e
+
+if [ -z "$1" ]; then
+    echo "Usage: $0 <build dir> [output csv] [microbench options...]"
+    exit 1
+fi
+BUILD_DIR="$1"
+OUTPUT="${2:-microbench.csv}"
+shift $(( $# > 1 ? 2 : 1 ))
+
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+rm -f "$OUTPUT"
+for BENCH in "$BUILD_DIR"/rtneural_microbench_*; do
+    [ -x "$BENCH" ] || continue
+    NAME=$(basename "$BENCH")
+    "$BENCH" --csv "$TMP_DIR/$NAME.csv" "$@"
+    if [ ! -f "$OUTPUT" ]; then
+        cat "$TMP_DIR/$NAME.csv" > "$OUTPUT"
+    else
+        tail -n +2 "$TMP_DIR/$NAME.csv" >> "$OUTPUT"
+    fi
+done
+
+if [ ! -f "$OUTPUT" ]; then
+    echo "No microbenchmark found in $BUILD_DIR, configure with -DRTNEURAL_BUILD_MICROBENCH=ON"
+    exit 1
+fi
+echo "Results written to $OUTPUT"
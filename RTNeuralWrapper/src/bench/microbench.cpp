@@ -0,0 +1,399 @@
+/*
+ * RTNeural microbenchmark
+ *
+ * Times the forward call of synthetic single-layer models (dense, conv1d, gru, lstm and the
+ * activations) and of a small dense network, over a sweep of layer sizes, with both the
+ * dynamic Model and the compile-time ModelT API. The executable is built once per RTNeural
+ * backend (rtneural_microbench_eigen, _stl, _xsimd), so running all of them gives the scaling
+ * curves of every backend/API combination.
+ *
+ * The synthetic weights go through the JSON loaders of RTNeural, so the benchmarked models
+ * are set up exactly like the ones loaded by the wrapper.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Profiler.h"
+#include "RTNeural.h"
+
+#if RTNEURAL_USE_EIGEN
+static const char *backendName = "eigen";
+#elif RTNEURAL_USE_XSIMD
+static const char *backendName = "xsimd";
+#elif RTNEURAL_USE_ACCELERATE
+static const char *backendName = "accelerate";
+#else
+static const char *backendName = "stl";
+#endif
+
+/** Sizes of the sweep, the same list is used for the compile-time models */
+using SweepSizes = std::integer_sequence<int, 8, 16, 32, 64, 128, 256>;
+
+constexpr int convKernelSize = 3;
+constexpr int mlpOutSize = 8;
+
+static const std::vector<std::string> allLayers = {"dense", "conv1d", "gru", "lstm", "tanh", "relu", "sigmoid", "softmax", "mlp"};
+
+struct Options {
+    std::vector<std::string> layers = allLayers;
+    std::vector<int> sizes;  // Empty: all the sweep sizes
+    bool runDynamic = true, runStatic = true;
+    double minBlockUs = 200.0;  // Minimum duration of a timed block of calls
+    int repeats = 15;           // Timed blocks per measurement
+    std::string csvFilename;
+};
+
+struct Result {
+    std::string api, layer;
+    int inSize, outSize, kernelSize;
+    size_t weightBytes;
+    double flops;
+    size_t callsPerBlock;
+    double medianNs, minNs;
+};
+
+//==============================================================================
+// Synthetic models
+
+static std::mt19937 generator(1234);
+
+static nlohmann::json randomMatrix(int rows, int cols) {
+    std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+    auto matrix = nlohmann::json::array();
+    for (int r = 0; r < rows; ++r) {
+        auto row = nlohmann::json::array();
+        for (int c = 0; c < cols; ++c)
+            row.push_back(distribution(generator));
+        matrix.push_back(row);
+    }
+    return matrix;
+}
+
+static nlohmann::json randomVector(int size) {
+    return randomMatrix(1, size)[0];
+}
+
+/** One layer in the format of the RTNeural JSON loader (Keras export) */
+static nlohmann::json makeLayerJson(const std::string &type, int inSize, int outSize, const std::string &activation = "") {
+    nlohmann::json layer;
+    layer["type"] = type;
+    layer["activation"] = activation;
+    layer["shape"] = {nullptr, nullptr, outSize};
+
+    if (type == "dense") {
+        layer["weights"] = {randomMatrix(inSize, outSize), randomVector(outSize)};
+    } else if (type == "conv1d") {
+        auto kernel = nlohmann::json::array();
+        for (int k = 0; k < convKernelSize; ++k)
+            kernel.push_back(randomMatrix(inSize, outSize));
+        layer["weights"] = {kernel, randomVector(outSize)};
+        layer["kernel_size"] = {convKernelSize};
+        layer["dilation"] = {1};
+    } else if (type == "gru") {
+        layer["weights"] = {randomMatrix(inSize, 3 * outSize), randomMatrix(outSize, 3 * outSize), randomMatrix(2, 3 * outSize)};
+    } else if (type == "lstm") {
+        layer["weights"] = {randomMatrix(inSize, 4 * outSize), randomMatrix(outSize, 4 * outSize), randomVector(4 * outSize)};
+    }
+    return layer;
+}
+
+/** Model JSON of a benchmark case (activations have no JSON, see makeDynamicModel) */
+static nlohmann::json makeModelJson(const std::string &layer, int size) {
+    nlohmann::json model;
+    model["in_shape"] = {nullptr, nullptr, size};
+    if (layer == "mlp")
+        model["layers"] = {makeLayerJson("dense", size, size, "relu"), makeLayerJson("dense", size, size, "relu"), makeLayerJson("dense", size, mlpOutSize)};
+    else
+        model["layers"] = {makeLayerJson(layer, size, size)};
+    return model;
+}
+
+static bool isActivation(const std::string &layer) {
+    return layer == "tanh" || layer == "relu" || layer == "sigmoid" || layer == "softmax";
+}
+
+static std::unique_ptr<RTNeural::Model<float>> makeDynamicModel(const std::string &layer, int size, const nlohmann::json &json) {
+    if (!isActivation(layer))
+        return RTNeural::json_parser::parseJson<float>(json);
+
+    auto model = std::make_unique<RTNeural::Model<float>>(size);
+    model->addLayer(RTNeural::json_parser::createActivation<float>(layer, size).release());
+    model->planMemory();
+    return model;
+}
+
+//==============================================================================
+// Timing
+
+/** Time the forward calls of a model, in blocks long enough for the clock resolution */
+template <typename ModelType>
+static void timeModel(ModelType &model, int inSize, const Options &options, Result &result) {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<float> input((size_t)inSize);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    for (auto &value : input)
+        value = distribution(generator);
+
+    model.reset();
+    volatile float sink = 0.0f;  // Keeps the calls from being optimized out
+
+    auto timeBlock = [&](size_t calls) {
+        const auto start = Clock::now();
+        for (size_t i = 0; i < calls; ++i)
+            model.forward(input.data());
+        const auto stop = Clock::now();
+        sink = sink + model.getOutputs()[0];
+        return std::chrono::duration<double, std::nano>(stop - start).count();
+    };
+
+    timeBlock(100);  // Warm-up
+
+    size_t callsPerBlock = 1;
+    while (timeBlock(callsPerBlock) < options.minBlockUs * 1000.0 && callsPerBlock < ((size_t)1 << 24))
+        callsPerBlock *= 2;
+
+    std::vector<double> nsPerCall((size_t)options.repeats);
+    for (auto &value : nsPerCall)
+        value = timeBlock(callsPerBlock) / (double)callsPerBlock;
+    std::sort(nsPerCall.begin(), nsPerCall.end());
+
+    result.callsPerBlock = callsPerBlock;
+    result.medianNs = nsPerCall[nsPerCall.size() / 2];
+    result.minNs = nsPerCall.front();
+}
+
+/** Fill the sizes, weight bytes and FLOPs of a benchmark case */
+static Result describeCase(const std::string &api, const std::string &layer, int size) {
+    Result result;
+    result.api = api;
+    result.layer = layer;
+    result.inSize = size;
+    result.outSize = layer == "mlp" ? mlpOutSize : size;
+    result.kernelSize = layer == "conv1d" ? convKernelSize : 1;
+    result.weightBytes = 0;
+    result.flops = 0.0;
+
+    // (layer name, in, out) of every layer of the case
+    std::vector<std::tuple<std::string, int, int>> parts;
+    if (layer == "mlp")
+        parts = {{"dense", size, size}, {"relu", size, size}, {"dense", size, size}, {"relu", size, size}, {"dense", size, mlpOutSize}};
+    else
+        parts = {{layer, size, size}};
+
+    for (const auto &part : parts) {
+        size_t numWeights = 0;
+        double flops = 0.0;
+        RTNeural::profiling::estimateLayerCost(std::get<0>(part), std::get<1>(part), std::get<2>(part), result.kernelSize, numWeights, flops);
+        result.weightBytes += numWeights * sizeof(float);
+        result.flops += flops;
+    }
+    return result;
+}
+
+//==============================================================================
+// Compile-time models
+
+template <int N>
+using DenseModelT = RTNeural::ModelT<float, N, N, RTNeural::DenseT<float, N, N>>;
+template <int N>
+using Conv1DModelT = RTNeural::ModelT<float, N, N, RTNeural::Conv1DT<float, N, N, convKernelSize, 1>>;
+template <int N>
+using GRUModelT = RTNeural::ModelT<float, N, N, RTNeural::GRULayerT<float, N, N>>;
+template <int N>
+using LSTMModelT = RTNeural::ModelT<float, N, N, RTNeural::LSTMLayerT<float, N, N>>;
+template <int N>
+using TanhModelT = RTNeural::ModelT<float, N, N, RTNeural::TanhActivationT<float, N>>;
+template <int N>
+using ReLuModelT = RTNeural::ModelT<float, N, N, RTNeural::ReLuActivationT<float, N>>;
+template <int N>
+using SigmoidModelT = RTNeural::ModelT<float, N, N, RTNeural::SigmoidActivationT<float, N>>;
+template <int N>
+using SoftmaxModelT = RTNeural::ModelT<float, N, N, RTNeural::SoftmaxActivationT<float, N>>;
+template <int N>
+using MLPModelT = RTNeural::ModelT<float, N, mlpOutSize,
+                                   RTNeural::DenseT<float, N, N>, RTNeural::ReLuActivationT<float, N>,
+                                   RTNeural::DenseT<float, N, N>, RTNeural::ReLuActivationT<float, N>,
+                                   RTNeural::DenseT<float, N, mlpOutSize>>;
+
+template <typename ModelType>
+static void timeStaticModel(const nlohmann::json &json, int size, const Options &options, Result &result) {
+    // Heap allocated, the fixed-size weights of the large layers do not fit on the stack
+    auto model = std::make_unique<ModelType>();
+    if (!json.is_null())
+        model->parseJson(json);
+    timeModel(*model, size, options, result);
+}
+
+template <int N>
+static void runStatic(const std::string &layer, const nlohmann::json &json, const Options &options, Result &result) {
+    if (layer == "dense")
+        timeStaticModel<DenseModelT<N>>(json, N, options, result);
+    else if (layer == "conv1d")
+        timeStaticModel<Conv1DModelT<N>>(json, N, options, result);
+    else if (layer == "gru")
+        timeStaticModel<GRUModelT<N>>(json, N, options, result);
+    else if (layer == "lstm")
+        timeStaticModel<LSTMModelT<N>>(json, N, options, result);
+    else if (layer == "tanh")
+        timeStaticModel<TanhModelT<N>>(nullptr, N, options, result);
+    else if (layer == "relu")
+        timeStaticModel<ReLuModelT<N>>(nullptr, N, options, result);
+    else if (layer == "sigmoid")
+        timeStaticModel<SigmoidModelT<N>>(nullptr, N, options, result);
+    else if (layer == "softmax")
+        timeStaticModel<SoftmaxModelT<N>>(nullptr, N, options, result);
+    else if (layer == "mlp")
+        timeStaticModel<MLPModelT<N>>(json, N, options, result);
+}
+
+//==============================================================================
+
+/** Run every benchmark case of one size */
+template <int N>
+static void runSize(const Options &options, std::vector<Result> &results) {
+    if (!options.sizes.empty() && std::find(options.sizes.begin(), options.sizes.end(), N) == options.sizes.end())
+        return;
+
+    for (const auto &layer : options.layers) {
+        const nlohmann::json json = isActivation(layer) ? nlohmann::json() : makeModelJson(layer, N);
+
+        if (options.runDynamic) {
+            Result result = describeCase("dynamic", layer, N);
+            auto model = makeDynamicModel(layer, N, json);
+            timeModel(*model, N, options, result);
+            results.push_back(result);
+        }
+        if (options.runStatic) {
+            Result result = describeCase("static", layer, N);
+            runStatic<N>(layer, json, options, result);
+            results.push_back(result);
+        }
+
+        const auto &last = results.back();
+        std::cerr << backendName << " " << std::setw(8) << layer << " " << std::setw(4) << N << ": "
+                  << std::fixed << std::setprecision(1) << last.medianNs << " ns (" << last.api << ")" << std::endl;
+    }
+}
+
+template <int... Sizes>
+static void runSweep(std::integer_sequence<int, Sizes...>, const Options &options, std::vector<Result> &results) {
+    (runSize<Sizes>(options, results), ...);
+}
+
+static void writeCsv(std::ostream &os, const std::vector<Result> &results) {
+    os << "backend,api,layer,in_size,out_size,kernel_size,weight_bytes,flops,calls_per_block,median_ns,min_ns,gflops" << std::endl;
+    for (const auto &r : results) {
+        os << backendName << "," << r.api << "," << r.layer << "," << r.inSize << "," << r.outSize << "," << r.kernelSize << ","
+           << r.weightBytes << "," << r.flops << "," << r.callsPerBlock << "," << r.medianNs << "," << r.minNs << ","
+           << (r.medianNs > 0.0 ? r.flops / r.medianNs : 0.0) << std::endl;
+    }
+}
+
+/** Print one row per layer, one column per size, dynamic/static median ns per call */
+static void printTable(std::ostream &os, const std::vector<Result> &results, const Options &options) {
+    std::vector<int> sizes;
+    for (const auto &r : results)
+        if (std::find(sizes.begin(), sizes.end(), r.inSize) == sizes.end())
+            sizes.push_back(r.inSize);
+
+    os << "RTNeural " << backendName << " backend, median ns per forward call";
+    if (options.runDynamic && options.runStatic)
+        os << " (dynamic / static)";
+    os << std::endl
+       << std::left << std::setw(10) << "layer" << std::right;
+    for (int size : sizes)
+        os << std::setw(20) << size;
+    os << std::endl;
+
+    for (const auto &layer : options.layers) {
+        os << std::left << std::setw(10) << layer << std::right;
+        for (int size : sizes) {
+            std::stringstream cell;
+            cell << std::fixed << std::setprecision(0);
+            for (const auto &r : results) {
+                if (r.layer != layer || r.inSize != size)
+                    continue;
+                if (!cell.str().empty())
+                    cell << " / ";
+                cell << r.medianNs;
+            }
+            os << std::setw(20) << cell.str();
+        }
+        os << std::endl;
+    }
+}
+
+static std::vector<std::string> splitList(const std::string &list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+static void printUsage(const char *execName) {
+    std::cerr << "USAGE:" << std::endl
+              << execName << " [--layers L1,L2,...] [--sizes N1,N2,...] [--api dynamic|static|both] [--min-block-us N] [--repeats N] [--csv FILE]" << std::endl
+              << std::endl
+              << "  --layers   any of dense,conv1d,gru,lstm,tanh,relu,sigmoid,softmax,mlp (default all)" << std::endl
+              << "  --sizes    subset of the sweep 8,16,32,64,128,256 (default all)" << std::endl
+              << "  --csv      write the results as CSV (one row per backend/api/layer/size)" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--layers") == 0 && i + 1 < argc) {
+            options.layers = splitList(argv[++i]);
+            for (const auto &layer : options.layers)
+                if (std::find(allLayers.begin(), allLayers.end(), layer) == allLayers.end()) {
+                    printUsage(argv[0]);
+                    return 1;
+                }
+        } else if (std::strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            for (const auto &size : splitList(argv[++i]))
+                options.sizes.push_back(std::atoi(size.c_str()));
+        } else if (std::strcmp(argv[i], "--api") == 0 && i + 1 < argc) {
+            const std::string api(argv[++i]);
+            options.runDynamic = api == "dynamic" || api == "both";
+            options.runStatic = api == "static" || api == "both";
+            if (!options.runDynamic && !options.runStatic) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--min-block-us") == 0 && i + 1 < argc) {
+            options.minBlockUs = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            options.repeats = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            options.csvFilename = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    runSweep(SweepSizes{}, options, results);
+
+    printTable(std::cout, results, options);
+    if (!options.csvFilename.empty()) {
+        std::ofstream csv(options.csvFilename);
+        writeCsv(csv, results);
+    }
+    return 0;
+}
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <iomanip>
@@ -11,6 +12,7 @@
 #include <limits>  // std::numeric_limits
 #include <numeric>
 #include <sstream>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
@@ -49,29 +51,64 @@ typedef std::unique_ptr<model_t, std::default_delete<model_t>> model_ptr;
 // Definition of the classifier class
 class Classifier {
 public:
-    /** Constructor */
-    Classifier(const std::string &filename, bool verbose = false);
+    /** Constructor, streamingFrames > 0 for a streaming model (see createStreamingClassifier) */
+    Classifier(const std::string &filename, const ClassifierOptions &options, bool verbose = false, int streamingFrames = 0);
     /** Destructor */
     ~Classifier();
     /** Internal classification function, called by wrappers */
     int classify_internal(const float featureVector[], size_t numFeatures, float outputVector[], size_t numClasses);
 
+    /** Input size of the model */
+    size_t requestedInputSize() const { return inputTensorSize; }
+    /** Output size of the model */
+    size_t requestedOutputSize() const { return outputTensorSize; }
+
+    /** Duration of the phases of the constructor */
+    const std::vector<StartupPhase> &getStartupPhases() const { return startupPhases; }
+
+#if RTNEURAL_ENABLE_PROFILING
+    /** Per-layer profiler of the model */
+    RTNeural::profiling::Profiler &getProfiler() { return this->model->getProfiler(); }
+
+    /** Start/stop passing the time of every layer to a sink after each classify call */
+    void enableProfiling(OpEventSink sink);
+    void disableProfiling();
+#endif
+
 private:
     /** Load the .onnx model and create inference session */
-    model_ptr loadModel(const std::string &filename, bool verbose = false);
+    model_ptr loadModel(const std::string &filename, const ClassifierOptions &options, bool verbose = false);
 
     /** ind the index of the maximum value in an array */
     int argmax(const float vec[], size_t vecSize) const;
 
+    /** Record the time since the end of the previous phase (or the start of the constructor) */
+    void endStartupPhase(const char *name);
+
+    std::vector<StartupPhase> startupPhases;
+    std::chrono::steady_clock::time_point phaseStart;
+
     //--------------------------------------------------------------------------
     model_ptr model;
+    int streamingFrames = 0;  // Rows of the feature map per classify call, 0 for a whole-window model
 
     size_t inputTensorSize = 173;
     size_t outputTensorSize = 8;
     std::vector<float> inputTensorValues;
+
+#if RTNEURAL_ENABLE_PROFILING
+    /** Pass the layer times of the last classify call to the sink */
+    void reportProfile();
+
+    OpEventSink profilingSink;
+    int profiledInvocations = 0;
+    std::vector<uint64_t> reportedNanoseconds;  // Profiler counters at the previous report
+#endif
 };
 
-Classifier::Classifier(const std::string &filename, bool verbose) {
+Classifier::Classifier(const std::string &filename, const ClassifierOptions &options, bool verbose, int streamingFrames)
+    : streamingFrames(streamingFrames) {
+    phaseStart = std::chrono::steady_clock::now();
     // Load model
     if (verbose) {
         std::cout << std::setfill('-') << std::setw(40) << "" << std::endl;
@@ -81,30 +118,40 @@ Classifier::Classifier(const std::string &filename, bool verbose) {
         std::cout << "Parsing model (dynamic model loading)..." << std::endl;
 #endif
     }
-    this->model = loadModel(filename, verbose);
+    this->model = loadModel(filename, options, verbose);
+    endStartupPhase("build");
     if (verbose) {
         std::cout << "Model loaded successfully." << std::endl;
         std::cout << "File: " << filename << std::endl;
     }
 
-    /* implementation for dynamic model loading
+#ifndef USE_COMPILE_TIME_API
     inputTensorSize = this->model->layers.front()->in_size;
     outputTensorSize = this->model->layers.back()->out_size;
-    */
+#endif
 
     this->model->reset();
 
     inputTensorValues = std::vector<float>(inputTensorSize);
+    endStartupPhase("allocate");
 
     // Prime the classifier
     std::vector<float> pIv(inputTensorSize);
     std::vector<float> pOv(outputTensorSize);
 
     this->classify_internal(&pIv[0], pIv.size(), &pOv[0], pOv.size());
+    if (streamingFrames > 0)
+        this->model->reset();  // Do not keep the priming frames in the history
+    endStartupPhase("prime");
     /*
      * The priming operation should ensure that every allocation performed
      * by the Run method is perfomed here and not in the real-time thread.
      */
+
+#if RTNEURAL_ENABLE_PROFILING
+    // Do not count the priming call
+    this->model->getProfiler().reset();
+#endif
 }
 
 Classifier::~Classifier() {
@@ -124,6 +171,11 @@ int Classifier::classify_internal(const float featureVector[], size_t numFeature
     // Run inference
     this->model->forward(inputTensorValues.data());
 
+#if RTNEURAL_ENABLE_PROFILING
+    if (profilingSink)
+        reportProfile();
+#endif
+
     if (numClasses != outputTensorSize)
         throw std::logic_error("Error, output vector has to have size: " + std::to_string(outputTensorSize) + " (Found " + std::to_string(numClasses) + " instead)");
 
@@ -134,18 +186,67 @@ int Classifier::classify_internal(const float featureVector[], size_t numFeature
     return argmax(outputVector, numClasses);
 }
 
-model_ptr Classifier::loadModel(const std::string &filename, bool verbose) {
+model_ptr Classifier::loadModel(const std::string &filename, const ClassifierOptions &options, bool verbose) {
     std::ifstream jsonStream(filename, std::ifstream::binary);
+    nlohmann::json modelJson;
+    jsonStream >> modelJson;
+    endStartupPhase("load");
 #ifdef USE_COMPILE_TIME_API
+    if (streamingFrames > 0)
+        throw std::logic_error("Error, streaming models need the dynamic model loading (USE_COMPILE_TIME_API=false)");
+    (void)options;  // ModelT keeps its weights in the object, there is no arena
     auto modelT = new model_t;
-    modelT->parseJson(jsonStream, verbose);
+    modelT->parseJson(modelJson, verbose);
     return modelT;
 #else
-    auto model = RTNeural::json_parser::parseJson<float>(jsonStream, true);
+    RTNeural::MemoryPlanOptions memoryOptions;
+    memoryOptions.useHugePages = options.useHugePages;
+    auto model = streamingFrames > 0 ? RTNeural::json_parser::parseStreamingJson<float>(modelJson, streamingFrames, verbose, memoryOptions)
+                                     : RTNeural::json_parser::parseJson<float>(modelJson, verbose, memoryOptions);
+    if (!model)
+        throw std::logic_error("Error, the model " + filename + " could not be loaded (run with verbose for details)");
     return model;
 #endif
 }
 
+void Classifier::endStartupPhase(const char *name) {
+    const auto now = std::chrono::steady_clock::now();
+    startupPhases.push_back({name, std::chrono::duration<double, std::micro>(now - phaseStart).count()});
+    phaseStart = now;
+}
+
+#if RTNEURAL_ENABLE_PROFILING
+void Classifier::enableProfiling(OpEventSink sink) {
+    profilingSink = std::move(sink);
+    profiledInvocations = 0;
+    reportedNanoseconds.clear();
+    for (const auto &layer : getProfiler().getLayers())
+        reportedNanoseconds.push_back(layer.nanoseconds);
+}
+
+void Classifier::disableProfiling() {
+    profilingSink = nullptr;
+}
+
+void Classifier::reportProfile() {
+    // The profiler accumulates over calls (see printProfile), report the difference since the last call
+    const auto &layers = getProfiler().getLayers();
+    reportedNanoseconds.resize(layers.size(), 0);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const uint64_t previous = layers[i].nanoseconds >= reportedNanoseconds[i] ? reportedNanoseconds[i] : 0;  // 0 after resetProfile
+        OpEvent event;
+        event.op = layers[i].name;
+        event.node = "layer" + std::to_string(i);
+        event.invocation = profiledInvocations;
+        event.durationUs = (double)(layers[i].nanoseconds - previous) / 1000.0;
+        event.inputShapes.push_back({1, (int64_t)layers[i].in_size});
+        reportedNanoseconds[i] = layers[i].nanoseconds;
+        profilingSink(event);
+    }
+    ++profiledInvocations;
+}
+#endif
+
 int Classifier::argmax(const float vec[], size_t vecSize) const {
     float max = std::numeric_limits<float>::lowest();
     int argmax = -1;
@@ -159,7 +260,8 @@ int Classifier::argmax(const float vec[], size_t vecSize) const {
 }
 
 /***** Handle functions *****/
-ClassifierPtr createClassifier(const std::string &filename, bool verbose) {
+/** Print the model API and select the kernels of this CPU */
+static void initializeRuntime(bool verbose) {
 #ifdef USE_COMPILE_TIME_API
     std::cout << "I am compile time optimized" << std::endl
               << std::flush;
@@ -168,7 +270,35 @@ ClassifierPtr createClassifier(const std::string &filename, bool verbose) {
               << std::flush;
 #endif
 
-    return new Classifier(filename, verbose);
+#if RTNEURAL_RUNTIME_DISPATCH
+    // Pick the kernels for the best instruction set of this CPU before priming the first model. Only once: classifiers
+    // may already be running on other threads.
+    static const auto isa = RTNeural::dispatch::selectKernels();
+    if (verbose)
+        std::cout << "Using " << RTNeural::dispatch::getISAName(isa) << " kernels (runtime dispatch)" << std::endl;
+#else
+    (void)verbose;
+#endif
+}
+
+ClassifierPtr createClassifier(const std::string &filename, bool verbose) {
+    return createClassifier(filename, ClassifierOptions(), verbose);
+}
+
+ClassifierPtr createClassifier(const std::string &filename, const ClassifierOptions &options, bool verbose) {
+    initializeRuntime(verbose);
+    return new Classifier(filename, options, verbose);
+}
+
+ClassifierPtr createStreamingClassifier(const std::string &filename, int numFrames, bool verbose) {
+    return createStreamingClassifier(filename, ClassifierOptions(), numFrames, verbose);
+}
+
+ClassifierPtr createStreamingClassifier(const std::string &filename, const ClassifierOptions &options, int numFrames, bool verbose) {
+    if (numFrames <= 0)
+        throw std::invalid_argument("Error, numFrames must be positive (Found " + std::to_string(numFrames) + " instead)");
+    initializeRuntime(verbose);
+    return new Classifier(filename, options, verbose, numFrames);
 }
 
 void deleteClassifier(ClassifierPtr cls) {
@@ -176,10 +306,66 @@ void deleteClassifier(ClassifierPtr cls) {
         delete cls;
 }
 
+size_t getModelInputSize1d(ClassifierPtr cls) {
+    return cls->requestedInputSize();
+}
+
+size_t getModelOutputSize(ClassifierPtr cls) {
+    return cls->requestedOutputSize();
+}
+
 int classify(ClassifierPtr cls, const float featureVector[], size_t numFeatures, float outputVector[], size_t numClasses) {
     return cls->classify_internal(featureVector, numFeatures, outputVector, numClasses);
 }
 
+void printProfile(ClassifierPtr cls, std::ostream &os) {
+#if RTNEURAL_ENABLE_PROFILING
+    cls->getProfiler().print(os);
+#else
+    (void)cls;
+    os << "Profiling is disabled, rebuild with -DRTNEURAL_ENABLE_PROFILING=ON" << std::endl;
+#endif
+}
+
+std::string getProfileJson(ClassifierPtr cls) {
+#if RTNEURAL_ENABLE_PROFILING
+    return cls->getProfiler().toJson().dump(2);
+#else
+    (void)cls;
+    return "[]";
+#endif
+}
+
+void resetProfile(ClassifierPtr cls) {
+#if RTNEURAL_ENABLE_PROFILING
+    cls->getProfiler().reset();
+#else
+    (void)cls;
+#endif
+}
+
+void enableProfiling(ClassifierPtr cls, OpEventSink sink) {
+#if RTNEURAL_ENABLE_PROFILING
+    cls->enableProfiling(std::move(sink));
+#else
+    (void)cls;
+    (void)sink;
+    throw std::runtime_error("Profiling is disabled, rebuild with -DRTNEURAL_ENABLE_PROFILING=ON");
+#endif
+}
+
+void disableProfiling(ClassifierPtr cls) {
+#if RTNEURAL_ENABLE_PROFILING
+    cls->disableProfiling();
+#else
+    (void)cls;
+#endif
+}
+
+std::vector<StartupPhase> getStartupPhases(ClassifierPtr cls) {
+    return cls->getStartupPhases();
+}
+
 void softmax(float logitsArray[], size_t numClasses, bool verbose) {
     if (verbose)
         std::cout << "Applying softmax..." << std::endl
@@ -7,7 +7,9 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
+#include <functional>
 #include <iostream>
 #include <limits>  // std::numeric_limits
 #include <string>
@@ -20,6 +22,30 @@ using ClassifierPtr = Classifier*;  // Opaque pointer for classifier object
 /** Dynamically allocate an instance of a classifier object (do not use in real time threads!) */
 ClassifierPtr createClassifier(const std::string& filename, bool verbose = false);
 
+/**
+ * @brief Dynamically allocate a streaming classifier (do not use in real time threads!)
+ * For models that start with Conv2D layers over a sliding feature map (e.g. frames x mel bands, one row per frame):
+ * each classify call takes only the newest numFrames rows (getModelInputSize1d values) and classifies the whole
+ * window, computing only the new rows of the convolutions. Once a whole window of rows has been passed, the result
+ * is the one of createClassifier on the last window. The Conv2D layers must have a stride of 1 and "valid" padding
+ * along the rows (or a kernel of one row), and the dynamic model loading (USE_COMPILE_TIME_API=false) is required.
+ */
+ClassifierPtr createStreamingClassifier(const std::string& filename, int numFrames = 1, bool verbose = false);
+
+/** Options of the classifier, applied when it is created */
+struct ClassifierOptions {
+    /**
+     * Back the memory arena of the model (weights and activations, see RTNeural::Model::planMemory) with huge pages,
+     * which saves TLB misses on large models. Falls back to normal pages when the system has none available.
+     * Ignored by the compile-time API (USE_COMPILE_TIME_API), whose model has no arena.
+     */
+    bool useHugePages = false;
+};
+
+/** createClassifier/createStreamingClassifier with options (do not use in real time threads!) */
+ClassifierPtr createClassifier(const std::string& filename, const ClassifierOptions& options, bool verbose = false);
+ClassifierPtr createStreamingClassifier(const std::string& filename, const ClassifierOptions& options, int numFrames = 1, bool verbose = false);
+
 /** Feed a feature array (C Array) to the model, perform inference and return the prediction */
 int classify(ClassifierPtr cls, const float featureVector[], size_t numFeatures, float outputVector[], size_t numClasses);
 
@@ -34,6 +60,87 @@ int classify(ClassifierPtr cls, std::array<float, IN_SIZE>& featureArray, std::a
 /** Free the classifier memory (do not use in real time threads) */
 void deleteClassifier(ClassifierPtr cls);
 
+/**
+ * @brief Get the Model Input Size for 1dimentional input models
+ *
+ * @param cls
+ * @return size_t
+ */
+size_t getModelInputSize1d(ClassifierPtr cls);
+
+/**
+ * @brief Get the Model Output size
+ *
+ * @param cls
+ * @return size_t
+ */
+size_t getModelOutputSize(ClassifierPtr cls);
+
+/**
+ * @brief Print the per-layer profile of the model
+ * Average cycles and time, weight size and GFLOP/s of every layer, over all the classify calls since the last reset.
+ * Requires the library to be built with -DRTNEURAL_ENABLE_PROFILING=ON, otherwise only a notice is printed.
+ *
+ * @param cls Classifier object
+ * @param os  Output stream
+ */
+void printProfile(ClassifierPtr cls, std::ostream& os);
+
+/**
+ * @brief Get the per-layer profile of the model as a JSON array ("[]" if profiling is not compiled in)
+ *
+ * @param cls Classifier object
+ * @return std::string
+ */
+std::string getProfileJson(ClassifierPtr cls);
+
+/** Reset the per-layer profile counters (do not use in real time threads) */
+void resetProfile(ClassifierPtr cls);
+
+/**
+ * @brief One operator execution, as reported by the native profiler of the runtime
+ * The same structure is used by all the wrappers, so that per-operator profiles can be compared.
+ */
+struct OpEvent {
+    std::string op;                                 // Operator type (e.g. "dense")
+    std::string node;                               // Name of the node in the graph (empty if not reported by the runtime)
+    int invocation = 0;                             // Index of the classify call since enableProfiling
+    double durationUs = 0.0;                        // Execution time in microseconds
+    std::vector<std::vector<int64_t>> inputShapes;  // Shape of every input tensor of the operator
+};
+
+/** Callback that receives the operator events */
+using OpEventSink = std::function<void(const OpEvent&)>;
+
+/**
+ * @brief Report the time of every layer to a sink (do not use in real time threads)
+ * After every classify call, one event per layer is passed to the sink, in forward order.
+ * Requires the library to be built with -DRTNEURAL_ENABLE_PROFILING=ON, otherwise a std::runtime_error is thrown.
+ *
+ * @param cls  Classifier object
+ * @param sink Callback for the layer events
+ */
+void enableProfiling(ClassifierPtr cls, OpEventSink sink);
+
+/** Stop reporting layer events (do not use in real time threads) */
+void disableProfiling(ClassifierPtr cls);
+
+/** Duration of one phase of the creation of a classifier */
+struct StartupPhase {
+    std::string name;         // "load", "build", "allocate" or "prime"
+    double durationUs = 0.0;  // Wall time in microseconds
+};
+
+/**
+ * @brief Get the time spent in each phase of createClassifier
+ * load: reading and parsing the .json file, build: creation of the layers from the weights (and the memory plan of
+ * dynamic models), allocate: input buffer and state reset, prime: the first forward call.
+ *
+ * @param cls Classifier object
+ * @return The phases, in execution order
+ */
+std::vector<StartupPhase> getStartupPhases(ClassifierPtr cls);
+
 /**
  * @brief Apply softmax to a logits array
  * Apply softmax to a logits array when using networks that do not have a softmax output layer
@@ -0,0 +1,150 @@
+/*
+  Helpers shared by the Conv2D tests: random weights exported the way the
+  RTNeural Keras exporter does, and a naive TensorFlow convolution to compare with.
+==============================================================================*/
+#ifndef CONV2D_TEST_HELPERS_H_INCLUDED
+#define CONV2D_TEST_HELPERS_H_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RTNeural.h"
+
+using json = nlohmann::json;
+
+inline float randomValue()
+{
+    static std::mt19937 rng(1);
+    return std::uniform_real_distribution<float>(-1.0f, 1.0f)(rng);
+}
+
+inline std::vector<float> randomVector(size_t size)
+{
+    std::vector<float> values(size);
+    for(auto& v : values)
+        v = randomValue();
+    return values;
+}
+
+/** Parameters of a Keras Conv2D layer */
+struct ConvParams
+{
+    int in_ch, out_ch;
+    int kernel_rows, kernel_cols;
+    int stride_rows = 1, stride_cols = 1;
+    int dilation_rows = 1, dilation_cols = 1;
+    bool same = false;
+    std::string activation = "";
+};
+
+inline int convOutputSize(int in, int kernel, int stride, int dilation, bool same)
+{
+    return same ? (in + stride - 1) / stride : (in - (kernel - 1) * dilation + stride - 1) / stride;
+}
+
+/** Conv2D layer with random weights, stored in the Keras [kernel_rows][kernel_cols][in][out] order */
+inline json convLayer(const ConvParams& p, int in_rows, int in_cols)
+{
+    json kernel = json::array();
+    for(int i = 0; i < p.kernel_rows; ++i)
+    {
+        json row = json::array();
+        for(int j = 0; j < p.kernel_cols; ++j)
+        {
+            json tap = json::array();
+            for(int c = 0; c < p.in_ch; ++c)
+                tap.push_back(randomVector(p.out_ch));
+            row.push_back(tap);
+        }
+        kernel.push_back(row);
+    }
+
+    json layer;
+    layer["type"] = "conv2d";
+    layer["activation"] = p.activation;
+    layer["shape"] = { nullptr, convOutputSize(in_rows, p.kernel_rows, p.stride_rows, p.dilation_rows, p.same),
+        convOutputSize(in_cols, p.kernel_cols, p.stride_cols, p.dilation_cols, p.same), p.out_ch };
+    layer["weights"] = { kernel, randomVector(p.out_ch) };
+    layer["kernel_size"] = { p.kernel_rows, p.kernel_cols };
+    layer["strides"] = { p.stride_rows, p.stride_cols };
+    layer["dilation"] = { p.dilation_rows, p.dilation_cols };
+    layer["padding"] = p.same ? "same" : "valid";
+    return layer;
+}
+
+/** Dense layer with random weights, stored in the Keras [in][out] order */
+inline json denseLayer(int in_size, int out_size, const std::string& activation)
+{
+    json weights = json::array();
+    for(int i = 0; i < in_size; ++i)
+    {
+        auto row = randomVector(out_size);
+        for(auto& v : row)
+            v *= 0.1f;
+        weights.push_back(row);
+    }
+
+    json layer;
+    layer["type"] = "dense";
+    layer["activation"] = activation;
+    layer["shape"] = { nullptr, out_size };
+    layer["weights"] = { weights, randomVector(out_size) };
+    return layer;
+}
+
+/**
+ * Naive TensorFlow convolution of a channels-last feature map, using the weights of a layer made by convLayer.
+ * Only the relu activation is applied, other activations are left to the caller.
+ */
+inline std::vector<float> naiveConv(const std::vector<float>& in, int in_rows, int in_cols, const ConvParams& p,
+    const json& layer, int& out_rows, int& out_cols)
+{
+    out_rows = convOutputSize(in_rows, p.kernel_rows, p.stride_rows, p.dilation_rows, p.same);
+    out_cols = convOutputSize(in_cols, p.kernel_cols, p.stride_cols, p.dilation_cols, p.same);
+    const int pad_top = p.same ? std::max((out_rows - 1) * p.stride_rows + (p.kernel_rows - 1) * p.dilation_rows + 1 - in_rows, 0) / 2 : 0;
+    const int pad_left = p.same ? std::max((out_cols - 1) * p.stride_cols + (p.kernel_cols - 1) * p.dilation_cols + 1 - in_cols, 0) / 2 : 0;
+
+    const auto& kernel = layer["weights"][0];
+    const auto& bias = layer["weights"][1];
+
+    std::vector<float> out((size_t)out_rows * out_cols * p.out_ch);
+    for(int r = 0; r < out_rows; ++r)
+        for(int c = 0; c < out_cols; ++c)
+            for(int o = 0; o < p.out_ch; ++o)
+            {
+                double sum = bias[o].get<float>();
+                for(int i = 0; i < p.kernel_rows; ++i)
+                    for(int j = 0; j < p.kernel_cols; ++j)
+                    {
+                        const int in_r = r * p.stride_rows - pad_top + i * p.dilation_rows;
+                        const int in_c = c * p.stride_cols - pad_left + j * p.dilation_cols;
+                        if(in_r < 0 || in_r >= in_rows || in_c < 0 || in_c >= in_cols)
+                            continue;
+
+                        for(int ch = 0; ch < p.in_ch; ++ch)
+                            sum += in[((size_t)in_r * in_cols + in_c) * p.in_ch + ch] * kernel[i][j][ch][o].get<float>();
+                    }
+
+                out[((size_t)r * out_cols + c) * p.out_ch + o] = p.activation == "relu" ? std::max((float)sum, 0.0f) : (float)sum;
+            }
+
+    return out;
+}
+
+/** Prints the largest difference between the two outputs, and returns true if it is within the tolerance */
+inline bool checkOutputs(const std::string& name, const float* outputs, const std::vector<float>& expected, double tolerance = 1.0e-4)
+{
+    double maxError = 0.0;
+    for(size_t i = 0; i < expected.size(); ++i)
+        maxError = std::max(maxError, (double)std::abs(outputs[i] - expected[i]));
+
+    const bool passed = maxError <= tolerance;
+    printf("%-50s max error %g %s\n", name.c_str(), maxError, passed ? "" : "FAILED");
+    return passed;
+}
+
+#endif // CONV2D_TEST_HELPERS_H_INCLUDED
@@ -0,0 +1,104 @@
+/*
+  Compares the RTNeural Conv2D layers, loaded from Keras-style JSON,
+  with a naive TensorFlow convolution.
+  Returns 1 if any output differs.
+==============================================================================*/
+#include "conv2d_test_helpers.h"
+
+/** Runs a model of two stacked Conv2D layers: the given one followed by a 3x3 "same" convolution */
+bool testConv2D(int in_rows, int in_cols, ConvParams first)
+{
+    first.activation = "relu";
+    ConvParams second { first.out_ch, 3, 3, 3 };
+    second.same = true;
+
+    int rows, cols, out_rows, out_cols;
+    json l1 = convLayer(first, in_rows, in_cols);
+    json l2 = convLayer(second, l1["shape"][1].get<int>(), l1["shape"][2].get<int>());
+
+    json modelJson;
+    modelJson["in_shape"] = first.in_ch == 1 ? json { nullptr, in_rows, in_cols } : json { nullptr, in_rows, in_cols, first.in_ch };
+    modelJson["layers"] = { l1, l2 };
+
+    auto input = randomVector((size_t)in_rows * in_cols * first.in_ch);
+    auto hidden = naiveConv(input, in_rows, in_cols, first, l1, rows, cols);
+    auto expected = naiveConv(hidden, rows, cols, second, l2, out_rows, out_cols);
+
+    char name[128];
+    snprintf(name, sizeof(name), "%dx%dx%d kernel %dx%d stride %dx%d dilation %dx%d %s", in_rows, in_cols, first.in_ch,
+        first.kernel_rows, first.kernel_cols, first.stride_rows, first.stride_cols, first.dilation_rows, first.dilation_cols,
+        first.same ? "same" : "valid");
+
+    auto model = RTNeural::json_parser::parseJson<float>(modelJson);
+    if(model == nullptr || model->layers.back()->out_size != (int)expected.size())
+    {
+        printf("%-50s could not be loaded FAILED\n", name);
+        return false;
+    }
+
+    model->forward(input.data());
+    return checkOutputs(name, model->getOutputs(), expected);
+}
+
+#if MODELT_AVAILABLE
+/** Loads the same kind of model into a ModelT made of Conv2DT layers */
+bool testConv2DT()
+{
+    constexpr int in_rows = 12, in_cols = 10;
+    ConvParams first { 1, 4, 3, 3 };
+    first.same = true;
+    first.activation = "relu";
+    ConvParams second { 4, 3, 2, 2 };
+    second.stride_rows = 2;
+    second.stride_cols = 2;
+
+    json l1 = convLayer(first, in_rows, in_cols);
+    json l2 = convLayer(second, in_rows, in_cols);
+    json modelJson;
+    modelJson["in_shape"] = { nullptr, in_rows, in_cols, 1 };
+    modelJson["layers"] = { l1, l2 };
+
+    RTNeural::ModelT<float, in_rows * in_cols, 6 * 5 * 3,
+        RTNeural::Conv2DT<float, 1, 4, in_rows, in_cols, 3, 3, 1, 1, 1, 1, false>,
+        RTNeural::ReLuActivationT<float, in_rows * in_cols * 4>,
+        RTNeural::Conv2DT<float, 4, 3, in_rows, in_cols, 2, 2, 2, 2, 1, 1, true>>
+        model;
+    model.parseJson(modelJson);
+
+    int rows, cols;
+    auto input = randomVector(in_rows * in_cols);
+    auto hidden = naiveConv(input, in_rows, in_cols, first, l1, rows, cols);
+    auto expected = naiveConv(hidden, rows, cols, second, l2, rows, cols);
+
+    alignas(RTNEURAL_DEFAULT_ALIGNMENT) float modelInput[in_rows * in_cols];
+    std::copy(input.begin(), input.end(), modelInput);
+    model.forward(modelInput);
+    return checkOutputs("ModelT 12x10x1 same, 2x2 stride 2x2 valid", model.getOutputs(), expected);
+}
+#endif
+
+int main()
+{
+    bool passed = true;
+
+    // single channel, valid and same padding
+    passed &= testConv2D(12, 10, { 1, 4, 3, 3 });
+    passed &= testConv2D(12, 10, [] { ConvParams p { 1, 4, 3, 3 }; p.same = true; return p; }());
+    passed &= testConv2D(40, 64, [] { ConvParams p { 1, 16, 3, 3 }; p.same = true; return p; }());
+
+    // multiple channels and strides, with odd padding on the "same" layers
+    passed &= testConv2D(13, 11, [] { ConvParams p { 3, 8, 3, 5, 2, 2 }; p.same = true; return p; }());
+    passed &= testConv2D(13, 11, [] { ConvParams p { 2, 6, 4, 2, 2, 3 }; p.same = true; return p; }());
+    passed &= testConv2D(9, 9, { 4, 1, 2, 2, 3, 2 });
+
+    // dilation
+    passed &= testConv2D(16, 17, { 2, 6, 3, 3, 1, 1, 2, 3 });
+    passed &= testConv2D(16, 17, [] { ConvParams p { 2, 6, 3, 3, 1, 1, 2, 3 }; p.same = true; return p; }());
+
+#if MODELT_AVAILABLE
+    passed &= testConv2DT();
+#endif
+
+    printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+  Compares models of Conv1D, GRU, LSTM and Dense layers before and after
+  their weights and state are moved into the memory arena by planMemory(),
+  and checks that none of these layers is left outside the arena.
+  Returns 1 if any output differs.
+==============================================================================*/
+#include "conv2d_test_helpers.h"
+
+/** Random matrix of the given size, scaled down to keep the recurrent layers away from saturation */
+json randomMatrix(int rows, int cols)
+{
+    json matrix = json::array();
+    for(int i = 0; i < rows; ++i)
+    {
+        auto row = randomVector(cols);
+        for(auto& v : row)
+            v *= 0.5f;
+        matrix.push_back(row);
+    }
+
+    return matrix;
+}
+
+/** Conv1D, GRU, LSTM and Dense layers, with the weights in the Keras order */
+json recurrentModel(int in_size)
+{
+    json kernel = json::array();
+    for(int i = 0; i < 3; ++i)
+        kernel.push_back(randomMatrix(in_size, 5));
+
+    json conv;
+    conv["type"] = "conv1d";
+    conv["activation"] = "tanh";
+    conv["shape"] = { nullptr, nullptr, 5 };
+    conv["kernel_size"] = { 3 };
+    conv["dilation"] = { 2 };
+    conv["weights"] = { kernel, randomVector(5) };
+
+    json gru;
+    gru["type"] = "gru";
+    gru["shape"] = { nullptr, nullptr, 6 };
+    gru["weights"] = { randomMatrix(5, 18), randomMatrix(6, 18), randomMatrix(2, 18) };
+
+    json lstm;
+    lstm["type"] = "lstm";
+    lstm["shape"] = { nullptr, nullptr, 7 };
+    lstm["weights"] = { randomMatrix(6, 28), randomMatrix(7, 28), randomVector(28) };
+
+    json modelJson;
+    modelJson["in_shape"] = { nullptr, nullptr, in_size };
+    modelJson["layers"] = { conv, gru, lstm, denseLayer(7, 2, "") };
+    return modelJson;
+}
+
+/** Builds the same layers as parseJson(), without placing them in the arena */
+std::unique_ptr<RTNeural::Model<float>> createUnplannedModel(const json& modelJson)
+{
+    using namespace RTNeural::json_parser;
+
+    const auto& layers = modelJson["layers"];
+    auto model = std::make_unique<RTNeural::Model<float>>(modelJson["in_shape"].back().get<int>());
+    model->addLayer(createConv1D<float>(model->getNextInSize(), 5, 3, 2, layers[0]["weights"]).release());
+    model->addLayer(createActivation<float>("tanh", 5).release());
+    model->addLayer(createGRU<float>(5, 6, layers[1]["weights"]).release());
+    model->addLayer(createLSTM<float>(6, 7, layers[2]["weights"]).release());
+    model->addLayer(createDense<float>(7, 2, layers[3]["weights"]).release());
+    return model;
+}
+
+bool testRecurrentArena()
+{
+    constexpr int in_size = 3;
+    constexpr int num_steps = 64;
+    const auto modelJson = recurrentModel(in_size);
+
+    auto planned = RTNeural::json_parser::parseJson<float>(modelJson);
+    auto unplanned = createUnplannedModel(modelJson);
+    if(planned == nullptr)
+    {
+        printf("%-50s could not be loaded FAILED\n", "conv1d-gru-lstm-dense");
+        return false;
+    }
+
+    bool passed = true;
+    for(const auto& name : planned->getLayersOutsideArena())
+    {
+        printf("%-50s is outside the arena FAILED\n", name.c_str());
+        passed = false;
+    }
+
+    planned->reset();
+    unplanned->reset();
+
+    std::vector<float> outputs, expected;
+    for(int n = 0; n < num_steps; ++n)
+    {
+        const auto input = randomVector(in_size);
+        planned->forward(input.data());
+        unplanned->forward(input.data());
+
+        outputs.insert(outputs.end(), planned->getOutputs(), planned->getOutputs() + 2);
+        expected.insert(expected.end(), unplanned->getOutputs(), unplanned->getOutputs() + 2);
+    }
+
+    return checkOutputs("conv1d-gru-lstm-dense arena", outputs.data(), expected, 1.0e-6) && passed;
+}
+
+int main()
+{
+    bool passed = testRecurrentArena();
+
+    printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
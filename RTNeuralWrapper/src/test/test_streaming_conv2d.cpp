@@ -0,0 +1,140 @@
+/*
+  Compares the streaming Conv2D models (parseStreamingJson, createStreamingClassifier),
+  fed a few frames per call, with the whole-window model run on the last window_frames frames.
+  Returns 1 if any output differs once the window is full.
+==============================================================================*/
+#include <fstream>
+
+#include "conv2d_test_helpers.h"
+#include "../rtneuralwrapper.h"
+
+namespace
+{
+const int WINDOW_FRAMES = 20;
+const int FRAME_SIZE = 16;
+const int NUM_CLASSES = 5;
+
+/**
+ * 20x16 window: 3x3 valid conv (18x14x4), 3x3 conv dilated 2 along the rows (14x12x6),
+ * 1x3 "same" conv with a column stride of 2 (14x6x5) and a softmax dense layer.
+ */
+json makeModel()
+{
+    ConvParams conv1 { 1, 4, 3, 3 };
+    conv1.activation = "relu";
+    ConvParams conv2 { 4, 6, 3, 3, 1, 1, 2, 1 };
+    conv2.activation = "tanh";
+    ConvParams conv3 { 6, 5, 1, 3, 1, 2 };
+    conv3.same = true;
+
+    json modelJson;
+    modelJson["in_shape"] = { nullptr, WINDOW_FRAMES, FRAME_SIZE };
+    modelJson["layers"] = { convLayer(conv1, WINDOW_FRAMES, FRAME_SIZE), convLayer(conv2, 18, 14), convLayer(conv3, 14, 12),
+        denseLayer(14 * 6 * 5, NUM_CLASSES, "softmax") };
+    return modelJson;
+}
+
+bool testStreamingModel(const json& modelJson, int numFrames)
+{
+    auto window = RTNeural::json_parser::parseJson<float>(modelJson);
+    auto streaming = RTNeural::json_parser::parseStreamingJson<float>(modelJson, numFrames);
+    if(window == nullptr || streaming == nullptr)
+    {
+        printf("streaming model, %d frames per call: could not be loaded FAILED\n", numFrames);
+        return false;
+    }
+    streaming->reset();
+
+    std::vector<float> frames;
+    std::vector<float> streamingOutputs;
+    std::vector<float> expected;
+    for(int call = 0; call < 2 * WINDOW_FRAMES / numFrames + 8; ++call)
+    {
+        auto input = randomVector((size_t)numFrames * FRAME_SIZE);
+        frames.insert(frames.end(), input.begin(), input.end());
+        streaming->forward(input.data());
+
+        if(frames.size() < (size_t)WINDOW_FRAMES * FRAME_SIZE)
+            continue;
+
+        window->forward(frames.data() + frames.size() - WINDOW_FRAMES * FRAME_SIZE);
+        streamingOutputs.insert(streamingOutputs.end(), streaming->getOutputs(), streaming->getOutputs() + NUM_CLASSES);
+        expected.insert(expected.end(), window->getOutputs(), window->getOutputs() + NUM_CLASSES);
+    }
+
+    return checkOutputs("streaming model, " + std::to_string(numFrames) + " frames per call",
+        streamingOutputs.data(), expected, 1.0e-5);
+}
+
+#ifndef USE_COMPILE_TIME_API
+bool testStreamingClassifier(const std::string& filename, int numFrames)
+{
+    ClassifierPtr streaming = createStreamingClassifier(filename, numFrames);
+    ClassifierPtr window = createClassifier(filename);
+
+    const std::string name = "createStreamingClassifier, " + std::to_string(numFrames) + " frames per call";
+    if(getModelInputSize1d(streaming) != (size_t)numFrames * FRAME_SIZE)
+    {
+        printf("%-50s input size %zu FAILED\n", name.c_str(), getModelInputSize1d(streaming));
+        deleteClassifier(streaming);
+        deleteClassifier(window);
+        return false;
+    }
+
+    bool sameClasses = true;
+    std::vector<float> frames;
+    std::vector<float> streamingOutputs;
+    std::vector<float> expected;
+    for(int call = 0; call < 2 * WINDOW_FRAMES / numFrames + 8; ++call)
+    {
+        auto input = randomVector((size_t)numFrames * FRAME_SIZE);
+        frames.insert(frames.end(), input.begin(), input.end());
+
+        float streamingOut[NUM_CLASSES], windowOut[NUM_CLASSES];
+        const int streamingClass = classify(streaming, input.data(), input.size(), streamingOut, NUM_CLASSES);
+        if(frames.size() < (size_t)WINDOW_FRAMES * FRAME_SIZE)
+            continue;
+
+        const int windowClass = classify(window, frames.data() + frames.size() - WINDOW_FRAMES * FRAME_SIZE,
+            WINDOW_FRAMES * FRAME_SIZE, windowOut, NUM_CLASSES);
+        sameClasses &= streamingClass == windowClass;
+        streamingOutputs.insert(streamingOutputs.end(), streamingOut, streamingOut + NUM_CLASSES);
+        expected.insert(expected.end(), windowOut, windowOut + NUM_CLASSES);
+    }
+
+    deleteClassifier(streaming);
+    deleteClassifier(window);
+
+    if(! sameClasses)
+        printf("%-50s predicted classes differ FAILED\n", name.c_str());
+    return checkOutputs(name, streamingOutputs.data(), expected, 1.0e-5) && sameClasses;
+}
+#endif
+} // namespace
+
+int main()
+{
+    const json modelJson = makeModel();
+    bool passed = true;
+
+    // 24 frames per call is more than the 20 and 14 frame windows, so the streaming windows drop the oldest input frames
+    for(int numFrames : { 1, 3, 24 })
+        passed &= testStreamingModel(modelJson, numFrames);
+
+    json samePadding = modelJson;
+    samePadding["layers"][0]["padding"] = "same";
+    const bool rejected = RTNeural::json_parser::parseStreamingJson<float>(samePadding) == nullptr;
+    printf("%-50s %s\n", "\"same\" padding along the frames rejected", rejected ? "" : "FAILED");
+    passed &= rejected;
+
+#ifndef USE_COMPILE_TIME_API
+    const std::string filename = "streaming_conv2d_test.json";
+    std::ofstream(filename) << modelJson.dump();
+    for(int numFrames : { 1, 3 })
+        passed &= testStreamingClassifier(filename, numFrames);
+    std::remove(filename.c_str());
+#endif
+
+    printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
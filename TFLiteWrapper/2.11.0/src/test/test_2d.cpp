@@ -92,6 +92,44 @@ int main(int argc, char* argv[])
         if (std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count() > 1000)
             std::cout << "test2d | (or " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << "ms)" << std::endl;
     }
+
+    // Streaming input: push the rows of the last matrix one per hop, the full window must give the same output
+    InferenceEngine::StreamingInputPtr stream = InferenceEngine::createStreamingInput(tc, in_cols);
+    std::vector<float> streaming_output_vec(out_size);
+    for (size_t r = 0; r < in_rows; ++r)
+    {
+        InferenceEngine::pushFrame(stream, &my_input_vec[r * in_cols]);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        int result = InferenceEngine::invokeStreaming(stream, streaming_output_vec.data(), out_size, verbose);
+        auto stop = std::chrono::high_resolution_clock::now();
+
+        if (r == in_rows - 1)
+        {
+            printf("test2d | Streaming predicted class %d confidence: %f\n", result, streaming_output_vec[result]);
+            std::cout << "test2d | Streaming hop took " << std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count() << "us" << std::endl;
+        }
+    }
+    if (streaming_output_vec != my_output_vec)
+    {
+        fprintf(stderr, "test2d | Streaming output differs from invokeFlat2D output\n");
+        return 1;
+    }
+    InferenceEngine::deleteStreamingInput(stream);
+
+    // Same with column frames, pushed from the row-major matrix with a stride of one row
+    stream = InferenceEngine::createStreamingInput(tc, in_rows, 0, InferenceEngine::FrameLayout::Columns);
+    for (size_t c = 0; c < in_cols; ++c)
+    {
+        InferenceEngine::pushFrame(stream, &my_input_vec[c], in_cols);
+        InferenceEngine::invokeStreaming(stream, streaming_output_vec.data(), out_size, verbose);
+    }
+    if (streaming_output_vec != my_output_vec)
+    {
+        fprintf(stderr, "test2d | Column streaming output differs from invokeFlat2D output\n");
+        return 1;
+    }
+    InferenceEngine::deleteStreamingInput(stream);
     InferenceEngine::deleteInterpreter(tc);
 
     std::cout << "test2d | Test completed successfully                        #" << std::endl;
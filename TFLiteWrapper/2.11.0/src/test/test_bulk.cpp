@@ -9,172 +9,13 @@
 #include <array>
 #include <chrono>
 #include <cstdlib>
-
-#include "../tflitewrapper.h"
-
-const std::size_t IN_SIZE = 180,
-                  OUT_SIZE = 8;
-
-#include <iostream>
-#include <fstream>
-#include <istream>
 #include <string>
 #include <vector>
-#include <array>
-
-enum class CSVState
-{
-    UnquotedField,
-    QuotedField,
-    QuotedQuote
-};
-
-std::vector<std::string> readCSVRow(const std::string &row)
-{
-    CSVState state = CSVState::UnquotedField;
-    std::vector<std::string> fields{""};
-    size_t i = 0; // index of the current field
-    for (char c : row)
-    {
-        switch (state)
-        {
-        case CSVState::UnquotedField:
-            switch (c)
-            {
-            case ',': // end of field
-                fields.push_back("");
-                i++;
-                break;
-            case '"':
-                state = CSVState::QuotedField;
-                break;
-            default:
-                fields[i].push_back(c);
-                break;
-            }
-            break;
-        case CSVState::QuotedField:
-            switch (c)
-            {
-            case '"':
-                state = CSVState::QuotedQuote;
-                break;
-            default:
-                fields[i].push_back(c);
-                break;
-            }
-            break;
-        case CSVState::QuotedQuote:
-            switch (c)
-            {
-            case ',': // , after closing quote
-                fields.push_back("");
-                i++;
-                state = CSVState::UnquotedField;
-                break;
-            case '"': // "" -> "
-                fields[i].push_back('"');
-                state = CSVState::QuotedField;
-                break;
-            default: // end of quote
-                state = CSVState::UnquotedField;
-                break;
-            }
-            break;
-        }
-    }
-    return fields;
-}
-
-/// Read CSV file, Excel dialect. Accept "quoted fields ""with quotes"""
-std::vector<std::vector<std::string>> readCSV(std::istream &in, bool skipHeader = true)
-{
-    std::vector<std::vector<std::string>> table;
-    std::string row;
-    if(!in.eof() && skipHeader)
-        std::getline(in, row);
-    while (!in.eof())
-    {
-        std::getline(in, row);
-        if (in.bad() || in.fail())
-        {
-            break;
-        }
-        auto fields = readCSVRow(row);
-        table.push_back(fields);
-    }
-    return table;
-}
-
-std::vector<std::array<float,IN_SIZE>> stringVec2FeatureVec(const std::vector<std::vector<std::string>> &in)
-{
-    std::vector<std::array<float,IN_SIZE>> res;
-
-    for (const auto row : in)
-    {
-        std::array<float,IN_SIZE> parz = std::array<float,IN_SIZE>();
-        if (row.size() != IN_SIZE)
-            throw std::logic_error("Wrong number of features in input file (found " + std::to_string(row.size()) + "instead of" + std::to_string(IN_SIZE) + ")");
-        for (size_t idx = 0; idx < IN_SIZE; ++idx)
-        {
-            try
-            {
-                parz[idx] = std::stof(row[idx]);
-            }
-            catch(const std::invalid_argument& e)
-            {
-                std::cerr << e.what() << '\n' << "Failed converting '" << row[idx] << "' to float";
-            }
-            catch(const std::exception& e)
-            {
-                std::cerr << e.what() << '\n';
-            }
-            
-        }
-        res.push_back(parz);
-    }
-
-    return res;
-}
 
+#include "../tflitewrapper.h"
+#include "dataset.h"
 
-std::vector<int> stringVec2LabelsVec(const std::vector<std::vector<std::string>> &in)
-{
-    std::vector<int>  res;
-    for (const auto row : in)
-    {
-        if (row.size() != 1)
-            throw std::logic_error("Wrong number of labels in a row of the input file (found " + std::to_string(row.size()) + "instead of" + std::to_string(IN_SIZE) + ")");
-
-        // convert first and only string to float
-        try {
-            res.push_back(std::stof(row[0]));
-        }
-        catch(const std::invalid_argument& e) {
-            std::cerr << e.what() << '\n' << "Failed converting '" << row[0] << "' to float";
-        }
-        catch(const std::exception& e) {
-            std::cerr << e.what() << '\n';
-        }
-    }
-    return res;
-}
-
-void printVec(std::vector<std::array<float,IN_SIZE>> &in, size_t row)
-{
-    if (row <= in.size()) {
-        for (const auto col : in[row]) {
-            std::cout << "'" << col << "' ";
-        }
-        std::cout << std::endl;
-    }
-}
-
-void printVec(std::vector<std::array<float,IN_SIZE>> &in)
-{
-    for (size_t row = 0; row < in.size(); ++row)
-        printVec(in, row);
-}
+const std::size_t OUT_SIZE = 8;
 
 int main(int argc, char *argv[])
 {
@@ -196,46 +37,29 @@ int main(int argc, char *argv[])
     const char *labelspath_cstr = argv[3];
     std::string labelspath(labelspath_cstr);
 
-    // Read features file
-
-    std::string line;
-    std::ifstream featuresFile(featurespath);
-    std::vector<std::array<float,IN_SIZE>> featureVectors = std::vector<std::array<float,IN_SIZE>>();
-    if (featuresFile.is_open())
-    {
-        featureVectors = stringVec2FeatureVec(readCSV(featuresFile));
-        // printVec(featureVectors,0); // for debugging
-        featuresFile.close();
-    }
-    else
-        throw std::logic_error("Unable to open file");
-
-    // Read labels file
-
-    std::ifstream labelsFile(labelspath);
-    std::vector<int> y_true = std::vector<int>();
-    if (labelsFile.is_open())
-    {
-        y_true = stringVec2LabelsVec(readCSV(labelsFile));
-        labelsFile.close();
-    }
-    else
-        throw std::logic_error("Unable to open file");
-
-
+    // Read features and labels (parsed in parallel, cached as .npy next to the CSV files)
+    auto loadStart = std::chrono::steady_clock::now();
+    WrapperTools::Dataset::Matrix featureVectors = WrapperTools::Dataset::load(featurespath);
+    std::vector<int> y_true = WrapperTools::Dataset::toLabels(WrapperTools::Dataset::load(labelspath));
+    auto loadStop = std::chrono::steady_clock::now();
+    std::cout << "Loaded " << featureVectors.rows << " feature vectors in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(loadStop - loadStart).count() << " ms" << std::endl;
 
     InferenceEngine::InterpreterPtr tc = InferenceEngine::createInterpreter(modelpath);
 
+    if (featureVectors.cols != InferenceEngine::getModelInputSize1d(tc))
+        throw std::logic_error("Wrong number of features in input file (found " + std::to_string(featureVectors.cols) + " instead of " + std::to_string(InferenceEngine::getModelInputSize1d(tc)) + ")");
+
     std::array<float, OUT_SIZE> my_output_vec;
     for (size_t i = 0; i < OUT_SIZE; ++i)
         my_output_vec[i] = 0.0f;
 
     std::vector<int> y_pred = std::vector<int>();
-    for (size_t i = 0; i < featureVectors.size(); ++i)
+    for (size_t i = 0; i < featureVectors.rows; ++i)
     {
         auto start = std::chrono::high_resolution_clock::now();
 
-        int result = InferenceEngine::invoke(tc, featureVectors[i], my_output_vec);
+        int result = InferenceEngine::invoke(tc, featureVectors.row(i), featureVectors.cols, my_output_vec.data(), OUT_SIZE);
 
         auto stop = std::chrono::high_resolution_clock::now();
 
@@ -251,7 +75,7 @@ int main(int argc, char *argv[])
 
 
 
-    std::cout << "Total feature vectors: " << featureVectors.size() << std::endl;
+    std::cout << "Total feature vectors: " << featureVectors.rows << std::endl;
     if (y_pred.size() != y_true.size())
         throw std::logic_error("Number of predictions differs from the number of true labels (" + std::to_string(y_pred.size()) + "!=" + std::to_string(y_true.size()) + ")");
 
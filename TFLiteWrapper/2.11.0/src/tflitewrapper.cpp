@@ -4,15 +4,25 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <limits>  // std::numeric_limits
+#include <map>
+#include <memory>
+#include <mutex>
 #include <utility>
 
 #include "tensorflow/lite/interpreter.h"
 #include "tensorflow/lite/kernels/register.h"
 #include "tensorflow/lite/model.h"
 #include "tensorflow/lite/optional_debug_tools.h"
+#include "tensorflow/lite/profiling/buffered_profiler.h"
+#if TFLITEWRAPPER_XNNPACK
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#endif
 
 namespace InferenceEngine {
 
@@ -26,55 +36,249 @@ using namespace tflite;
         exit(1);                                                 \
     }
 
+/**
+ * Quantize like the TFLite Quantize operator: round(value / scale) + zeroPoint, saturated.
+ * Branch-free loop the compiler vectorizes (std::round is a single instruction on ARMv8 and with SSE4.1)
+ */
+template <typename T>
+static void quantize(const float input[], T output[], size_t size, float scale, int32_t zeroPoint) {
+    const float low = (float)((int32_t)std::numeric_limits<T>::min() - zeroPoint);
+    const float high = (float)((int32_t)std::numeric_limits<T>::max() - zeroPoint);
+    for (size_t i = 0; i < size; ++i) {
+        const float value = std::round(std::min(std::max(input[i] / scale, low), high));
+        output[i] = (T)((int32_t)value + zeroPoint);
+    }
+}
+
+template <typename T>
+static void dequantize(const T input[], float output[], size_t size, float scale, int32_t zeroPoint) {
+    for (size_t i = 0; i < size; ++i)
+        output[i] = scale * (float)((int32_t)input[i] - zeroPoint);
+}
+
+/**
+ * Input or output tensor of the model, float or per-tensor quantized int8/uint8.
+ * The float API of the wrapper is kept for quantized models: inputs are quantized and outputs dequantized in invoke.
+ */
+struct TensorIo {
+    std::string name;
+    std::vector<int64_t> shape;
+    size_t size = 0;  // Number of elements
+
+    TfLiteType type = kTfLiteFloat32;
+    void *data = nullptr;
+    float scale = 1.0f;  // real = scale * (quantized - zeroPoint)
+    int32_t zeroPoint = 0;
+
+    // Float values of the bound API: the tensor itself for float tensors, a staging buffer for quantized tensors
+    float *buffer = nullptr;
+    std::vector<float> staging;
+
+    bool isQuantized() const { return type != kTfLiteFloat32; }
+
+    /** Copy (quantize) size float values into the tensor */
+    void write(const float values[]) {
+        if (type == kTfLiteInt8)
+            quantize(values, (int8_t *)data, size, scale, zeroPoint);
+        else if (type == kTfLiteUInt8)
+            quantize(values, (uint8_t *)data, size, scale, zeroPoint);
+        else if (values != data)
+            std::memcpy(data, values, size * sizeof(float));
+    }
+
+    /** Copy (dequantize) the size values of the tensor as float */
+    void read(float values[]) const {
+        if (type == kTfLiteInt8)
+            dequantize((const int8_t *)data, values, size, scale, zeroPoint);
+        else if (type == kTfLiteUInt8)
+            dequantize((const uint8_t *)data, values, size, scale, zeroPoint);
+        else if (values != data)
+            std::memcpy(values, data, size * sizeof(float));
+    }
+};
+
+/** Describe an allocated tensor, throw if its type is not supported */
+static TensorIo getTensorIo(const TfLiteTensor *tensor, const char *what) {
+    TensorIo io;
+    io.name = tensor->name != nullptr ? tensor->name : "";
+    io.shape.assign(tensor->dims->data, tensor->dims->data + tensor->dims->size);
+    io.size = 1;
+    for (int i = 0; i < tensor->dims->size; ++i)
+        io.size *= (size_t)tensor->dims->data[i];
+    io.type = tensor->type;
+    io.data = tensor->data.raw;
+    if (io.data == nullptr)
+        throw std::runtime_error(std::string("Failed to get pointer to the ") + what + " tensor (not allocated).");
+
+    switch (tensor->type) {
+    case kTfLiteFloat32:
+        io.buffer = (float *)io.data;
+        break;
+    case kTfLiteInt8:
+    case kTfLiteUInt8:
+        // params holds the per-tensor quantization, which is what the converter produces for the model inputs/outputs
+        if (tensor->quantization.type == kTfLiteAffineQuantization && tensor->quantization.params != nullptr &&
+            ((const TfLiteAffineQuantization *)tensor->quantization.params)->scale->size > 1)
+            throw std::runtime_error(std::string("Per-channel quantized ") + what + " tensors are not supported.");
+        io.scale = tensor->params.scale;
+        io.zeroPoint = tensor->params.zero_point;
+        if (!(io.scale > 0.0f))
+            throw std::runtime_error(std::string("The quantized ") + what + " tensor has no valid scale (" + std::to_string(io.scale) + ").");
+        io.staging.assign(io.size, 0.0f);
+        io.buffer = io.staging.data();
+        break;
+    default:
+        throw std::runtime_error(std::string("Unsupported ") + what + " tensor type " + TfLiteTypeGetName(tensor->type) + " (float32, int8 and uint8 are supported).");
+    }
+    return io;
+}
+
+#if TFLITEWRAPPER_XNNPACK
+/**
+ * Packed weights of XNNPACK, shared by the interpreters of the same model.
+ * The first interpreter packs the weights and finalizes the cache, the next ones find them in the cache.
+ */
+class XnnpackWeightsCache {
+public:
+    XnnpackWeightsCache() : cache(TfLiteXNNPackDelegateWeightsCacheCreate()) {
+        if (cache == nullptr)
+            throw std::runtime_error("Failed to create the XNNPACK weights cache");
+    }
+    ~XnnpackWeightsCache() { TfLiteXNNPackDelegateWeightsCacheDelete(cache); }
+
+    XnnpackWeightsCache(const XnnpackWeightsCache &) = delete;
+    XnnpackWeightsCache &operator=(const XnnpackWeightsCache &) = delete;
+
+    TfLiteXNNPackDelegateWeightsCache *get() const { return cache; }
+
+    /** Held while an interpreter applies the delegate, so that the cache is finalized once */
+    std::mutex mutex;
+    bool finalized = false;
+
+private:
+    TfLiteXNNPackDelegateWeightsCache *cache;
+};
+
+/** Cache of the model with the given key (file path or buffer address), created if no interpreter uses it */
+static std::shared_ptr<XnnpackWeightsCache> getSharedWeightsCache(const std::string &key) {
+    static std::mutex cachesMutex;
+    static std::map<std::string, std::weak_ptr<XnnpackWeightsCache>> caches;
+
+    std::lock_guard<std::mutex> lock(cachesMutex);
+    std::shared_ptr<XnnpackWeightsCache> cache = caches[key].lock();
+    if (!cache) {
+        cache = std::make_shared<XnnpackWeightsCache>();
+        caches[key] = cache;
+    }
+    return cache;
+}
+#endif
+
 // Definition of the Interpreter class
 class InterpreterWrap {
 public:
     /** Constructor */
-    InterpreterWrap(const std::string &filename, bool verbose = false);            // Construct from file path
-    InterpreterWrap(const char *buffer, size_t bufferSize, bool verbose = false);  // Construct from buffer
-    void buildAndPrime(bool verbose = false);                                      // Build and prime the interpreter | Common part to the two constructors
+    InterpreterWrap(const std::string &filename, const InterpreterOptions &options, bool verbose = false);            // Construct from file path
+    InterpreterWrap(const char *buffer, size_t bufferSize, const InterpreterOptions &options, bool verbose = false);  // Construct from buffer
+    void buildAndPrime(bool verbose = false);                                                                         // Build and prime the interpreter | Common part to the two constructors
     /** Internal interpreter invocation function, called by wrappers */
     int invoke_internal(const float inputVector[], size_t inputSize, float outputVector[], size_t outputSize, bool verbose = false);
 
+    /** Run the model on the values of the bound input buffers, results in the bound output buffers */
+    void invokeBound();
+
+    /** Inputs/outputs of the model, in the order of the model */
+    const std::vector<TensorIo> &getInputs() const { return inputs; }
+    const std::vector<TensorIo> &getOutputs() const { return outputs; }
+
     int requestedInputSize() const;
     int requested2drows() const;
     int requested2dcols() const;
     int requestedOutputSize() const;
 
+    /** Attach/detach the per-operator profiler */
+    void enableProfiling(OpEventSink sink);
+    void disableProfiling();
+
+    /** Duration of the phases of the constructor */
+    const std::vector<StartupPhase> &getStartupPhases() const { return startupPhases; }
+
+    /** Nodes of the execution plan run by a delegate */
+    void getDelegatedNodeCount(size_t &delegateNodes, size_t &totalNodes) const;
+
+    /** Copy the output of a single-output model after invokeBound, return the argmax */
+    int readSingleOutput(float outputVector[], size_t outputSize) const;
+
 private:
     /** Step 1, TFLITE loading the .tflite model */
     std::unique_ptr<tflite::FlatBufferModel> loadModel(const std::string &filename);
     std::unique_ptr<tflite::FlatBufferModel> loadModelFromBuffer(const char *buffer, size_t bufferSize);
     /** Step 2, TFLITE building the interpreter */
     std::unique_ptr<Interpreter> buildInterpreter(const std::unique_ptr<tflite::FlatBufferModel> &model);
+    /** Step 2b, apply the XNNPACK delegate (before the tensors are allocated) */
+    void applyXnnpackDelegate(bool verbose);
+    /** Step 4b, check that invoking again does not (re)allocate tensors */
+    void checkPriming();
+
+    /** Invoke the interpreter and collect the profile */
+    void run();
 
     /** ind the index of the maximum value in an array */
     int argmax(const float vec[], size_t vecSize) const;
 
     /** Check the input size requested by a tflite model */
 
+    /** Pass the operator events recorded by the profiler to the sink and clear them */
+    void flushProfileEvents();
+
+    /** Record the time since the end of the previous phase (or the start of the constructor) */
+    void endStartupPhase(const char *name);
+
+    std::vector<StartupPhase> startupPhases;
+    std::chrono::steady_clock::time_point phaseStart;
+
+    InterpreterOptions options;
+    std::string weightsCacheKey;  // Identifies the model for the shared XNNPACK weights
+
     //--------------------------------------------------------------------------
 
+#if TFLITEWRAPPER_XNNPACK
+    // Declared before the interpreter, which uses the delegate (and the delegate the weights) until it is destroyed
+    std::shared_ptr<XnnpackWeightsCache> weightsCache;
+    std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate *)> xnnpackDelegate{nullptr, TfLiteXNNPackDelegateDelete};
+#endif
+
+    // Declared before the interpreter, which keeps a pointer to the profiler until it is destroyed
+    std::unique_ptr<tflite::profiling::BufferedProfiler> profiler;
+    OpEventSink profilingSink;
+    int profiledInvocations = 0;
+
     std::unique_ptr<FlatBufferModel> model;
     std::unique_ptr<Interpreter> interpreter;
 
-    float *inputTensorPtr, *outputTensorPtr;
+    std::vector<TensorIo> inputs, outputs;
 };
 
-InterpreterWrap::InterpreterWrap(const std::string &filename, bool verbose) {
+InterpreterWrap::InterpreterWrap(const std::string &filename, const InterpreterOptions &options, bool verbose)
+    : options(options), weightsCacheKey("file:" + filename) {
+    phaseStart = std::chrono::steady_clock::now();
     // Load model
     if (verbose)
         std::cout << "Interpreter\t|\tconstructor\t| Loading model from path: '" << filename << "'..." << std::endl;
     this->model = loadModel(filename);
+    endStartupPhase("load");
 
     buildAndPrime(verbose);
 }
 
-InterpreterWrap::InterpreterWrap(const char *buffer, size_t bufferSize, bool verbose) {
+InterpreterWrap::InterpreterWrap(const char *buffer, size_t bufferSize, const InterpreterOptions &options, bool verbose)
+    : options(options), weightsCacheKey("buffer:" + std::to_string((uintptr_t)buffer) + ":" + std::to_string(bufferSize)) {
+    phaseStart = std::chrono::steady_clock::now();
     // Load model
     if (verbose)
         std::cout << "Interpreter\t|\tconstructor\t| Loading model from buffer..." << std::endl;
     this->model = loadModelFromBuffer(buffer, bufferSize);
+    endStartupPhase("load");
 
     buildAndPrime(verbose);
 }
@@ -84,75 +288,50 @@ void InterpreterWrap::buildAndPrime(bool verbose) {
     if (verbose)
         std::cout << "Interpreter\t|\tconstructor\t| Done.\nInterpreter\t|\tconstructor\t| Building interpreter..." << std::endl;
     this->interpreter = buildInterpreter(model);
+    if (interpreter == nullptr)
+        throw std::runtime_error("Interpreter\t|\tconstructor\t| Failed to build interpreter. Return value is NULL.");
+
+    // Configure the interpreter (the thread count is set by the builder), before delegates and allocation use the settings
+    interpreter->SetAllowFp16PrecisionForFp32(options.allowFp16PrecisionForFp32);
+    if (options.useXnnpack)
+        applyXnnpackDelegate(verbose);
+    endStartupPhase("build");
+
     // Allocate tensor buffers.
     if (verbose)
         std::cout << "Interpreter\t|\tconstructor\t| Done.\nInterpreter\t|\tconstructor\t| Allocating tensor buffers..." << std::endl;
     TFLITE_MINIMAL_CHECK(interpreter->AllocateTensors() == kTfLiteOk);
-    // assert(interpreter != nullptr);
-    // Configure the interpreter
-    interpreter->SetAllowFp16PrecisionForFp32(true);
-    interpreter->SetNumThreads(1);
-
-    if (interpreter == nullptr)
-        throw std::runtime_error("Interpreter\t|\tconstructor\t| Failed to build interpreter. Return value is NULL.");
 
     if (verbose) {
         std::cout << "Interpreter\t|\tconstructor\t| Interpreter built successfully." << std::endl;
         tflite::PrintInterpreterState(interpreter.get());
     }
 
-    // Get pointer to the input Tensor
+    // Describe the inputs and outputs, the buffers stay valid since the tensors are not allocated again
     if (verbose)
-        std::cout << "Interpreter\t|\tconstructor\t| Done.\nInterpreter\t|\tconstructor\t| Getting pointer to the input tensor..." << std::endl;
-    if (interpreter->inputs().size() != 1)
-        throw std::runtime_error("Error, the model has more than one input tensor.  This is not supported.");
-    else if (verbose) {
-        std::cout << "Interpreter\t|\tconstructor\t| The model has " << interpreter->inputs().size() << " input tensors." << std::endl;
-        for (size_t i = 0; i < interpreter->inputs().size(); ++i) {
-            TfLiteIntArray *input_dims = interpreter->tensor(interpreter->inputs()[i])->dims;
-            // Print all sizes of the input tensor
-            for (int j = 0; j < input_dims->size; ++j) {
-                std::cout << "Interpreter\t|\tconstructor\t| Input tensor [" << i << "] at interpreter index " << this->interpreter->inputs()[i] << " has dimension " << j << " with size: " << input_dims->data[j] << std::endl
-                          << std::flush;
+        std::cout << "Interpreter\t|\tconstructor\t| Done.\nInterpreter\t|\tconstructor\t| Getting the input and output tensors..." << std::endl;
+    for (size_t i = 0; i < interpreter->inputs().size(); ++i)
+        this->inputs.push_back(getTensorIo(interpreter->input_tensor(i), "input"));
+    for (size_t i = 0; i < interpreter->outputs().size(); ++i)
+        this->outputs.push_back(getTensorIo(interpreter->output_tensor(i), "output"));
+    if (inputs.empty() || outputs.empty())
+        throw std::runtime_error("Error, the model has no input or no output tensor.");
+
+    if (verbose) {
+        std::cout << "Interpreter\t|\tconstructor\t| The model has " << inputs.size() << " input tensor(s) and " << outputs.size() << " output tensor(s)." << std::endl;
+        for (const auto *tensors : {&inputs, &outputs}) {
+            for (size_t i = 0; i < tensors->size(); ++i) {
+                const TensorIo &io = (*tensors)[i];
+                std::cout << "Interpreter\t|\tconstructor\t| " << (tensors == &inputs ? "Input" : "Output") << " tensor [" << i << "] '" << io.name << "' shape [";
+                for (size_t d = 0; d < io.shape.size(); ++d)
+                    std::cout << (d > 0 ? ", " : "") << io.shape[d];
+                std::cout << "] type " << TfLiteTypeGetName(io.type);
+                if (io.isQuantized())
+                    std::cout << " (scale " << io.scale << ", zero point " << io.zeroPoint << ", converted from/to float by invoke)";
+                std::cout << std::endl;
             }
-            // auto input_size = input_dims->data[input_dims->size - 1];
-            // auto input_type = TfLiteTypeGetName(interpreter->tensor(interpreter->inputs()[i])->type);
-            // std::cout << "Input tensor [" << i << "] at interpreter index " << this->interpreter->inputs()[i] << "
-            // has lenth: " << input_size << " and type: " << input_type << std::endl << std::flush;
         }
     }
-    this->inputTensorPtr = interpreter->typed_input_tensor<float>(
-        0);  // Based on the code at
-             // https://github.com/google-coral/edgetpu/blob/75e675633c2110a991426c8afa64f122b16ac372/src/cpp/examples/model_utils.cc
-             // , the index used here always start from 0 and has no relation to the this->interpreter->inputs()[i]
-    // assert (inputTensorPtr != nullptr);
-    if (inputTensorPtr == nullptr)
-        throw std::runtime_error(
-            "Failed to get pointer to the input tensor.  interpreter->typed_input_tensor<float>(0) returns NULL.");
-
-    // Get pointer to the output Tensor
-    if (verbose)
-        std::cout << "Interpreter\t|\tconstructor\t| Done.\nInterpreter\t|\tconstructor\t| Getting pointer to the output tensor..." << std::endl;
-    if (interpreter->outputs().size() != 1)
-        throw std::runtime_error("Error, the model has more than one output tensor.  This is not supported.");
-    else if (verbose) {
-        std::cout << "Interpreter\t|\tconstructor\t| The model has " << interpreter->outputs().size() << " output tensors." << std::endl;
-        for (size_t i = 0; i < interpreter->outputs().size(); ++i) {
-            TfLiteIntArray *output_dims = interpreter->tensor(interpreter->outputs()[i])->dims;
-            auto output_size = output_dims->data[output_dims->size - 1];
-            auto output_type = TfLiteTypeGetName(interpreter->tensor(interpreter->outputs()[i])->type);
-            std::cout << "Interpreter\t|\tconstructor\t| Output tensor [" << i << "] at interpreter index " << this->interpreter->outputs()[i] << " has lenth: " << output_size << " and type: " << output_type << std::endl
-                      << std::flush;
-        }
-    }
-    this->outputTensorPtr = interpreter->typed_output_tensor<float>(
-        0);  // Based on the code at
-             // https://github.com/google-coral/edgetpu/blob/75e675633c2110a991426c8afa64f122b16ac372/src/cpp/examples/model_utils.cc
-             // , the index used here always start from 0 and has no relation to the this->interpreter->outputs()[i]
-    // assert (outputTensorPtr != nullptr);
-    if (outputTensorPtr == nullptr)
-        throw std::runtime_error(
-            "Failed to get pointer to the output tensor.  interpreter->typed_output_tensor<float>(0) returns NULL.");
 
     bool prime2d = (interpreter->tensor(interpreter->inputs()[0])->dims->size == 4);
     if (verbose) {
@@ -163,24 +342,22 @@ void InterpreterWrap::buildAndPrime(bool verbose) {
         else
             std::cout << "Interpreter\t|\tconstructor\t| The model is a 1D model." << std::endl;
     }
+    endStartupPhase("allocate");
+
     // Prime the Interpreter
     if (verbose)
         std::cout << "Interpreter\t|\tconstructor\t| Done.\nInterpreter\t|\tconstructor\t| Priming the Interpreter (Calling inference once)..." << std::endl;
-    std::vector<float> pIv;
-    if (prime2d) {
-        if (verbose) {
+    if (verbose) {
+        if (prime2d)
             std::cout << "Interpreter\t|\tconstructor\t| Input size: [" << this->requested2drows() << " x " << this->requested2dcols() << "] | Output size: " << this->requestedOutputSize() << std::endl;
-        }
-        pIv.resize(this->requested2drows() * this->requested2dcols());
-    } else {
-        if (verbose) {
+        else
             std::cout << "Interpreter\t|\tconstructor\t| Input size: " << this->requestedInputSize() << " | Output size: " << this->requestedOutputSize() << std::endl;
-        }
-        pIv.resize(this->requestedInputSize());
     }
-    std::vector<float> pOv;
-    pOv.resize(this->requestedOutputSize());
-    this->invoke_internal(&pIv[0], pIv.size(), &pOv[0], pOv.size(), verbose);
+    // All the input buffers are zero
+    this->invokeBound();
+    if (options.primingCheck != PrimingCheck::Off)
+        checkPriming();
+    endStartupPhase("prime");
     if (verbose)
         std::cout << "Interpreter\t|\tconstructor\t| Done.\nInterpreter\t|\tconstructor\t| Interpreter primed." << std::endl;
 
@@ -191,29 +368,24 @@ void InterpreterWrap::buildAndPrime(bool verbose) {
 }
 
 int InterpreterWrap::invoke_internal(const float inputVector[], size_t inputSize, float outputVector[], size_t outputSize, bool verbose) {
+    if (inputs.size() != 1 || outputs.size() != 1)
+        throw std::logic_error("Error, the model has " + std::to_string(inputs.size()) + " inputs and " + std::to_string(outputs.size()) + " outputs, use the bound buffers and invokeBound");
     if (verbose) {
         std::cout << "Interpreter\t|\tinvoke_internal\t| Input size: " << inputSize << " | Output size: " << outputSize << std::endl;
         std::cout << "Interpreter\t|\tinvoke_internal\t| Filling input tensor..." << std::endl
                   << std::flush;
     }
     // Fill `input`.
-    for (size_t i = 0; i < inputSize; ++i) {
-        this->inputTensorPtr[i] = inputVector[i];
-        // if (verbose) {
-        //     std::cout << "Interpreter | inputTensorPtr[" << i << "] = " << this->inputTensorPtr[i] << std::endl <<
-        //     std::flush;
-        // }
-    }
-
-    // Alternative with memcpy
-    // memcpy(this->inputTensorPtr, inputVector, inputSize*sizeof(float));
+    if (inputSize != inputs[0].size)
+        throw std::logic_error("Error, input vector has to have size: " + std::to_string(inputs[0].size) + " (Found " + std::to_string(inputSize) + " instead)");
+    inputs[0].write(inputVector);
 
     if (verbose)
         std::cout << "Interpreter\t|\tinvoke_internal\t| Done.\nInterpreter\t|\tinvoke_internal\t| Running inference..." << std::endl
                   << std::flush;
 
     // Run inference
-    TFLITE_MINIMAL_CHECK(interpreter->Invoke() == kTfLiteOk);
+    run();
 
     if (verbose)
         std::cout << "Interpreter\t|\tinvoke_internal\t| Done.\nInterpreter\t|\tinvoke_internal\t| Reading output tensor..." << std::endl
@@ -227,12 +399,8 @@ int InterpreterWrap::invoke_internal(const float inputVector[], size_t inputSize
         std::cout << "Interpreter\t|\tinvoke_internal\t| Done (size is OK).\nInterpreter\t|\tinvoke_internal\t| Copying to array..." << std::endl
                   << std::flush;
 
-        for (size_t i = 0; i < outputSize; ++i)
-            std::cout << "Interpreter\t|\tinvoke_internal\t| outputTensorPtr[" << i << "] :" << outputTensorPtr[i] << std::endl
-                      << std::flush;
     }
-    for (size_t i = 0; i < outputSize; ++i)
-        outputVector[i] = outputTensorPtr[i];
+    outputs[0].read(outputVector);
 
     if (verbose)
         std::cout << "Interpreter\t|\tinvoke_internal\t| Done." << std::endl
@@ -252,6 +420,184 @@ int InterpreterWrap::invoke_internal(const float inputVector[], size_t inputSize
     return res;
 }
 
+void InterpreterWrap::invokeBound() {
+    // Float tensors are bound directly, only the quantized ones need a conversion
+    for (auto &input : inputs)
+        if (input.isQuantized())
+            input.write(input.buffer);
+    run();
+    for (const auto &output : outputs)
+        if (output.isQuantized())
+            output.read(output.buffer);
+}
+
+int InterpreterWrap::readSingleOutput(float outputVector[], size_t outputSize) const {
+    if (outputs.size() != 1)
+        throw std::logic_error("Error, the model has " + std::to_string(outputs.size()) + " outputs, use the bound buffers");
+    if (outputSize != outputs[0].size)
+        throw std::logic_error("Error, output vector has to have size: " + std::to_string(outputs[0].size) + " (Found " + std::to_string(outputSize) + " instead)");
+    outputs[0].read(outputVector);
+    return argmax(outputVector, outputSize);
+}
+
+void InterpreterWrap::run() {
+    TFLITE_MINIMAL_CHECK(interpreter->Invoke() == kTfLiteOk);
+
+    if (profiler)
+        flushProfileEvents();
+}
+
+void InterpreterWrap::enableProfiling(OpEventSink sink) {
+    if (profiler)
+        disableProfiling();
+
+    // Initial room for 1024 events, grown if a model has more operators
+    profiler.reset(new tflite::profiling::BufferedProfiler(1024, true));
+    profilingSink = std::move(sink);
+    profiledInvocations = 0;
+    interpreter->SetProfiler(profiler.get());
+    profiler->StartProfiling();
+}
+
+void InterpreterWrap::disableProfiling() {
+    if (!profiler)
+        return;
+    profiler->StopProfiling();
+    flushProfileEvents();
+    interpreter->SetProfiler(nullptr);
+    profiler.reset();
+    profilingSink = nullptr;
+}
+
+void InterpreterWrap::flushProfileEvents() {
+    const auto events = profiler->GetProfileEvents();
+    if (events.empty())
+        return;
+
+    for (const tflite::profiling::ProfileEvent *event : events) {
+        // Delegate operator events are nested in the event of their delegate node, skip them to keep the events disjoint
+        if (event->event_type != tflite::Profiler::EventType::OPERATOR_INVOKE_EVENT)
+            continue;
+
+        OpEvent opEvent;
+        opEvent.op = event->tag;
+        opEvent.invocation = profiledInvocations;
+        opEvent.durationUs = (double)event->elapsed_time;
+
+        // event_metadata is the node index, extra_event_metadata the subgraph index
+        if (event->extra_event_metadata == 0 && event->event_metadata >= 0 && (size_t)event->event_metadata < interpreter->nodes_size()) {
+            const auto *nodeAndRegistration = interpreter->node_and_registration((int)event->event_metadata);
+            const TfLiteNode &node = nodeAndRegistration->first;
+            // TFLite nodes have no name, use the name of their first output tensor
+            if (node.outputs->size > 0 && interpreter->tensor(node.outputs->data[0])->name != nullptr)
+                opEvent.node = interpreter->tensor(node.outputs->data[0])->name;
+            for (int i = 0; i < node.inputs->size; ++i) {
+                if (node.inputs->data[i] < 0)  // Optional input not provided
+                    continue;
+                const TfLiteIntArray *dims = interpreter->tensor(node.inputs->data[i])->dims;
+                opEvent.inputShapes.emplace_back(dims->data, dims->data + dims->size);
+            }
+        }
+        if (profilingSink)
+            profilingSink(opEvent);
+    }
+    profiler->Reset();
+    ++profiledInvocations;
+}
+
+void InterpreterWrap::applyXnnpackDelegate(bool verbose) {
+#if TFLITEWRAPPER_XNNPACK
+    if (verbose)
+        std::cout << "Interpreter\t|\tconstructor\t| Applying the XNNPACK delegate (" << options.numThreads << " thread(s))..." << std::endl;
+
+    TfLiteXNNPackDelegateOptions xnnpackOptions = TfLiteXNNPackDelegateOptionsDefault();
+    xnnpackOptions.num_threads = options.numThreads;
+
+    std::unique_lock<std::mutex> cacheLock;
+    if (options.shareXnnpackWeights) {
+        weightsCache = getSharedWeightsCache(weightsCacheKey);
+        cacheLock = std::unique_lock<std::mutex>(weightsCache->mutex);
+        xnnpackOptions.weights_cache = weightsCache->get();
+    }
+
+    xnnpackDelegate.reset(TfLiteXNNPackDelegateCreate(&xnnpackOptions));
+    if (!xnnpackDelegate)
+        throw std::runtime_error("Failed to create the XNNPACK delegate");
+    if (interpreter->ModifyGraphWithDelegate(xnnpackDelegate.get()) != kTfLiteOk)
+        throw std::runtime_error("Failed to apply the XNNPACK delegate");
+
+    // The weights of this model are packed now. A soft finalization still lets the next interpreters look them up
+    if (weightsCache && !weightsCache->finalized) {
+        if (!TfLiteXNNPackDelegateWeightsCacheFinalizeSoft(weightsCache->get()))
+            throw std::runtime_error("Failed to finalize the XNNPACK weights cache");
+        weightsCache->finalized = true;
+    }
+
+    if (verbose) {
+        size_t delegateNodes = 0, totalNodes = 0;
+        getDelegatedNodeCount(delegateNodes, totalNodes);
+        std::cout << "Interpreter\t|\tconstructor\t| XNNPACK applied, " << delegateNodes << " of " << totalNodes << " nodes are delegated." << std::endl;
+    }
+#else
+    (void)verbose;
+    throw std::runtime_error("XNNPACK requested, but the wrapper was built without it (TFLITEWRAPPER_ENABLE_XNNPACK=OFF)");
+#endif
+}
+
+void InterpreterWrap::checkPriming() {
+    // Buffers of every tensor after the first invoke, another invoke must not move them (an arena that has to grow
+    // is reallocated, which moves the tensors it holds)
+    std::vector<const void *> buffers(interpreter->tensors_size());
+    std::vector<std::string> problems;
+    for (size_t i = 0; i < interpreter->tensors_size(); ++i) {
+        const TfLiteTensor *tensor = interpreter->tensor((int)i);
+        buffers[i] = tensor->data.raw;
+        // Dynamic tensors are (re)allocated during Invoke
+        if (tensor->allocation_type == kTfLiteDynamic)
+            problems.push_back("tensor " + std::to_string(i) + " (" + (tensor->name ? tensor->name : "") + ") is dynamic");
+    }
+
+    invokeBound();
+
+    for (size_t i = 0; i < interpreter->tensors_size(); ++i) {
+        const TfLiteTensor *tensor = interpreter->tensor((int)i);
+        if (tensor->data.raw != buffers[i])
+            problems.push_back("tensor " + std::to_string(i) + " (" + (tensor->name ? tensor->name : "") + ") was reallocated by the second invoke");
+    }
+    for (size_t i = 0; i < inputs.size(); ++i)
+        if (interpreter->input_tensor(i)->data.raw != inputs[i].data)
+            problems.push_back("the buffer of input " + std::to_string(i) + " moved");
+    for (size_t i = 0; i < outputs.size(); ++i)
+        if (interpreter->output_tensor(i)->data.raw != outputs[i].data)
+            problems.push_back("the buffer of output " + std::to_string(i) + " moved");
+
+    if (problems.empty())
+        return;
+
+    std::string message = "Interpreter\t|\tconstructor\t| Priming does not make invoke allocation-free:";
+    for (const auto &problem : problems)
+        message += "\n    " + problem;
+    if (options.primingCheck == PrimingCheck::Throw)
+        throw std::runtime_error(message);
+    std::cerr << "WARNING: " << message << std::endl;
+}
+
+void InterpreterWrap::getDelegatedNodeCount(size_t &delegateNodes, size_t &totalNodes) const {
+    delegateNodes = 0;
+    totalNodes = interpreter->execution_plan().size();
+    for (int nodeIndex : interpreter->execution_plan()) {
+        const auto *nodeAndRegistration = interpreter->node_and_registration(nodeIndex);
+        if (nodeAndRegistration->first.delegate != nullptr)
+            ++delegateNodes;
+    }
+}
+
+void InterpreterWrap::endStartupPhase(const char *name) {
+    const auto now = std::chrono::steady_clock::now();
+    startupPhases.push_back({name, std::chrono::duration<double, std::micro>(now - phaseStart).count()});
+    phaseStart = now;
+}
+
 /** STEP 1 */
 std::unique_ptr<tflite::FlatBufferModel> InterpreterWrap::loadModel(const std::string &filename) {
     // Load model
@@ -269,9 +615,11 @@ std::unique_ptr<tflite::FlatBufferModel> InterpreterWrap::loadModelFromBuffer(co
 }
 /** STEP 2 */
 std::unique_ptr<Interpreter> InterpreterWrap::buildInterpreter(const std::unique_ptr<tflite::FlatBufferModel> &model) {
-    // Build the interpreter
-    tflite::ops::builtin::BuiltinOpResolver resolver;
+    // Build the interpreter. Delegates are only applied as requested by the options, never by default
+    tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
     InterpreterBuilder builder(*model, resolver);
+    if (builder.SetNumThreads(options.numThreads) != kTfLiteOk)
+        throw std::runtime_error("Invalid number of threads: " + std::to_string(options.numThreads));
     std::unique_ptr<Interpreter> interpreter;
     builder(&interpreter);
     TFLITE_MINIMAL_CHECK(interpreter != nullptr);
@@ -280,7 +628,7 @@ std::unique_ptr<Interpreter> InterpreterWrap::buildInterpreter(const std::unique
 }
 
 int InterpreterWrap::argmax(const float vec[], size_t vecSize) const {
-    float max = std::numeric_limits<float>::min();
+    float max = std::numeric_limits<float>::lowest();  // Dequantized outputs can all be negative
     int argmax = -1;
     for (size_t i = 0; i < vecSize; ++i) {
         if (vec[i] > max) {
@@ -319,80 +667,124 @@ int InterpreterWrap::requestedOutputSize() const {
     return output_size;
 }
 
-/***** Handle functions *****/
-InterpreterPtr createInterpreter(const std::string &filename, bool verbose) {
-    InterpreterPtr res = new InterpreterWrap(filename, verbose);
-    return res;
-}
+/**
+ * Sliding window over the last numFrames frames of a stream, feeding one input of an interpreter.
+ * The frames are stored in a ring buffer, oldest at position `next`, so that a push only copies one frame.
+ * With the column layout the ring has the layout of the input (frameSize rows of numFrames values), each row
+ * being a ring of its own with the same `next`.
+ */
+class StreamingInputWrap {
+public:
+    StreamingInputWrap(InterpreterPtr inp, size_t frameSize, size_t inputIndex, FrameLayout layout)
+        : interpreter(inp), inputIndex(inputIndex), frameSize(frameSize), layout(layout) {
+        const TensorIo &input = inp->getInputs().at(inputIndex);
+        if (frameSize == 0 || input.size % frameSize != 0)
+            throw std::logic_error("Error, the input size (" + std::to_string(input.size) + ") has to be a multiple of the frame size (" + std::to_string(frameSize) + ")");
+        if (layout == FrameLayout::Columns && (input.shape.size() < 3 || input.shape[1] != (int64_t)frameSize))
+            throw std::logic_error("Error, column frames need an input of shape [batch, " + std::to_string(frameSize) + ", frames(, 1)]");
+        numFrames = input.size / frameSize;
+        ring.assign(input.size, 0.0f);
+    }
 
-InterpreterPtr createInterpreterFromBuffer(const char *buffer, size_t bufferSize, bool verbose) {
-    InterpreterPtr res = new InterpreterWrap(buffer, bufferSize, verbose);
-    return res;
+    void pushFrame(const float frame[], size_t stride) {
+        if (layout == FrameLayout::Columns) {
+            for (size_t i = 0; i < frameSize; ++i)
+                ring[i * numFrames + next] = frame[i * stride];
+        } else {
+            float *slot = &ring[next * frameSize];
+            if (stride == 1) {
+                std::memcpy(slot, frame, frameSize * sizeof(float));
+            } else {
+                for (size_t i = 0; i < frameSize; ++i)
+                    slot[i] = frame[i * stride];
+            }
+        }
+        next = (next + 1 == numFrames) ? 0 : next + 1;
+    }
+
+    void reset() {
+        std::fill(ring.begin(), ring.end(), 0.0f);
+        next = 0;
+    }
+
+    /** Write the window to the input buffer, oldest frame first: the tail of the ring, then its head */
+    void writeWindow() {
+        float *input = interpreter->getInputs()[inputIndex].buffer;
+        if (layout == FrameLayout::Columns) {
+            for (size_t i = 0; i < frameSize; ++i)
+                writeRing(input + i * numFrames, &ring[i * numFrames], numFrames, next);
+        } else {
+            writeRing(input, ring.data(), numFrames * frameSize, next * frameSize);
+        }
+    }
+
+    InterpreterPtr getInterpreter() const { return interpreter; }
+
+private:
+    /** Copy a ring of `size` values starting at `oldest`, oldest value first */
+    static void writeRing(float *dst, const float *src, size_t size, size_t oldest) {
+        const size_t tail = size - oldest;
+        std::memcpy(dst, src + oldest, tail * sizeof(float));
+        if (oldest != 0)
+            std::memcpy(dst + tail, src, oldest * sizeof(float));
+    }
+
+    InterpreterPtr interpreter;
+    size_t inputIndex;
+    size_t frameSize;
+    FrameLayout layout;
+    size_t numFrames;
+    std::vector<float> ring;
+    size_t next = 0;
+};
+
+const float *getOutputBuffer(InterpreterPtr inp, size_t index) {
+    return inp->getOutputs().at(index).buffer;
 }
 
-void deleteInterpreter(InterpreterPtr inp) {
-    if (inp)
-        delete inp;
+void invokeBound(InterpreterPtr inp) {
+    inp->invokeBound();
 }
 
-int invoke(InterpreterPtr inp, const float inputVector[], size_t inputSize, float outputVector[],
-           size_t outputSize, bool verbose) {
-    size_t requestedInSize = inp->requestedInputSize();
-    if (inputSize != requestedInSize)
-        throw std::logic_error("Error, input vector has to have size: " + std::to_string(requestedInSize) + " (Found " + std::to_string(inputSize) + " instead)");
+StreamingInputPtr createStreamingInput(InterpreterPtr inp, size_t frameSize, size_t inputIndex, FrameLayout layout) {
+    return new StreamingInputWrap(inp, frameSize, inputIndex, layout);
+}
 
-    return inp->invoke_internal(inputVector, inputSize, outputVector, outputSize, verbose);
+void deleteStreamingInput(StreamingInputPtr s) {
+    if (s)
+        delete s;
 }
 
-int invokeFlat2D(InterpreterPtr inp, const float flatFeatureMatrix[], size_t nRows, size_t nCols, float outputVector[], size_t outputSize, bool verbose) {
-    size_t reqRows, reqCols;
-    reqRows = inp->requested2drows();
-    reqCols = inp->requested2dcols();
-    if (nRows != reqRows || nCols != reqCols)
-        throw std::logic_error("Error, input vector has to have size: " + std::to_string(reqRows) + "x" + std::to_string(reqCols) + " (Found " + std::to_string(nRows) + "x" + std::to_string(nCols) + " instead)");
-    return inp->invoke_internal(flatFeatureMatrix, nRows * nCols, outputVector, outputSize, verbose);
+void pushFrame(StreamingInputPtr s, const float frame[], size_t stride) {
+    s->pushFrame(frame, stride);
 }
 
-int invoke(InterpreterPtr inp, std::vector<float> &inputVector, std::vector<float> &outputVector) {
-    if (inputVector.size() != getModelInputSize1d(inp)) {
-        std::cerr << "Interpreter\t|\tinvoke\t| Input vector size does not match model input size (" << inputVector.size() << " != " << getModelInputSize1d(inp) << ")" << std::endl;
-        throw std::runtime_error(("Input vector size does not match model input size (" + std::to_string(inputVector.size()) + " != " + std::to_string(getModelInputSize1d(inp)) + ")").c_str());
-    }
-    if (outputVector.size() != getModelOutputSize(inp)) {
-        std::cerr << "Interpreter\t|\tinvoke\t| Output vector size does not match model output size (" << outputVector.size() << " != " << getModelOutputSize(inp) << ")" << std::endl;
-        throw std::runtime_error(("Output vector size does not match model output size (" + std::to_string(outputVector.size()) + " != " + std::to_string(getModelOutputSize(inp)) + ")").c_str());
-    }
-    return invoke(inp, inputVector.data(), (size_t)inputVector.size(), outputVector.data(), (size_t)outputVector.size());
+void resetStreamingInput(StreamingInputPtr s) {
+    s->reset();
 }
 
-int invokeFlat2D(InterpreterPtr inp, std::vector<float> &flatInputMatrix, size_t nRows, size_t nCols, std::vector<float> &outputVector, bool verbose) {
-    if (flatInputMatrix.size() != nRows * nCols) {
-        std::cerr << "Interpreter\t|\tinvokeFlat2D\t| Input vector size does not match the nRows and nCols values provided (" << flatInputMatrix.size() << " != " << nRows << "*" << nCols << ")" << std::endl;
-        throw std::runtime_error(("Input vector size does not match the nRows and nCols values provided (" + std::to_string(flatInputMatrix.size()) + " != " + std::to_string(nRows) + "*" + std::to_string(nCols) + ")").c_str());
-    }
-    if ((int)nRows != inp->requested2drows())
-        throw std::runtime_error(("Input vector size does not match model input size (" + std::to_string(nRows) + " != " + std::to_string(inp->requested2drows()) + ")").c_str());
-    if ((int)nCols != inp->requested2dcols())
-        throw std::runtime_error(("Input vector size does not match model input size (" + std::to_string(nCols) + " != " + std::to_string(inp->requested2dcols()) + ")").c_str());
-    if (outputVector.size() != getModelOutputSize(inp)) {
-        std::cerr << "Interpreter\t|\tinvokeFlat2D\t| Output vector size does not match model output size (" << outputVector.size() << " != " << getModelOutputSize(inp) << ")" << std::endl;
-        throw std::runtime_error(("Output vector size does not match model output size (" + std::to_string(outputVector.size()) + " != " + std::to_string(getModelOutputSize(inp)) + ")").c_str());
-    }
+void invokeStreaming(StreamingInputPtr s) {
+    s->writeWindow();
+    s->getInterpreter()->invokeBound();
+}
 
-    return invokeFlat2D(inp, flatInputMatrix.data(), nRows, nCols, outputVector.data(), outputVector.size(), verbose);
+int invokeStreaming(StreamingInputPtr s, float outputVector[], size_t outputSize, bool verbose) {
+    if (verbose)
+        std::cout << "Interpreter\t|\tinvokeStreaming\t| Writing the window and running inference..." << std::endl;
+    invokeStreaming(s);
+    return s->getInterpreter()->readSingleOutput(outputVector, outputSize);
 }
 
-size_t getModelInputSize1d(InterpreterPtr inp) {
-    return (size_t)(inp->requestedInputSize());
+void enableProfiling(InterpreterPtr inp, OpEventSink sink) {
+    inp->enableProfiling(std::move(sink));
 }
 
-void getModelInputSize2d(InterpreterPtr inp, size_t &rows, size_t &columns) {
-    rows = (size_t)(inp->requested2drows());
-    columns = (size_t)(inp->requested2dcols());
+void disableProfiling(InterpreterPtr inp) {
+    inp->disableProfiling();
 }
 
-size_t getModelOutputSize(InterpreterPtr inp) {
-    return (size_t)(inp->requestedOutputSize());
+std::vector<StartupPhase> getStartupPhases(InterpreterPtr inp) {
+    return inp->getStartupPhases();
 }
 
 }  // namespace InferenceEngine
\ No newline at end of file
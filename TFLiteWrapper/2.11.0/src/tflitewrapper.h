@@ -11,7 +11,9 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
+#include <functional>
 #include <iostream>
 #include <limits>  // std::numeric_limits
 #include <string>
@@ -48,8 +50,91 @@ void getModelInputSize2d(InterpreterPtr inp, size_t& rows, size_t& columns);
  */
 size_t getModelOutputSize(InterpreterPtr inp);
 
+/** Name and shape of an input or output tensor of the model */
+struct TensorInfo {
+    std::string name;            // Name of the tensor in the model
+    std::vector<int64_t> shape;  // Dimensions, including the batch dimension
+    size_t size = 0;             // Number of elements
+};
+
+/** Number of input tensors of the model */
+size_t getInputCount(InterpreterPtr inp);
+
+/** Number of output tensors of the model */
+size_t getOutputCount(InterpreterPtr inp);
+
+/** Name and shape of an input (index < getInputCount) */
+TensorInfo getInputInfo(InterpreterPtr inp, size_t index);
+
+/** Name and shape of an output (index < getOutputCount) */
+TensorInfo getOutputInfo(InterpreterPtr inp, size_t index);
+
+/** Index of the input with the given name, throws std::out_of_range if there is none (do not use in real time threads) */
+size_t getInputIndex(InterpreterPtr inp, const std::string& name);
+
+/** Index of the output with the given name, throws std::out_of_range if there is none (do not use in real time threads) */
+size_t getOutputIndex(InterpreterPtr inp, const std::string& name);
+
+/**
+ * @brief Bound buffers, for models with several inputs and/or outputs
+ * Every input and output has a preallocated float buffer of getInputInfo(inp, i).size / getOutputInfo(inp, i).size
+ * elements, valid until deleteInterpreter. The buffers are looked up once, then every frame the inputs are written
+ * in place, invokeBound runs the model and the outputs are read in place:
+ *
+ *     float* spectrogram = getInputBuffer(inp, getInputIndex(inp, "spectrogram"));
+ *     float* descriptors = getInputBuffer(inp, getInputIndex(inp, "descriptors"));
+ *     const float* classes = getOutputBuffer(inp, getOutputIndex(inp, "classes"));
+ *     ...
+ *     // Real-time thread
+ *     computeSpectrogram(spectrogram);
+ *     computeDescriptors(descriptors);
+ *     invokeBound(inp);
+ *
+ * The sizes are checked when the interpreter is created, invokeBound does no check. The buffers of float tensors are
+ * the tensors themselves, those of quantized int8/uint8 tensors are converted by invokeBound.
+ */
+float* getInputBuffer(InterpreterPtr inp, size_t index);
+const float* getOutputBuffer(InterpreterPtr inp, size_t index);
+
+/** Run the model on the values of the bound input buffers, the results are in the bound output buffers */
+void invokeBound(InterpreterPtr inp);
+
+/** What to do when priming leaves work for the real-time thread (see InterpreterOptions::primingCheck) */
+enum class PrimingCheck {
+    Off,   // Do not check
+    Warn,  // Print a warning to stderr
+    Throw  // Throw std::runtime_error from createInterpreter
+};
+
+/**
+ * @brief Options of the interpreter, applied before the tensors are allocated
+ * The defaults reproduce the behaviour of createInterpreter without options.
+ */
+struct InterpreterOptions {
+    int numThreads = 1;                     // Threads used by the CPU kernels (and by XNNPACK)
+    bool allowFp16PrecisionForFp32 = true;  // Let kernels/delegates compute fp32 operations in fp16
+    bool useXnnpack = false;                // Run the supported operators with the XNNPACK delegate
+
+    /**
+     * Share the packed weights of XNNPACK between the interpreters created from the same model file (or buffer) in
+     * this process, so that only the first interpreter packs them. TFLite 2.11 only supports an in-memory cache,
+     * the weights are packed again by the first interpreter of every process.
+     */
+    bool shareXnnpackWeights = true;
+
+    /**
+     * After priming, run the interpreter once more and check that it did not need to allocate: no dynamic tensors,
+     * and every tensor (inputs and outputs included) keeps the buffer it had after the first invoke. A growing arena
+     * is only seen through the tensors it moves, its size is not compared. The check costs this extra invoke in
+     * createInterpreter, set Off to skip it.
+     */
+    PrimingCheck primingCheck = PrimingCheck::Warn;
+};
+
 /**
  * @brief Dynamically allocate an instance of a Interpreter object (do not use in real time threads!)
+ * The input and output tensors can be float32 or per-tensor quantized int8/uint8 (full-integer models). For
+ * quantized tensors invoke keeps its float interface, it quantizes the input and dequantizes the output.
  *
  * @param filename path to the tflite model file
  * @param verbose  verbose mode (to disable in real time threads)
@@ -57,6 +142,17 @@ size_t getModelOutputSize(InterpreterPtr inp);
  */
 InterpreterPtr createInterpreter(const std::string& filename, bool verbose = false);
 
+/**
+ * @brief Dynamically allocate an instance of a Interpreter object with options (do not use in real time threads!)
+ * Throws std::runtime_error if an option cannot be applied (e.g. XNNPACK requested but the wrapper was built without it).
+ *
+ * @param filename path to the tflite model file
+ * @param options  thread count, precision and delegate options
+ * @param verbose  verbose mode (to disable in real time threads)
+ * @return InterpreterPtr
+ */
+InterpreterPtr createInterpreter(const std::string& filename, const InterpreterOptions& options, bool verbose = false);
+
 /**
  * @brief Dynamically allocate an instance of a Interpreter object from Buffer(do not use in real time threads!)
  *
@@ -66,6 +162,26 @@ InterpreterPtr createInterpreter(const std::string& filename, bool verbose = fal
  */
 InterpreterPtr createInterpreterFromBuffer(const char* buffer, size_t bufferSize, bool verbose = false);
 
+/**
+ * @brief Dynamically allocate an instance of a Interpreter object from Buffer, with options (do not use in real time threads!)
+ *
+ * @param buffer  Caller-owned buffer containing the model
+ * @param options thread count, precision and delegate options
+ * @param verbose verbose mode (to disable in real time threads)
+ * @return InterpreterPtr
+ */
+InterpreterPtr createInterpreterFromBuffer(const char* buffer, size_t bufferSize, const InterpreterOptions& options, bool verbose = false);
+
+/** Whether the wrapper was built with the XNNPACK delegate (TFLITEWRAPPER_ENABLE_XNNPACK) */
+bool isXnnpackAvailable();
+
+/**
+ * @brief Number of nodes of the execution plan run by a delegate, and total number of nodes
+ * A delegate replaces the operators it supports with one node per partition, so a fully delegated model has
+ * one delegate node.
+ */
+void getDelegatedNodeCount(InterpreterPtr inp, size_t& delegateNodes, size_t& totalNodes);
+
 /**
  * @brief Free the Interpreter memory (do not use in real time threads)
  *
@@ -159,5 +275,105 @@ int invokeFlat2D(InterpreterPtr inp, std::array<float, N_ROWS * N_COLS>& flatInp
  */
 int invokeFlat2D(InterpreterPtr inp, std::vector<float>& flatInputMatrix, size_t nRows, size_t nCols, std::vector<float>& outputVector, bool verbose = false);
 
-}  // namespace InferenceEngine
+class StreamingInputWrap;                       // Forward definition of the StreamingInputWrap class
+using StreamingInputPtr = StreamingInputWrap*;  // Opaque pointer for streaming input object
+
+/** Where the frames of a streaming input lie in its input tensor */
+enum class FrameLayout {
+    Rows,    // A frame is a row of the input (time along the outer axis, e.g. [1, frames, frameSize])
+    Columns  // A frame is a column of the input (time along the inner axis, e.g. [1, frameSize, frames] or [1, frameSize, frames, 1])
+};
 
+/**
+ * @brief Create a sliding-window input, for models invoked on the last frames of a stream (do not use in real time threads!)
+ * A spectrogram model, for example, gains one frame per hop: instead of rebuilding the whole matrix for invokeFlat2D,
+ * every hop only the new frame is pushed (O(frame)), and invokeStreaming writes the window to the input tensor, oldest
+ * frame first.
+ * With FrameLayout::Rows a frame is the innermost part of the input (a row of a 2D input, a hop of samples of a 1D
+ * input), and the window is written with one contiguous copy (two when the ring buffer has wrapped).
+ * With FrameLayout::Columns the input has to be [batch, frameSize, frames(, 1)]: a frame is scattered into one column,
+ * and the window is written with one or two copies per row.
+ * In both layouts the input size has to be a multiple of frameSize. The window starts as zeros.
+ *
+ * @param inp        Interpreter object, has to outlive the streaming input
+ * @param frameSize  Number of values in a frame
+ * @param inputIndex Input fed by the window (see getInputIndex)
+ * @param layout     Whether the frames are the rows or the columns of the input
+ * @return StreamingInputPtr
+ */
+StreamingInputPtr createStreamingInput(InterpreterPtr inp, size_t frameSize, size_t inputIndex = 0, FrameLayout layout = FrameLayout::Rows);
+
+/** Free the streaming input memory (do not use in real time threads) */
+void deleteStreamingInput(StreamingInputPtr s);
+
+/**
+ * @brief Append a frame to the window, dropping the oldest one
+ * The stride only describes the caller's buffer, where the frame lands in the input is set by the FrameLayout.
+ *
+ * @param s      Streaming input
+ * @param frame  frameSize values, the i-th at frame[i * stride] (e.g. stride = number of columns to push a column of a row-major matrix)
+ * @param stride Distance between two values of the frame
+ */
+void pushFrame(StreamingInputPtr s, const float frame[], size_t stride = 1);
+
+/** Zero the window, e.g. when the stream restarts */
+void resetStreamingInput(StreamingInputPtr s);
+
+/** Write the window to its input and run the model, the results are in the bound output buffers (see invokeBound) */
+void invokeStreaming(StreamingInputPtr s);
+
+/** Write the window to its input and run a single-output model, return the index of the maximum output like invoke */
+int invokeStreaming(StreamingInputPtr s, float outputVector[], size_t outputSize, bool verbose = false);
+
+/**
+ * @brief One operator execution, as reported by the native profiler of the runtime
+ * The same structure is used by all the wrappers, so that per-operator profiles can be compared.
+ */
+struct OpEvent {
+    std::string op;                                 // Operator type (e.g. "CONV_2D")
+    std::string node;                               // Name of the node in the graph (empty if not reported by the runtime)
+    int invocation = 0;                             // Index of the invoke call since enableProfiling
+    double durationUs = 0.0;                        // Execution time in microseconds
+    std::vector<std::vector<int64_t>> inputShapes;  // Shape of every input tensor of the operator
+};
+
+/** Callback that receives the operator events */
+using OpEventSink = std::function<void(const OpEvent&)>;
+
+/**
+ * @brief Attach the TFLite profiler to the interpreter (do not use in real time threads)
+ * After every invoke, the operator events of that invocation are passed to the sink, in execution order.
+ * Operators run by a delegate are reported as a single delegate operator.
+ * Profiling allocates memory in the invoke functions, so it must only be used for measurements.
+ *
+ * @param inp  Interpreter object
+ * @param sink Callback for the operator events
+ */
+void enableProfiling(InterpreterPtr inp, OpEventSink sink);
+
+/**
+ * @brief Detach the profiler from the interpreter (do not use in real time threads)
+ * All the pending events are passed to the sink before returning.
+ *
+ * @param inp Interpreter object
+ */
+void disableProfiling(InterpreterPtr inp);
+
+/** Duration of one phase of the creation of an interpreter */
+struct StartupPhase {
+    std::string name;         // "load", "build", "allocate" or "prime"
+    double durationUs = 0.0;  // Wall time in microseconds
+};
+
+/**
+ * @brief Get the time spent in each phase of createInterpreter/createInterpreterFromBuffer
+ * load: FlatBufferModel creation (mmap/verification of the .tflite file), build: InterpreterBuilder (op resolution
+ * and node preparation) and the XNNPACK delegate (weights packing), allocate: AllocateTensors and tensor lookup,
+ * prime: the first Invoke and the priming check.
+ *
+ * @param inp Interpreter object
+ * @return The phases, in execution order
+ */
+std::vector<StartupPhase> getStartupPhases(InterpreterPtr inp);
+
+}  // namespace InferenceEngine
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <limits>  // std::numeric_limits
 #include <utility>
@@ -31,7 +32,6 @@ public:
     Classifier(const std::string& filename, bool verbose = false);
     /** Internal classification function, called by wrappers */
     int classify_internal(const float featureVector[], size_t numFeatures, float outputVector[], size_t numClasses, bool verbose = false);
-    int classify_internal2d(float** featureMatrix, size_t rows, size_t cols, float outputVector[], size_t numClasses, bool verbose = false);
 
     // int requestedInputSize(const std::unique_ptr<Interpreter> &interpreter) const;
     // int requestedOutputSize(const std::unique_ptr<Interpreter> &interpreter) const;
@@ -173,16 +173,8 @@ int Classifier::classify_internal(const float featureVector[], size_t numFeature
         std::cout << "classify | Filling input tensor..." << std::endl
                   << std::flush;
     }
-    // Fill `input`.
-    for (size_t i = 0; i < numFeatures; ++i) {
-        this->inputTensorPtr[i] = featureVector[i];
-        // if (verbose) {
-        //     std::cout << "classify | inputTensorPtr[" << i << "] = " << this->inputTensorPtr[i] << std::endl << std::flush;
-        // }
-    }
-
-    // Alternative with memcpy
-    // memcpy(this->inputTensorPtr, featureVector, numFeatures*sizeof(float));
+    // Fill `input` (2D inputs are flat row-major matrices, see classifyFlat2D)
+    std::memcpy(this->inputTensorPtr, featureVector, numFeatures * sizeof(float));
 
     if (verbose)
         std::cout << "classify | Done.\nclassify | Running inference..." << std::endl
@@ -207,8 +199,7 @@ int Classifier::classify_internal(const float featureVector[], size_t numFeature
             std::cout << "classify | outputTensorPtr[" << i << "] :" << outputTensorPtr[i] << std::endl
                       << std::flush;
     }
-    for (size_t i = 0; i < numClasses; ++i)
-        outputVector[i] = outputTensorPtr[i];
+    std::memcpy(outputVector, outputTensorPtr, numClasses * sizeof(float));
 
     if (verbose)
         std::cout << "classify | Done." << std::endl
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <limits>  // std::numeric_limits
 #include <utility>
@@ -86,8 +87,7 @@ int Classifier::classify_internal(const float featureVector[], size_t numFeature
         throw std::logic_error("Error, input vector has to have size: " + std::to_string(requestedInSize) + " (Found " + std::to_string(numFeatures) + " instead)");
 
     // Fill `input`.
-    for (int i = 0; i < numFeatures; ++i)
-        this->inputTensorPtr[i] = featureVector[i];
+    std::memcpy(this->inputTensorPtr, featureVector, numFeatures * sizeof(float));
 
     // Run inference
     TFLITE_MINIMAL_CHECK(interpreter->Invoke() == kTfLiteOk);
@@ -96,8 +96,7 @@ int Classifier::classify_internal(const float featureVector[], size_t numFeature
     if (numClasses != requestedOutSize)
         throw std::logic_error("Error, output vector has to have size: " + std::to_string(requestedOutSize) + " (Found " + std::to_string(numClasses) + " instead)");
 
-    for (int i = 0; i < numClasses; ++i)
-        outputVector[i] = outputTensorPtr[i];
+    std::memcpy(outputVector, outputTensorPtr, numClasses * sizeof(float));
 
     if (verbose)
         std::cout << "classify | Done." << std::endl
@@ -0,0 +1,126 @@
+/*
+ * Implementation of torchscriptwrapper.h on the PyTorch lite interpreter (torch::jit::mobile::Module)
+ * Built instead of torchscriptwrapper.cpp with -DTORCHSCRIPTWRAPPER_LITE=ON, for .ptl models exported with
+ * torch.utils.mobile_optimizer.optimize_for_mobile(...)._save_for_lite_interpreter(path).
+==============================================================================*/
+#include "torchscriptwrapper.h"
+#include "torchwrapper_common.h"
+
+#include <algorithm>
+#include <iostream>
+#include <istream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "torch/csrc/jit/mobile/import.h"
+#include "torch/csrc/jit/mobile/module.h"
+
+using torchwrapper::MemoryStreamBuf;
+using torchwrapper::sizesExtraFileName;
+
+// Definition of the classifier class
+class Classifier : public torchwrapper::ClassifierBase<Classifier> {
+public:
+    /** Constructor */
+    Classifier(const std::string &filename, const ClassifierOptions &options, bool verbose = false);              // Construct from file path
+    Classifier(const char *buffer, size_t bufferSize, const ClassifierOptions &options, bool verbose = false);  // Construct from buffer
+    void allocateAndPrime(bool verbose = false);                             // Common part to the two constructors
+
+    /** The lite interpreter has no operator profiler */
+    void enableProfiling(OpEventSink sink);
+    void disableProfiling() {}
+
+private:
+    friend class torchwrapper::ClassifierBase<Classifier>;
+
+    /** Step 1, read the input/output sizes from the parameters, or from the extra file of the model */
+    void readModelSizes(torch::jit::ExtraFilesMap &extraFiles);
+
+    /** Run the module on the input tensor (see ClassifierBase::forward) */
+    at::Tensor runModel() { return this->model->forward(this->input_).toTensor(); }
+
+    //--------------------------------------------------------------------------
+
+    ClassifierOptions options;
+
+    std::unique_ptr<torch::jit::mobile::Module> model;
+};
+
+/** The lite interpreter runs the model as exported: the options that build or execute it differently are refused */
+static void checkLiteOptions(const ClassifierOptions &options) {
+    if (options.useStaticRuntime)
+        throw std::invalid_argument("The Static Runtime is not available with the lite interpreter");
+    if (!options.optimizedModelCacheDir.empty())
+        throw std::invalid_argument("The lite interpreter has no model cache, optimize the model when exporting it");
+}
+
+Classifier::Classifier(const std::string &filename, const ClassifierOptions &options, bool verbose)
+    : options(options) {
+    checkLiteOptions(options);
+    torch::jit::ExtraFilesMap extraFiles{{sizesExtraFileName, ""}};
+    try {
+        this->model.reset(new torch::jit::mobile::Module(torch::jit::_load_for_mobile(filename, c10::nullopt, extraFiles)));
+    } catch (const c10::Error &e) {
+        std::cerr << ("Error loading the model.\n");
+        throw std::logic_error("Error loading the model.");
+    }
+    readModelSizes(extraFiles);
+    endStartupPhase("load");
+    allocateAndPrime(verbose);
+}
+
+Classifier::Classifier(const char *buffer, size_t bufferSize, const ClassifierOptions &options, bool verbose)
+    : options(options) {
+    checkLiteOptions(options);
+    MemoryStreamBuf streamBuf(buffer, bufferSize);
+    std::istream stream(&streamBuf);
+    torch::jit::ExtraFilesMap extraFiles{{sizesExtraFileName, ""}};
+    try {
+        this->model.reset(new torch::jit::mobile::Module(torch::jit::_load_for_mobile(stream, c10::nullopt, extraFiles)));
+    } catch (const c10::Error &e) {
+        std::cerr << ("Error loading the model from buffer.\n");
+        throw std::logic_error("Error loading the model from buffer.");
+    }
+    readModelSizes(extraFiles);
+    endStartupPhase("load");
+    allocateAndPrime(verbose);
+}
+
+void Classifier::readModelSizes(torch::jit::ExtraFilesMap &extraFiles) {
+    // As the full interpreter: input size from the first parameter, output size from the last one
+    const std::vector<at::Tensor> parameters = this->model->parameters();
+    if (!parameters.empty() && parameters.front().dim() == 2) {
+        storedRequestedInputSize = parameters.front().size(1);
+        storedRequestedOutputSize = parameters.back().size(0);
+        return;
+    }
+    std::istringstream sizes(extraFiles[sizesExtraFileName]);
+    if (!(sizes >> storedRequestedInputSize >> storedRequestedOutputSize))
+        throw std::logic_error("The model has no parameters to read the input/output sizes from, export it with "
+                               "_extra_files={\"" + std::string(sizesExtraFileName) + "\": \"<input size> <output size>\"}");
+}
+
+void Classifier::allocateAndPrime(bool verbose) {
+    if (verbose) {
+        std::cout << "TORCHLITEWRAPPER: InputSize: " << storedRequestedInputSize << std::endl
+                  << std::flush;
+        std::cout << "TORCHLITEWRAPPER: OutputSize: " << storedRequestedOutputSize << std::endl
+                  << std::flush;
+    }
+
+    allocateInput();
+
+    // Prime the classifier (the input buffer is zero). The lite interpreter has no profiling executor, the
+    // graph it runs is the exported one: one run allocates what the next ones need.
+    prime((size_t)std::max(options.primingRuns, 1));
+}
+
+void Classifier::enableProfiling(OpEventSink) {
+    throw std::logic_error("Operator profiling is not available with the lite interpreter");
+}
+
+/***** Handle functions *****/
+#include "torchwrapper_handles.h"
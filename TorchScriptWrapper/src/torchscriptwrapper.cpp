@@ -1,63 +1,189 @@
 /*
 ==============================================================================*/
 #include "torchscriptwrapper.h"
+#include "torchwrapper_common.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <istream>
 #include <limits>  // std::numeric_limits
+#include <memory>
+#include <sstream>
+#include <streambuf>
 #include <utility>
 #include <vector>
 
+#include <unistd.h>  // getpid
+
+#include "ATen/record_function.h"
+#include "torch/csrc/autograd/profiler_legacy.h"
+#include "torch/csrc/jit/codegen/fuser/interface.h"
+#include "torch/csrc/jit/passes/tensorexpr_fuser.h"
+#include "torch/csrc/jit/runtime/graph_executor.h"
+#include "torch/csrc/jit/runtime/profiling_graph_executor_impl.h"
+#include "torch/csrc/jit/runtime/static/impl.h"
 #include "torch/script.h"
+#include "torch/version.h"
+
+/** Name of the profiler scope that wraps each profiled forward call */
+static const char *profilingScopeName = "classify";
+
+using torchwrapper::MemoryStreamBuf;
+using torchwrapper::sizesExtraFileName;
+
+/** 64-bit FNV-1a hash, as 16 hex digits */
+static std::string hashBytes(const char *data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    std::ostringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return stream.str();
+}
+
+/** Name of the built module in the cache: the source model and everything that changes how it is built */
+static std::string getOptimizedModelName(const char *modelData, size_t modelSize, const ClassifierOptions &options) {
+#if defined(__aarch64__)
+    const char *architecture = "aarch64";
+#elif defined(__arm__)
+    const char *architecture = "arm";
+#elif defined(__x86_64__)
+    const char *architecture = "x86-64";
+#else
+    const char *architecture = "unknown";
+#endif
+    const std::string settings = std::string("torch=") + TORCH_VERSION + ";freeze=" + std::to_string(options.freeze) +
+                                 ";optimize=" + std::to_string(options.freeze && options.optimizeForInference) + ";arch=" + architecture;
+    return hashBytes(modelData, modelSize) + "-" + hashBytes(settings.data(), settings.size()) + ".pt";
+}
+
+static std::vector<char> readFile(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file)
+        throw std::logic_error("Error loading the model.");
+    std::vector<char> bytes((size_t)file.tellg());
+    file.seekg(0);
+    if (!file.read(bytes.data(), bytes.size()))
+        throw std::logic_error("Error loading the model.");
+    return bytes;
+}
+
+/** Set the process-wide executor and fuser settings of LibTorch requested by the options */
+static void applyExecutorSettings(const ClassifierOptions &options) {
+    if (options.fuser == Fuser::TensorExpr && !options.profilingExecutor)
+        throw std::invalid_argument("The TensorExpr fuser needs the profiling executor");
+
+    torch::jit::getProfilingMode() = options.profilingExecutor;
+    switch (options.fuser) {
+    case Fuser::Default:
+        break;
+    case Fuser::TensorExpr:
+        torch::jit::setTensorExprFuserEnabled(true);
+        torch::jit::overrideCanFuseOnCPU(true);  // NNC only fuses CPU graphs when CPU fusion is allowed
+        break;
+    case Fuser::None:
+        torch::jit::setTensorExprFuserEnabled(false);
+        torch::jit::overrideCanFuseOnCPU(false);
+        break;
+    }
+}
 
 // Definition of the classifier class
-class Classifier {
+class Classifier : public torchwrapper::ClassifierBase<Classifier> {
 public:
     /** Constructor */
-    Classifier(const std::string &filename, bool verbose = false);
-    /** Internal classification function, called by wrappers */
-    int classify_internal(const float featureVector[], size_t numFeatures, float outputVector[], size_t numClasses);
+    Classifier(const std::string &filename, const ClassifierOptions &options, bool verbose = false);              // Construct from file path
+    Classifier(const char *buffer, size_t bufferSize, const ClassifierOptions &options, bool verbose = false);  // Construct from buffer
+    void buildAndPrime(bool verbose = false);                                // Common part to the two constructors
+
+    /** Start/stop the autograd profiler and report the operator events */
+    void enableProfiling(OpEventSink sink);
+    void disableProfiling();
 
 private:
+    friend class torchwrapper::ClassifierBase<Classifier>;
+
     /** Step 1, TORCHSCRIPT loading the .pt model */
-    torch::jit::Module *loadModel(const std::string &filename);
+    torch::jit::Module *loadModel(const std::string &filename, bool verbose);
+    torch::jit::Module *loadModelFromBuffer(const char *buffer, size_t bufferSize, bool verbose);
+    /** Step 1 with ClassifierOptions::optimizedModelCacheDir, nullptr if the model is not in the cache */
+    torch::jit::Module *loadCachedModel(bool verbose);
     /** Step 2, TORCHSCRIPT run optimizations on given model */
     void prepareOptimize(torch::jit::Module *model);
+    /** Step 2, save the built module in the cache */
+    void saveCachedModel(bool verbose);
+    /** Step 2b, wrap the optimized module in the Static Runtime */
+    void createStaticModule(bool verbose);
 
-    /** ind the index of the maximum value in an array */
-    int argmax(const float vec[], size_t vecSize) const;
+    /** Run the module on the input tensor (see ClassifierBase::forward) */
+    at::Tensor runModel();
 
     /** Check the input size requested by a torchscript model */
-    size_t requestedInputSize(const torch::jit::Module *model) const;
+    size_t modelInputSize(const torch::jit::Module *model) const;
     /** Check the output size requested by the model */
-    size_t requestedOutputSize(const torch::jit::Module *model) const;
-
-    size_t storedRequestedInputSize = 0, storedRequestedOutputSize = 0;
+    size_t modelOutputSize(const torch::jit::Module *model) const;
 
     //--------------------------------------------------------------------------
 
+    ClassifierOptions options;
+    std::string cachedFilename;    // Built module in the cache, empty without ClassifierOptions::optimizedModelCacheDir
+    bool loadedFromCache = false;  // The model is already built, with the sizes read from the cache
+
     torch::jit::Module *model;
+    std::unique_ptr<torch::jit::StaticModule> staticModule;  // Only with ClassifierOptions::useStaticRuntime
 
-    std::vector<torch::jit::IValue> input_;
-    float *input_data_;
-    at::Tensor output_;
+    OpEventSink profilingSink;
+    bool profiling = false;
 };
 
-Classifier::Classifier(const std::string &filename, bool verbose) {
+Classifier::Classifier(const std::string &filename, const ClassifierOptions &options, bool verbose)
+    : options(options) {
     // Load model
-    this->model = loadModel(filename);
+    this->model = loadModel(filename, verbose);
+    endStartupPhase("load");
+    buildAndPrime(verbose);
+}
 
+Classifier::Classifier(const char *buffer, size_t bufferSize, const ClassifierOptions &options, bool verbose)
+    : options(options) {
+    // Load model
+    this->model = loadModelFromBuffer(buffer, bufferSize, verbose);
+    endStartupPhase("load");
+    buildAndPrime(verbose);
+}
+
+void Classifier::buildAndPrime(bool verbose) {
     if (verbose)
         std::cout << "ONNXWRAPPER: Preparing and optimizing model" << std::endl
                   << std::flush;
 
-    // Prepare model for inference and run optimizations
-    prepareOptimize(this->model);
+    applyExecutorSettings(options);
+
+    // The sizes are read from the parameters, which freezing turns into constants of the graph
+    if (!loadedFromCache) {
+        storedRequestedInputSize = modelInputSize(this->model);
+        storedRequestedOutputSize = modelOutputSize(this->model);
+    }
 
-    storedRequestedInputSize = requestedInputSize(this->model);
-    storedRequestedOutputSize = requestedOutputSize(this->model);
+    // Prepare model for inference and run optimizations
+    if (!loadedFromCache) {
+        prepareOptimize(this->model);
+        if (!cachedFilename.empty())
+            saveCachedModel(verbose);
+    }
+    if (options.useStaticRuntime)
+        createStaticModule(verbose);
+    endStartupPhase("build");
 
     if (verbose) {
         std::cout << "ONNXWRAPPER: InputSize: " << storedRequestedInputSize << std::endl
@@ -66,16 +192,17 @@ Classifier::Classifier(const std::string &filename, bool verbose) {
                   << std::flush;
     }
 
-    // Initialize input Tensor
-    this->input_.push_back(at::zeros({1, (long int)storedRequestedInputSize}));
-    this->input_data_ = this->input_[0].toTensor().data_ptr<float>();
-    // Initialize output Tensor
-    this->output_ = at::zeros({(long int)storedRequestedOutputSize});
+    allocateInput();
 
-    // Prime the classifier
-    std::vector<float> pIv(storedRequestedInputSize);
-    std::vector<float> pOv(storedRequestedOutputSize);
-    this->classify_internal(&pIv[0], pIv.size(), &pOv[0], pOv.size());
+    // Prime the classifier (the input buffer is zero). The profiling executor needs the profiled runs, then one
+    // more to build and run the optimized graph; the Static Runtime and the legacy executor are ready after one.
+    size_t primingRuns = options.primingRuns > 0 ? (size_t)options.primingRuns : 1;
+    if (options.primingRuns <= 0 && options.profilingExecutor && !staticModule)
+        primingRuns = torch::jit::getNumProfiledRuns() + 1;
+    prime(primingRuns);
+    if (verbose)
+        std::cout << "ONNXWRAPPER: Primed with " << primingRuns << " runs" << std::endl
+                  << std::flush;
 
     /*
      * The priming operation should ensure that every allocation performed
@@ -83,32 +210,22 @@ Classifier::Classifier(const std::string &filename, bool verbose) {
      */
 }
 
-int Classifier::classify_internal(const float featureVector[], size_t numFeatures, float outputVector[], size_t numClasses) {
-    // Guard to enable inference mode in current scope
-    c10::InferenceMode guard;
-
-    if (numFeatures != storedRequestedInputSize)
-        throw std::logic_error("Error, input vector has to have size: " + std::to_string(storedRequestedInputSize) + " (Found " + std::to_string(numFeatures) + " instead)");
-
-    // Fill `input`.
-    for (size_t i = 0; i < numFeatures; ++i)
-        this->input_data_[i] = featureVector[i];
-
-    // Run inference
-    this->output_ = this->model->forward(this->input_).toTensor();
-
-    if (numClasses != storedRequestedOutputSize)
-        throw std::logic_error("Error, output vector has to have size: " + std::to_string(storedRequestedOutputSize) + " (Found " + std::to_string(numClasses) + " instead)");
-
-    // Copy output
-    for (size_t i = 0; i < numClasses; ++i)
-        outputVector[i] = this->output_[0][i].item<float>();
-
-    return argmax(outputVector, numClasses);
+at::Tensor Classifier::runModel() {
+    if (profiling) {
+        // Marks the operators of this call, see disableProfiling
+        RECORD_USER_SCOPE(profilingScopeName);
+        return staticModule ? staticModule->runtime()(this->input_, {}).toTensor() : this->model->forward(this->input_).toTensor();
+    }
+    return staticModule ? staticModule->runtime()(this->input_, {}).toTensor() : this->model->forward(this->input_).toTensor();
 }
 
 /** STEP 1 */
-torch::jit::Module *Classifier::loadModel(const std::string &filename) {
+torch::jit::Module *Classifier::loadModel(const std::string &filename, bool verbose) {
+    if (!options.optimizedModelCacheDir.empty()) {
+        // The cache is indexed by the content of the model
+        const std::vector<char> modelBytes = readFile(filename);
+        return loadModelFromBuffer(modelBytes.data(), modelBytes.size(), verbose);
+    }
     torch::jit::Module module;
     try {
         module = torch::jit::load(filename);
@@ -121,32 +238,162 @@ torch::jit::Module *Classifier::loadModel(const std::string &filename) {
     return model;
 }
 
+/** STEP 1 - Alternative */
+torch::jit::Module *Classifier::loadModelFromBuffer(const char *buffer, size_t bufferSize, bool verbose) {
+    if (!options.optimizedModelCacheDir.empty()) {
+        cachedFilename = options.optimizedModelCacheDir + "/" + getOptimizedModelName(buffer, bufferSize, options);
+        if (torch::jit::Module *cachedModel = loadCachedModel(verbose))
+            return cachedModel;
+    }
+    MemoryStreamBuf streamBuf(buffer, bufferSize);
+    std::istream stream(&streamBuf);
+    torch::jit::Module module;
+    try {
+        module = torch::jit::load(stream);
+    } catch (const c10::Error &e) {
+        std::cerr << ("Error loading the model from buffer.\n");
+        throw std::logic_error("Error loading the model from buffer.");
+    }
+    return new torch::jit::Module(module);
+}
+
+torch::jit::Module *Classifier::loadCachedModel(bool verbose) {
+    if (!std::ifstream(cachedFilename).good())
+        return nullptr;
+    torch::jit::ExtraFilesMap extraFiles{{sizesExtraFileName, ""}};
+    try {
+        torch::jit::Module module = torch::jit::load(cachedFilename, c10::nullopt, extraFiles);
+        std::istringstream sizes(extraFiles[sizesExtraFileName]);
+        if (!(sizes >> storedRequestedInputSize >> storedRequestedOutputSize))
+            throw std::runtime_error("no input/output sizes");
+        loadedFromCache = true;
+        if (verbose)
+            std::cout << "Built model loaded from the cache: " << cachedFilename << std::endl;
+        return new torch::jit::Module(module);
+    } catch (const std::exception &e) {  // c10::Error is a std::exception
+        std::cerr << "WARNING: Ignoring the cached model " << cachedFilename << " (" << e.what() << ")" << std::endl;
+        return nullptr;
+    }
+}
+
 /** STEP 2 */
 void Classifier::prepareOptimize(torch::jit::Module *model) {
     model->eval();
-    *model = torch::jit::optimize_for_inference(*model);
+    if (options.freeze && options.optimizeForInference)
+        *model = torch::jit::optimize_for_inference(*model);  // Freezes the module first
+    else if (options.freeze)
+        *model = torch::jit::freeze(*model);
 }
 
-int Classifier::argmax(const float vec[], size_t vecSize) const {
-    float max = std::numeric_limits<float>::min();
-    int argmax = -1;
-    for (size_t i = 0; i < vecSize; ++i) {
-        if (vec[i] > max) {
-            argmax = i;
-            max = vec[i];
+void Classifier::saveCachedModel(bool verbose) {
+    // Written under a temporary name and renamed once complete, other processes/threads may load the same model
+    static std::atomic<unsigned> temporaryCount{0};
+    const std::string temporaryFilename = cachedFilename + ".tmp" + std::to_string(getpid()) + "." + std::to_string(temporaryCount++);
+    const torch::jit::ExtraFilesMap extraFiles{{sizesExtraFileName, std::to_string(storedRequestedInputSize) + " " + std::to_string(storedRequestedOutputSize)}};
+    try {
+        this->model->save(temporaryFilename, extraFiles);
+    } catch (const c10::Error &e) {  // e.g. MKLDNN tensors, which have no serialization
+        std::remove(temporaryFilename.c_str());
+        std::cerr << "WARNING: The built model cannot be saved in the cache (" << e.what_without_backtrace() << ")" << std::endl;
+        return;
+    }
+    if (std::rename(temporaryFilename.c_str(), cachedFilename.c_str()) != 0) {
+        std::remove(temporaryFilename.c_str());
+        std::cerr << "WARNING: Could not save the built model in the cache: " << cachedFilename << std::endl;
+    } else if (verbose) {
+        std::cout << "Built model saved in the cache: " << cachedFilename << std::endl;
+    }
+}
+
+/** STEP 2b */
+void Classifier::createStaticModule(bool verbose) {
+    torch::jit::StaticModuleOptions staticOptions;
+    staticOptions.cleanup_activations = true;  // Intermediate tensors go back to the memory planner after each run
+    staticOptions.enable_out_variant = true;   // Operators write into the buffers planned during priming
+    staticOptions.optimize_memory = true;      // Tensors with disjoint lifetimes share the same buffer
+    try {
+        // Without ClassifierOptions::freeze the Static Runtime freezes its own copy of the module
+        staticModule.reset(new torch::jit::StaticModule(*this->model, options.freeze, staticOptions));
+    } catch (const c10::Error &e) {
+        throw std::runtime_error(std::string("The model cannot run in the Static Runtime: ") + e.what_without_backtrace());
+    }
+    if (verbose)
+        std::cout << "ONNXWRAPPER: Using the Static Runtime" << std::endl
+                  << std::flush;
+}
+
+void Classifier::enableProfiling(OpEventSink sink) {
+    namespace profiler = torch::autograd::profiler;
+
+    if (profiling)
+        disableProfiling();
+
+    profilingSink = std::move(sink);
+    profiler::enableProfilerLegacy(profiler::ProfilerConfig(profiler::ProfilerState::CPU, true));  // Record input shapes
+    profiling = true;
+}
+
+void Classifier::disableProfiling() {
+    namespace profiler = torch::autograd::profiler;
+
+    if (!profiling)
+        return;
+    profiling = false;
+    const profiler::thread_event_lists eventLists = profiler::disableProfilerLegacy();
+
+    /** An open range of the profiler */
+    struct OpenRange {
+        const profiler::LegacyEvent *begin;
+        bool insideScope;     // Inside a classify call
+        bool insideOperator;  // Inside an operator of the classify call
+    };
+
+    int invocation = -1;
+    for (const auto &events : eventLists) {  // One list per thread
+        std::vector<OpenRange> stack;
+        for (const auto &event : events) {
+            if (event.kind() == profiler::EventKind::PushRange) {
+                const std::string name = event.name();
+                const bool insideScope = !stack.empty() && stack.back().insideScope;
+                const bool insideOperator = !stack.empty() && stack.back().insideOperator;
+                if (!insideScope && name == profilingScopeName) {
+                    ++invocation;
+                    stack.push_back({&event, true, false});
+                } else {
+                    // Operators have a namespace (aten::, prim::, ...), TorchScript function scopes do not
+                    const bool isOperator = name.find("::") != std::string::npos;
+                    stack.push_back({&event, insideScope, insideOperator || (insideScope && isOperator)});
+                }
+            } else if (event.kind() == profiler::EventKind::PopRange && !stack.empty()) {
+                const OpenRange range = stack.back();
+                stack.pop_back();
+
+                // Report the outermost operators of each classify call
+                const bool isOperator = std::string(range.begin->name()).find("::") != std::string::npos;
+                const bool parentInsideOperator = !stack.empty() && stack.back().insideOperator;
+                if (!range.insideScope || !isOperator || parentInsideOperator || !profilingSink)
+                    continue;
+
+                OpEvent opEvent;
+                opEvent.op = range.begin->name();
+                opEvent.invocation = invocation;
+                opEvent.durationUs = range.begin->cpuElapsedUs(event);
+                opEvent.inputShapes = range.begin->shapes();
+                profilingSink(opEvent);
+            }
         }
     }
-    return argmax;
+    profilingSink = nullptr;
 }
 
-size_t Classifier::requestedInputSize(const torch::jit::Module *model) const {
+size_t Classifier::modelInputSize(const torch::jit::Module *model) const {
     // get input dimension from the input tensor metadata
     // assuming one input only
     int wanted_size = (*model->parameters().begin()).size(1);
     return wanted_size;
 }
 
-size_t Classifier::requestedOutputSize(const torch::jit::Module *model) const  // TODO: Check if optimizable
+size_t Classifier::modelOutputSize(const torch::jit::Module *model) const  // TODO: Check if optimizable
 {
     auto iter = model->parameters().begin();
     for (size_t i = 0; i < model->parameters().size() - 1; i++)
@@ -156,39 +403,4 @@ size_t Classifier::requestedOutputSize(const torch::jit::Module *model) const  /
 }
 
 /***** Handle functions *****/
-ClassifierPtr createClassifier(const std::string &filename, bool verbose) {
-    return new Classifier(filename, verbose);
-}
-
-void deleteClassifier(ClassifierPtr cls) {
-    if (cls)
-        delete cls;
-}
-
-int classify(ClassifierPtr cls, const float featureVector[], size_t numFeatures, float outputVector[], size_t numClasses) {
-    return cls->classify_internal(featureVector, numFeatures, outputVector, numClasses);
-}
-
-void softmax(float logitsArray[], size_t numClasses, bool verbose) {
-    if (verbose)
-        std::cout << "Applying softmax..." << std::endl
-                  << std::flush;
-
-    // Subtract Max from logits for stable Softmax https://stackoverflow.com/a/49212689 (TF does this too)
-    float max = logitsArray[0];
-    for (size_t i = 1; i < numClasses; ++i)
-        if (logitsArray[i] > max)
-            max = logitsArray[i];
-    for (size_t i = 0; i < numClasses; ++i)
-        logitsArray[i] -= max;
-
-    float tsum = 0;
-    for (size_t i = 0; i < numClasses; ++i)
-        tsum += exp(logitsArray[i]);
-    for (size_t i = 0; i < numClasses; ++i)
-        logitsArray[i] = exp(logitsArray[i]) / tsum;
-
-    if (verbose)
-        std::cout << "Done." << std::endl
-                  << std::flush;
-}
\ No newline at end of file
+#include "torchwrapper_handles.h"
@@ -7,7 +7,9 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
+#include <functional>
 #include <iostream>
 #include <limits>  // std::numeric_limits
 #include <string>
@@ -20,6 +22,60 @@ using ClassifierPtr = Classifier*;  // Opaque pointer for classifier object
 /** Dynamically allocate an instance of a classifier object (do not use in real time threads!) */
 ClassifierPtr createClassifier(const std::string& filename, bool verbose = false);
 
+/**
+ * @brief Dynamically allocate an instance of a classifier object from a buffer (do not use in real time threads!)
+ * The model is read from the buffer without copying it, the buffer is only needed during the call.
+ *
+ * @param buffer     Caller-owned buffer containing the .pt model
+ * @param bufferSize Size of the buffer in bytes
+ * @param verbose    verbose mode (to disable in real time threads)
+ * @return ClassifierPtr
+ */
+ClassifierPtr createClassifierFromBuffer(const char* buffer, size_t bufferSize, bool verbose = false);
+
+/** JIT fuser for the CPU graphs of the profiling executor */
+enum class Fuser {
+    Default,     // Leave the LibTorch setting as it is (NNC disabled on CPU by default)
+    TensorExpr,  // NNC (TensorExpr) fuser: element-wise chains compiled into one kernel during priming
+    None         // No fusion on CPU
+};
+
+/** Options of the classifier, applied when it is created */
+struct ClassifierOptions {
+    /**
+     * Run the optimized module in the Static Runtime (torch::jit::StaticModule) instead of the JIT interpreter:
+     * no per-operator interpreter dispatch and IValue boxing, out variants of the operators writing into
+     * intermediate buffers planned during priming and reused at every call. createClassifier throws if the model
+     * cannot run in the Static Runtime. The output tensor is still allocated by every call.
+     */
+    bool useStaticRuntime = false;
+
+    bool freeze = true;                // torch::jit::freeze: attributes and parameters become constants of the graph
+    bool optimizeForInference = true;  // torch::jit::optimize_for_inference on the frozen module (ignored without freeze)
+    Fuser fuser = Fuser::Default;      // (*)
+    bool profilingExecutor = true;     // false for the legacy executor, which specializes the graph at the first run (*)
+    int primingRuns = 0;               // forward calls made by createClassifier, 0 for as many as the executor needs (**)
+    std::string optimizedModelCacheDir;  // Existing directory for the built modules (***), empty to build at every load
+
+    // (*) Process-wide settings of LibTorch, set by createClassifier before priming. Each graph keeps the executor
+    //     and the fusion it got at its first run, so they only affect the classifiers created afterwards.
+    //     The TensorExpr fuser needs the profiling executor, createClassifier throws std::invalid_argument otherwise.
+    // (**) The profiling executor runs the graph getNumProfiledRuns() times recording shapes, then builds the
+    //      specialized (and fused) graph: with 0 it is primed until the optimized graph has run once, so the first
+    //      classify call already has the steady-state latency. One run is enough for the other executors.
+    // (***) The module after freeze/optimize_for_inference is saved as <model hash>-<settings hash>.pt, the settings
+    //       being the LibTorch version, freeze, optimizeForInference and the CPU architecture. The next loads of
+    //       the same model skip the build. Modules converted to MKLDNN layouts by optimize_for_inference cannot
+    //       be serialized, a warning is printed and they are built at every load. The executor optimizations
+    //       happen at run time and are never cached, priming still does them.
+    // With the lite interpreter (TORCHSCRIPTWRAPPER_LITE) the model runs as exported: only primingRuns is used,
+    // useStaticRuntime and optimizedModelCacheDir throw std::invalid_argument, the others are ignored.
+};
+
+/** createClassifier/createClassifierFromBuffer with options (do not use in real time threads!) */
+ClassifierPtr createClassifier(const std::string& filename, const ClassifierOptions& options, bool verbose = false);
+ClassifierPtr createClassifierFromBuffer(const char* buffer, size_t bufferSize, const ClassifierOptions& options, bool verbose = false);
+
 /** Feed a feature array (C Array) to the model, perform inference and return the prediction */
 int classify(ClassifierPtr cls, const float featureVector[], size_t numFeatures, float outputVector[], size_t numClasses);
 
@@ -31,9 +87,95 @@ int classify(ClassifierPtr cls, std::array<float, IN_SIZE>& featureArray, std::a
     return classify(cls, fa, (size_t)IN_SIZE, oa, (size_t)OUT_SIZE);
 }
 
+/**
+ * @brief Zero-copy input and output
+ * The input tensor of the model is a view over a 64-byte aligned buffer of getModelInputSize1d values, which can be
+ * written in place (e.g. by the feature extractor) instead of being copied by classify. classifyBound runs the model
+ * on it; the getModelOutputSize values of the result are then read in place, until the next classify/classifyBound:
+ *
+ *     float* features = getInputBuffer(cls);
+ *     ...
+ *     computeFeatures(features);
+ *     int predictedClass = classifyBound(cls);
+ *     const float* output = getOutputBuffer(cls);
+ *
+ * The output pointer changes at every call, LibTorch allocates the result of forward.
+ */
+float* getInputBuffer(ClassifierPtr cls);
+const float* getOutputBuffer(ClassifierPtr cls);
+
+/** Run the model on the input buffer and return the prediction, the output is at getOutputBuffer */
+int classifyBound(ClassifierPtr cls);
+
 /** Free the classifier memory (do not use in real time threads) */
 void deleteClassifier(ClassifierPtr cls);
 
+/**
+ * @brief Get the Model Input Size for 1dimentional input models
+ *
+ * @param cls
+ * @return size_t
+ */
+size_t getModelInputSize1d(ClassifierPtr cls);
+
+/**
+ * @brief Get the Model Output size
+ *
+ * @param cls
+ * @return size_t
+ */
+size_t getModelOutputSize(ClassifierPtr cls);
+
+/**
+ * @brief One operator execution, as reported by the native profiler of the runtime
+ * The same structure is used by all the wrappers, so that per-operator profiles can be compared.
+ */
+struct OpEvent {
+    std::string op;                                 // Operator type (e.g. "aten::conv2d")
+    std::string node;                               // Name of the node in the graph (empty if not reported by the runtime)
+    int invocation = 0;                             // Index of the classify call since enableProfiling
+    double durationUs = 0.0;                        // Execution time in microseconds
+    std::vector<std::vector<int64_t>> inputShapes;  // Shape of every input tensor of the operator
+};
+
+/** Callback that receives the operator events */
+using OpEventSink = std::function<void(const OpEvent&)>;
+
+/**
+ * @brief Enable the autograd profiler for the calling thread (do not use in real time threads)
+ * Only the classify calls made from the same thread are profiled. Only the outermost operators run by
+ * the model are reported (e.g. aten::linear, but not the aten::addmm it calls), with their inclusive time.
+ * The events of all invocations are passed to the sink by disableProfiling.
+ *
+ * @param cls  Classifier object
+ * @param sink Callback for the operator events
+ */
+void enableProfiling(ClassifierPtr cls, OpEventSink sink);
+
+/**
+ * @brief Stop the profiler and pass the recorded operator events to the sink, in execution order (do not use in real time threads)
+ * Must be called from the thread that called enableProfiling.
+ *
+ * @param cls Classifier object
+ */
+void disableProfiling(ClassifierPtr cls);
+
+/** Duration of one phase of the creation of a classifier */
+struct StartupPhase {
+    std::string name;         // "load", "build", "allocate" or "prime"
+    double durationUs = 0.0;  // Wall time in microseconds
+};
+
+/**
+ * @brief Get the time spent in each phase of createClassifier
+ * load: torch::jit::load of the .pt file, build: eval mode and the optimizations of the module, allocate: input/output
+ * tensors, prime: the first forward call.
+ *
+ * @param cls Classifier object
+ * @return The phases, in execution order
+ */
+std::vector<StartupPhase> getStartupPhases(ClassifierPtr cls);
+
 /**
  * @brief Apply softmax to a logits array
  * Apply softmax to a logits array when using networks that do not have a softmax output layer
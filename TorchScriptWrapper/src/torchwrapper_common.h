@@ -0,0 +1,204 @@
+/*
+ * Internal helpers shared by the two implementations of torchscriptwrapper.h:
+ * torchscriptwrapper.cpp (TorchScript JIT) and torchlitewrapper.cpp (lite interpreter).
+==============================================================================*/
+#pragma once
+
+#include "torchscriptwrapper.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <ios>
+#include <limits>  // std::numeric_limits
+#include <memory>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ATen/ATen.h"
+#include "c10/core/InferenceMode.h"
+
+namespace torchwrapper {
+
+/** Alignment of the input buffer (cache line, and the widest SIMD loads of ATen) */
+static const size_t inputAlignment = 64;
+
+/**
+ * Name of the extra file with the input and output sizes ("<input size> <output size>"), for the modules that have
+ * no parameters to read them from: frozen modules of the cache, and lite models whose parameters were folded into
+ * constants by the export.
+ */
+static const char *const sizesExtraFileName = "wrapper_sizes";
+
+/** Deleter of the buffers allocated with posix_memalign */
+struct AlignedDeleter {
+    void operator()(float *ptr) const { std::free(ptr); }
+};
+
+/** Read-only, seekable stream buffer over a caller-owned buffer, to load a model from std::istream without copying it */
+class MemoryStreamBuf : public std::streambuf {
+public:
+    MemoryStreamBuf(const char *buffer, size_t bufferSize) {
+        char *begin = const_cast<char *>(buffer);  // Never written: the buffer is only used for input
+        setg(begin, begin, begin + bufferSize);
+    }
+
+protected:
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode) override {
+        char *target = (direction == std::ios_base::beg ? eback() : direction == std::ios_base::cur ? gptr() : egptr()) + offset;
+        if (target < eback() || target > egptr())
+            return pos_type(off_type(-1));
+        setg(eback(), target, egptr());
+        return pos_type(target - eback());
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode mode) override {
+        return seekoff(off_type(position), std::ios_base::beg, mode);
+    }
+};
+
+/** Find the index of the maximum value in an array */
+inline int argmax(const float vec[], size_t vecSize) {
+    float max = std::numeric_limits<float>::lowest();  // Logits can all be negative
+    int argmax = -1;
+    for (size_t i = 0; i < vecSize; ++i) {
+        if (vec[i] > max) {
+            argmax = i;
+            max = vec[i];
+        }
+    }
+    return argmax;
+}
+
+/** Softmax of a logits array, in place (implementation of the softmax function of torchscriptwrapper.h) */
+inline void softmax(float logitsArray[], size_t numClasses, bool verbose) {
+    if (verbose)
+        std::cout << "Applying softmax..." << std::endl
+                  << std::flush;
+
+    // Subtract Max from logits for stable Softmax https://stackoverflow.com/a/49212689 (TF does this too)
+    float max = logitsArray[0];
+    for (size_t i = 1; i < numClasses; ++i)
+        if (logitsArray[i] > max)
+            max = logitsArray[i];
+    for (size_t i = 0; i < numClasses; ++i)
+        logitsArray[i] -= max;
+
+    float tsum = 0;
+    for (size_t i = 0; i < numClasses; ++i)
+        tsum += exp(logitsArray[i]);
+    for (size_t i = 0; i < numClasses; ++i)
+        logitsArray[i] = exp(logitsArray[i]) / tsum;
+
+    if (verbose)
+        std::cout << "Done." << std::endl
+                  << std::flush;
+}
+
+/**
+ * Part of the Classifier common to the two implementations: the aligned input buffer viewed by the input tensor,
+ * the contiguous output tensor, the size checks of classify and the startup phases.
+ * Derived (CRTP) runs the module: `at::Tensor runModel()` returns the output of one call on `input_`.
+ */
+template <typename Derived>
+class ClassifierBase {
+public:
+    /** Internal classification function, called by wrappers */
+    int classify_internal(const float featureVector[], size_t numFeatures, float outputVector[], size_t numClasses) {
+        if (numFeatures != storedRequestedInputSize)
+            throw std::logic_error("Error, input vector has to have size: " + std::to_string(storedRequestedInputSize) + " (Found " + std::to_string(numFeatures) + " instead)");
+        if (numClasses != storedRequestedOutputSize)
+            throw std::logic_error("Error, output vector has to have size: " + std::to_string(storedRequestedOutputSize) + " (Found " + std::to_string(numClasses) + " instead)");
+
+        // Fill `input`.
+        std::memcpy(this->inputBuffer.get(), featureVector, numFeatures * sizeof(float));
+
+        forward();
+
+        // Copy output
+        std::memcpy(outputVector, this->outputData, numClasses * sizeof(float));
+
+        return argmax(outputVector, numClasses);
+    }
+
+    /** Run the model on the input buffer, the result is in the output buffer */
+    int classifyBound() {
+        forward();
+        return argmax(this->outputData, storedRequestedOutputSize);
+    }
+
+    /** Input of the model, viewed by the input tensor */
+    float *getInputBuffer() { return inputBuffer.get(); }
+    /** Output of the last forward call (contiguous float tensor) */
+    const float *getOutputBuffer() const { return outputData; }
+
+    /** Input size of the loaded model */
+    size_t requestedInputSize() const { return storedRequestedInputSize; }
+    /** Output size of the loaded model */
+    size_t requestedOutputSize() const { return storedRequestedOutputSize; }
+
+    /** Duration of the phases of the constructor */
+    const std::vector<StartupPhase> &getStartupPhases() const { return startupPhases; }
+
+protected:
+    ClassifierBase() : phaseStart(std::chrono::steady_clock::now()) {}
+
+    /** Allocate the input buffer (zeros) and the input tensor viewing it, once the input size is known */
+    void allocateInput() {
+        const size_t inputBytes = storedRequestedInputSize * sizeof(float);
+        void *alignedBuffer = nullptr;
+        if (posix_memalign(&alignedBuffer, inputAlignment, inputBytes) != 0)
+            throw std::bad_alloc();
+        this->inputBuffer.reset((float *)alignedBuffer);
+        std::memset(this->inputBuffer.get(), 0, inputBytes);
+        this->input_.push_back(at::from_blob(this->inputBuffer.get(), {1, (long int)storedRequestedInputSize}, at::kFloat));
+        endStartupPhase("allocate");
+    }
+
+    /** Run the model primingRuns times on the zero input and check the size of its output */
+    void prime(size_t primingRuns) {
+        for (size_t i = 0; i < primingRuns; ++i)
+            forward();
+        if (this->output_.numel() != (int64_t)storedRequestedOutputSize)
+            throw std::runtime_error("The model returned " + std::to_string(this->output_.numel()) + " values, expected " + std::to_string(storedRequestedOutputSize));
+        endStartupPhase("prime");
+    }
+
+    /** Run forward on the input tensor and keep the output as a contiguous float tensor */
+    void forward() {
+        // Guard to enable inference mode in current scope
+        c10::InferenceMode guard;
+
+        at::Tensor result = static_cast<Derived *>(this)->runModel();
+        if (result.scalar_type() != at::kFloat)
+            throw std::runtime_error("The output of the model is not a float tensor");
+        // contiguous() returns the tensor itself when it already is, which is the case for the outputs of linear layers
+        this->output_ = result.is_contiguous() ? std::move(result) : result.contiguous();
+        this->outputData = this->output_.data_ptr<float>();
+    }
+
+    /** Record the time since the end of the previous phase (or the start of the constructor) */
+    void endStartupPhase(const char *name) {
+        const auto now = std::chrono::steady_clock::now();
+        startupPhases.push_back({name, std::chrono::duration<double, std::micro>(now - phaseStart).count()});
+        phaseStart = now;
+    }
+
+    size_t storedRequestedInputSize = 0, storedRequestedOutputSize = 0;
+
+    std::unique_ptr<float[], AlignedDeleter> inputBuffer;
+    std::vector<c10::IValue> input_;  // View over inputBuffer (at::from_blob)
+    at::Tensor output_;
+    const float *outputData = nullptr;  // Data of output_
+
+private:
+    std::vector<StartupPhase> startupPhases;
+    std::chrono::steady_clock::time_point phaseStart;
+};
+
+}  // namespace torchwrapper
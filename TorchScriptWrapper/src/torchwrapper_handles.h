@@ -0,0 +1,69 @@
+/*
+ * Handle functions of torchscriptwrapper.h, the same for the two implementations.
+ * Included once by torchscriptwrapper.cpp or torchlitewrapper.cpp, after the definition of its Classifier class.
+==============================================================================*/
+#pragma once
+
+#include "torchscriptwrapper.h"
+#include "torchwrapper_common.h"
+
+ClassifierPtr createClassifier(const std::string &filename, bool verbose) {
+    return createClassifier(filename, ClassifierOptions(), verbose);
+}
+
+ClassifierPtr createClassifier(const std::string &filename, const ClassifierOptions &options, bool verbose) {
+    return new Classifier(filename, options, verbose);
+}
+
+ClassifierPtr createClassifierFromBuffer(const char *buffer, size_t bufferSize, bool verbose) {
+    return createClassifierFromBuffer(buffer, bufferSize, ClassifierOptions(), verbose);
+}
+
+ClassifierPtr createClassifierFromBuffer(const char *buffer, size_t bufferSize, const ClassifierOptions &options, bool verbose) {
+    return new Classifier(buffer, bufferSize, options, verbose);
+}
+
+void deleteClassifier(ClassifierPtr cls) {
+    if (cls)
+        delete cls;
+}
+
+size_t getModelInputSize1d(ClassifierPtr cls) {
+    return cls->requestedInputSize();
+}
+
+size_t getModelOutputSize(ClassifierPtr cls) {
+    return cls->requestedOutputSize();
+}
+
+void enableProfiling(ClassifierPtr cls, OpEventSink sink) {
+    cls->enableProfiling(std::move(sink));
+}
+
+void disableProfiling(ClassifierPtr cls) {
+    cls->disableProfiling();
+}
+
+std::vector<StartupPhase> getStartupPhases(ClassifierPtr cls) {
+    return cls->getStartupPhases();
+}
+
+int classify(ClassifierPtr cls, const float featureVector[], size_t numFeatures, float outputVector[], size_t numClasses) {
+    return cls->classify_internal(featureVector, numFeatures, outputVector, numClasses);
+}
+
+float *getInputBuffer(ClassifierPtr cls) {
+    return cls->getInputBuffer();
+}
+
+const float *getOutputBuffer(ClassifierPtr cls) {
+    return cls->getOutputBuffer();
+}
+
+int classifyBound(ClassifierPtr cls) {
+    return cls->classifyBound();
+}
+
+void softmax(float logitsArray[], size_t numClasses, bool verbose) {
+    torchwrapper::softmax(logitsArray, numClasses, verbose);
+}
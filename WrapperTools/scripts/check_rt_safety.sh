@@ -0,0 +1,70 @@
+#!/usr/bin/env bash
+#
+# Run rt-safety-check on every model in TFLiteWrapper/2.7.0/data, for every backend build given.
+#
+# USAGE: check_rt_safety.sh <rt-safety-check binary> [<rt-safety-check binary> ...]
+#
+# Each binary is a WrapperTools build for one backend (-DWRAPPERTOOLS_BACKEND=...).
+# For backends that do not read .tflite files, the script looks for the converted
+# model (same name, backend extension, e.g. dense_1.onnx) in RT_SAFETY_CONVERTED_DIR,
+# by default next to each .tflite file, and skips the model if it is missing.
+# See the WrapperTools README to generate the converted models.
+# Set RT_SAFETY_DATA_DIR to use another model folder and RT_SAFETY_ARGS to pass
+# extra options (e.g. "--iterations 1000 --warmup 1").
+#
+# Exits with 1 if any model made non real-time safe calls or could not run, or if a
+# binary checked no model at all (every model skipped).
+
+set -u
+
+SCRIPT_DIR=$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )
+DATA_DIR=${RT_SAFETY_DATA_DIR:-$SCRIPT_DIR/../../TFLiteWrapper/2.7.0/data}
+CONVERTED_DIR=${RT_SAFETY_CONVERTED_DIR:-$DATA_DIR}
+EXTRA_ARGS=${RT_SAFETY_ARGS:-}
+
+if [ $# -lt 1 ]; then
+    echo "USAGE: $0 <rt-safety-check binary> [<rt-safety-check binary> ...]" >&2
+    exit 1
+fi
+
+passed=0
+failed=0
+errors=0
+skipped=0
+unchecked_backends=()
+
+for CHECK_BIN in "$@"; do
+    EXT=$("$CHECK_BIN" --model-extension)
+    checked=0
+    for tflite_model in "$DATA_DIR"/*.tflite; do
+        if [ "$EXT" = "tflite" ]; then
+            model="$tflite_model"
+        else
+            model="$CONVERTED_DIR/$(basename "${tflite_model%.tflite}").$EXT"
+        fi
+        if [ ! -f "$model" ]; then
+            echo "SKIP $(basename "$model") (no $EXT version of the model)"
+            skipped=$((skipped + 1))
+            continue
+        fi
+
+        checked=$((checked + 1))
+        # shellcheck disable=SC2086
+        "$CHECK_BIN" "$model" $EXTRA_ARGS
+        case $? in
+            0) passed=$((passed + 1)) ;;
+            2) failed=$((failed + 1)) ;;
+            *) errors=$((errors + 1)) ;;
+        esac
+    done
+    if [ $checked -eq 0 ]; then
+        echo "ERROR: $CHECK_BIN checked no model (no .$EXT model in $CONVERTED_DIR)"
+        unchecked_backends+=("$CHECK_BIN")
+    fi
+done
+
+echo "----------------------------------------"
+echo "RT-safety check: $passed passed, $failed failed, $errors could not run, $skipped skipped," \
+     "${#unchecked_backends[@]} backend(s) without models"
+
+[ $failed -eq 0 ] && [ $errors -eq 0 ] && [ ${#unchecked_backends[@]} -eq 0 ]
@@ -0,0 +1,250 @@
+/*
+ * Backend adapter for the wrapper tools, see backend.h
+ */
+#include "backend.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(WRAPPERTOOLS_BACKEND_TFLITE)
+    #include "tflitewrapper.h"
+#elif defined(WRAPPERTOOLS_BACKEND_ONNX)
+    #include "onnxwrapper.h"
+#elif defined(WRAPPERTOOLS_BACKEND_TORCH)
+    #include "torchscriptwrapper.h"
+#elif defined(WRAPPERTOOLS_BACKEND_RTNEURAL)
+    #include "rtneuralwrapper.h"
+#else
+    #error "No backend selected, set the WRAPPERTOOLS_BACKEND cmake option"
+#endif
+
+namespace WrapperTools {
+namespace Backend {
+
+/** Copy an event of the wrapper into the backend schema (the wrappers do not share a header) */
+template <typename WrapperOpEvent>
+static OpEvent convertOpEvent(const WrapperOpEvent& wrapperEvent) {
+    OpEvent event;
+    event.op = wrapperEvent.op;
+    event.node = wrapperEvent.node;
+    event.invocation = wrapperEvent.invocation;
+    event.durationUs = wrapperEvent.durationUs;
+    event.inputShapes = wrapperEvent.inputShapes;
+    return event;
+}
+
+/** Copy the startup phases of the wrapper into the backend schema */
+template <typename WrapperStartupPhase>
+static std::vector<StartupPhase> convertStartupPhases(const std::vector<WrapperStartupPhase>& wrapperPhases) {
+    std::vector<StartupPhase> phases;
+    for (const auto& wrapperPhase : wrapperPhases)
+        phases.push_back({wrapperPhase.name, wrapperPhase.durationUs});
+    return phases;
+}
+
+#if defined(WRAPPERTOOLS_BACKEND_TFLITE) || defined(WRAPPERTOOLS_BACKEND_ONNX)
+
+/** Interpreter and layout of its input, looked up once so that run does not allocate */
+struct Model {
+    InferenceEngine::InterpreterPtr interpreter = nullptr;
+    size_t inputSize = 0;         // Elements of the input tensor
+    size_t rows = 0, cols = 0;    // Matrix of the 2D models run with invokeFlat2D, 0 otherwise
+    float* inputBuffer = nullptr;  // Bound buffers of the other 2D models (e.g. several channels), null for 1D models
+    const float* outputBuffer = nullptr;
+};
+
+static InferenceEngine::InterpreterPtr unwrap(ModelPtr model) {
+    return model->interpreter;
+}
+
+/** 1D models ([batch, features]) go through invoke, 2D models through invokeFlat2D or the bound buffers */
+static ModelPtr wrap(InferenceEngine::InterpreterPtr interpreter) {
+    const auto input = InferenceEngine::getInputInfo(interpreter, 0);
+    ModelPtr model = new Model;
+    model->interpreter = interpreter;
+    model->inputSize = input.size;
+    if (input.shape.size() > 2) {
+    #if defined(WRAPPERTOOLS_BACKEND_TFLITE)
+        // [batch, rows, cols] or [batch, rows, cols, 1]
+        if (input.shape.size() == 3 || (input.shape.size() == 4 && input.shape[3] == 1)) {
+            model->rows = (size_t)input.shape[1];
+            model->cols = (size_t)input.shape[2];
+            return model;
+        }
+    #endif
+        model->inputBuffer = InferenceEngine::getInputBuffer(interpreter, 0);
+        model->outputBuffer = InferenceEngine::getOutputBuffer(interpreter, 0);
+    }
+    return model;
+}
+
+const char* getName() {
+    #if defined(WRAPPERTOOLS_BACKEND_TFLITE)
+    return "tflite";
+    #else
+    return "onnx";
+    #endif
+}
+
+const char* getModelExtension() {
+    #if defined(WRAPPERTOOLS_BACKEND_TFLITE)
+    return "tflite";
+    #else
+    return "onnx";
+    #endif
+}
+
+ModelPtr load(const std::string& filename, bool verbose) {
+    return wrap(InferenceEngine::createInterpreter(filename, verbose));
+}
+
+#if defined(WRAPPERTOOLS_BACKEND_ONNX)
+std::vector<std::string> getProfileNames() {
+    return InferenceEngine::getTuningProfileNames();
+}
+
+ModelPtr loadWithProfile(const std::string& filename, const std::string& profile, bool verbose) {
+    return wrap(InferenceEngine::createInterpreter(filename, InferenceEngine::getTuningProfile(profile), verbose));
+}
+#else
+std::vector<std::string> getProfileNames() {
+    return {"default"};
+}
+
+ModelPtr loadWithProfile(const std::string& filename, const std::string& profile, bool verbose) {
+    if (profile != "default")
+        throw std::invalid_argument("the " + std::string(getName()) + " backend has no tuning profile '" + profile + "'");
+    return load(filename, verbose);
+}
+#endif
+
+void run(ModelPtr model, const float inputVector[], size_t inputSize, float outputVector[], size_t outputSize) {
+    #if defined(WRAPPERTOOLS_BACKEND_TFLITE)
+    if (model->rows > 0) {
+        if (inputSize != model->inputSize)
+            throw std::logic_error("Error, input vector has to have size: " + std::to_string(model->inputSize) + " (Found " + std::to_string(inputSize) + " instead)");
+        InferenceEngine::invokeFlat2D(unwrap(model), inputVector, model->rows, model->cols, outputVector, outputSize);
+        return;
+    }
+    #endif
+    if (model->inputBuffer) {
+        if (inputSize != model->inputSize || outputSize != getOutputSize(model))
+            throw std::logic_error("Error, the input/output vectors have to have sizes: " + std::to_string(model->inputSize) + "/" + std::to_string(getOutputSize(model)));
+        std::copy(inputVector, inputVector + inputSize, model->inputBuffer);
+        InferenceEngine::invokeBound(unwrap(model));
+        std::copy(model->outputBuffer, model->outputBuffer + outputSize, outputVector);
+        return;
+    }
+    InferenceEngine::invoke(unwrap(model), inputVector, inputSize, outputVector, outputSize);
+}
+
+size_t getInputSize(ModelPtr model) {
+    return model->inputSize;
+}
+
+size_t getOutputSize(ModelPtr model) {
+    return InferenceEngine::getModelOutputSize(unwrap(model));
+}
+
+void enableProfiling(ModelPtr model, OpEventSink sink) {
+    InferenceEngine::enableProfiling(unwrap(model), [sink](const InferenceEngine::OpEvent& event) { sink(convertOpEvent(event)); });
+}
+
+void disableProfiling(ModelPtr model) {
+    InferenceEngine::disableProfiling(unwrap(model));
+}
+
+std::vector<StartupPhase> getStartupPhases(ModelPtr model) {
+    return convertStartupPhases(InferenceEngine::getStartupPhases(unwrap(model)));
+}
+
+void unload(ModelPtr model) {
+    if (!model)
+        return;
+    InferenceEngine::deleteInterpreter(unwrap(model));
+    delete model;
+}
+
+#else  // Classifier API
+
+static ClassifierPtr unwrap(ModelPtr model) {
+    return reinterpret_cast<ClassifierPtr>(model);
+}
+
+const char* getName() {
+    #if defined(WRAPPERTOOLS_BACKEND_TORCH)
+    return "torch";
+    #else
+    return "rtneural";
+    #endif
+}
+
+const char* getModelExtension() {
+    #if defined(WRAPPERTOOLS_BACKEND_TORCH)
+    return "pt";
+    #else
+    return "json";
+    #endif
+}
+
+ModelPtr load(const std::string& filename, bool verbose) {
+    return reinterpret_cast<ModelPtr>(createClassifier(filename, verbose));
+}
+
+#if defined(WRAPPERTOOLS_BACKEND_TORCH)
+std::vector<std::string> getProfileNames() {
+    return {"default", "static-runtime"};
+}
+
+ModelPtr loadWithProfile(const std::string& filename, const std::string& profile, bool verbose) {
+    ClassifierOptions options;
+    if (profile == "static-runtime")
+        options.useStaticRuntime = true;
+    else if (profile != "default")
+        throw std::invalid_argument("the " + std::string(getName()) + " backend has no tuning profile '" + profile + "'");
+    return reinterpret_cast<ModelPtr>(createClassifier(filename, options, verbose));
+}
+#else
+std::vector<std::string> getProfileNames() {
+    return {"default"};
+}
+
+ModelPtr loadWithProfile(const std::string& filename, const std::string& profile, bool verbose) {
+    if (profile != "default")
+        throw std::invalid_argument("the " + std::string(getName()) + " backend has no tuning profile '" + profile + "'");
+    return load(filename, verbose);
+}
+#endif
+
+void run(ModelPtr model, const float inputVector[], size_t inputSize, float outputVector[], size_t outputSize) {
+    classify(unwrap(model), inputVector, inputSize, outputVector, outputSize);
+}
+
+size_t getInputSize(ModelPtr model) {
+    return getModelInputSize1d(unwrap(model));
+}
+
+size_t getOutputSize(ModelPtr model) {
+    return getModelOutputSize(unwrap(model));
+}
+
+void enableProfiling(ModelPtr model, OpEventSink sink) {
+    ::enableProfiling(unwrap(model), [sink](const ::OpEvent& event) { sink(convertOpEvent(event)); });
+}
+
+void disableProfiling(ModelPtr model) {
+    ::disableProfiling(unwrap(model));
+}
+
+std::vector<StartupPhase> getStartupPhases(ModelPtr model) {
+    return convertStartupPhases(::getStartupPhases(unwrap(model)));
+}
+
+void unload(ModelPtr model) {
+    deleteClassifier(unwrap(model));
+}
+
+#endif
+
+}  // namespace Backend
+}  // namespace WrapperTools
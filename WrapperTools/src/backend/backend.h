@@ -0,0 +1,90 @@
+/*
+ * Backend adapter for the wrapper tools
+ *
+ * The tools in WrapperTools are built against exactly one inference wrapper,
+ * selected with the WRAPPERTOOLS_BACKEND cmake option (tflite, onnx, torch or rtneural).
+ * This header hides the differences between the InferenceEngine API (TFLite 2.11, ONNX Runtime)
+ * and the Classifier API (TorchScript, RTNeural).
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace WrapperTools {
+namespace Backend {
+
+struct Model;              // Opaque handle to the interpreter/classifier of the selected wrapper
+using ModelPtr = Model*;
+
+/** Name of the backend the tools were built against */
+const char* getName();
+
+/** File extension of the models accepted by the backend (without dot) */
+const char* getModelExtension();
+
+/** Load a model and prime it (do not use in real time threads!) */
+ModelPtr load(const std::string& filename, bool verbose = false);
+
+/** Names of the tuning profiles of the wrapper, "default" is always available */
+std::vector<std::string> getProfileNames();
+
+/**
+ * @brief Load a model with a tuning profile of the wrapper and prime it (do not use in real time threads!)
+ * Only the onnx backend (see InferenceEngine::getTuningProfile) and the torch backend ("static-runtime", see
+ * ClassifierOptions) have profiles besides "default".
+ * Throws std::invalid_argument for unknown profiles.
+ */
+ModelPtr loadWithProfile(const std::string& filename, const std::string& profile, bool verbose = false);
+
+/**
+ * @brief Run inference on an input vector (the call that has to be real-time safe)
+ * The input vector holds the whole input tensor, for 2D models the flattened feature matrix (rows x columns
+ * x channels, see getInputSize).
+ */
+void run(ModelPtr model, const float inputVector[], size_t inputSize, float outputVector[], size_t outputSize);
+
+/** Get the input size of the model (number of elements of the input tensor, also for 2D models) */
+size_t getInputSize(ModelPtr model);
+
+/** Get the output size of the model */
+size_t getOutputSize(ModelPtr model);
+
+/** One operator execution reported by the profiler of the wrapper (same fields as the OpEvent of the wrappers) */
+struct OpEvent {
+    std::string op;                                 // Operator type
+    std::string node;                               // Name of the node in the graph (may be empty)
+    int invocation = 0;                             // Index of the run call since enableProfiling
+    double durationUs = 0.0;                        // Execution time in microseconds
+    std::vector<std::vector<int64_t>> inputShapes;  // Shape of every input tensor of the operator
+};
+
+using OpEventSink = std::function<void(const OpEvent&)>;
+
+/**
+ * @brief Attach the native profiler of the wrapper (do not use in real time threads)
+ * Depending on the backend, the events are passed to the sink after every run or when profiling is disabled.
+ * Throws if the wrapper was built without profiling support.
+ */
+void enableProfiling(ModelPtr model, OpEventSink sink);
+
+/** Detach the profiler, all the remaining events are passed to the sink (do not use in real time threads) */
+void disableProfiling(ModelPtr model);
+
+/** Duration of one phase of load (same fields as the StartupPhase of the wrappers) */
+struct StartupPhase {
+    std::string name;         // "load", "build", "allocate" or "prime" (not every backend separates all of them)
+    double durationUs = 0.0;
+};
+
+/** Time spent in each phase of load, in execution order */
+std::vector<StartupPhase> getStartupPhases(ModelPtr model);
+
+/** Free the model (do not use in real time threads) */
+void unload(ModelPtr model);
+
+}  // namespace Backend
+}  // namespace WrapperTools
@@ -0,0 +1,257 @@
+/*
+ * Benchmark utilities, see bench.h
+ */
+#include "bench.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <thread>
+
+#ifndef WRAPPERTOOLS_CXX_FLAGS
+    #define WRAPPERTOOLS_CXX_FLAGS ""
+#endif
+#ifndef WRAPPERTOOLS_BUILD_TYPE
+    #define WRAPPERTOOLS_BUILD_TYPE ""
+#endif
+
+namespace WrapperTools {
+namespace Bench {
+
+/** Nearest-rank percentile of a sorted vector */
+static double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty())
+        return 0.0;
+    size_t rank = (size_t)std::ceil(fraction * (double)sorted.size());
+    rank = std::max<size_t>(rank, 1);
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+LatencyStats computeLatencyStats(std::vector<double>& latenciesUs, double wallTimeUs) {
+    LatencyStats stats;
+    if (latenciesUs.empty())
+        return stats;
+
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+
+    stats.count = latenciesUs.size();
+    stats.minUs = latenciesUs.front();
+    stats.maxUs = latenciesUs.back();
+    stats.medianUs = percentile(latenciesUs, 0.5);
+    stats.p90Us = percentile(latenciesUs, 0.9);
+    stats.p99Us = percentile(latenciesUs, 0.99);
+    stats.p999Us = percentile(latenciesUs, 0.999);
+    stats.jitterUs = stats.p99Us - stats.medianUs;
+
+    double sum = 0.0;
+    for (double latency : latenciesUs)
+        sum += latency;
+    stats.meanUs = sum / (double)stats.count;
+
+    double squares = 0.0;
+    for (double latency : latenciesUs)
+        squares += (latency - stats.meanUs) * (latency - stats.meanUs);
+    stats.stddevUs = std::sqrt(squares / (double)stats.count);
+
+    if (wallTimeUs > 0.0)
+        stats.throughputHz = (double)stats.count * 1e6 / wallTimeUs;
+    return stats;
+}
+
+/** First line of a file, empty if it cannot be read */
+static std::string readFirstLine(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+/** Value of the first "key : value" line of /proc/cpuinfo whose key is one of the given ones */
+static std::string readCpuInfo(const std::vector<std::string>& keys) {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        const auto colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+        std::string key = line.substr(0, colon);
+        key.erase(key.find_last_not_of(" \t") + 1);
+        if (std::find(keys.begin(), keys.end(), key) != keys.end())
+            return line.substr(std::min(colon + 2, line.size()));
+    }
+    return "";
+}
+
+HostInfo getHostInfo(int cpu) {
+    HostInfo host;
+
+    char hostname[256] = {0};
+    if (gethostname(hostname, sizeof(hostname) - 1) == 0)
+        host.hostname = hostname;
+
+    struct utsname name;
+    if (uname(&name) == 0) {
+        host.kernel = name.release;
+        host.machine = name.machine;
+    }
+
+    // x86 reports "model name", ARM boards "Model" or "Hardware"
+    host.cpuModel = readCpuInfo({"model name", "Model", "Hardware", "cpu model"});
+    if (host.cpuModel.empty())
+        host.cpuModel = "unknown";
+    host.numCpus = std::thread::hardware_concurrency();
+
+    host.governor = readFirstLine("/sys/devices/system/cpu/cpu" + std::to_string(cpu < 0 ? 0 : cpu) + "/cpufreq/scaling_governor");
+    if (host.governor.empty())
+        host.governor = "unknown";
+
+#if defined(__clang__)
+    host.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    host.compiler = "gcc " __VERSION__;
+#else
+    host.compiler = "unknown";
+#endif
+    host.cxxFlags = WRAPPERTOOLS_CXX_FLAGS;
+    host.buildType = WRAPPERTOOLS_BUILD_TYPE;
+    return host;
+}
+
+bool applyRealtimeSettings(const RealtimeSettings& settings, std::string& errors) {
+    bool ok = true;
+
+    if (settings.cpu >= 0) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(settings.cpu, &cpuSet);
+        const int res = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        if (res != 0) {
+            errors += "could not pin to cpu " + std::to_string(settings.cpu) + ": " + std::strerror(res) + "\n";
+            ok = false;
+        }
+    }
+
+    if (settings.fifoPriority > 0) {
+        sched_param param;
+        param.sched_priority = settings.fifoPriority;
+        const int res = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (res != 0) {
+            errors += "could not set SCHED_FIFO priority " + std::to_string(settings.fifoPriority) + ": " + std::strerror(res) + "\n";
+            ok = false;
+        }
+    }
+
+    if (settings.lockMemory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        errors += std::string("could not lock memory: ") + std::strerror(errno) + "\n";
+        ok = false;
+    }
+    return ok;
+}
+
+MemoryUsage getMemoryUsage() {
+    MemoryUsage memory;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        const auto colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+        const std::string key = line.substr(0, colon);
+        const long valueKb = std::strtol(line.c_str() + colon + 1, nullptr, 10);  // Values are "<n> kB"
+        if (key == "VmRSS")
+            memory.rssKb = valueKb;
+        else if (key == "RssAnon")
+            memory.anonKb = valueKb;
+        else if (key == "RssFile")
+            memory.fileKb = valueKb;
+        else if (key == "RssShmem")
+            memory.shmemKb = valueKb;
+    }
+    return memory;
+}
+
+MemoryUsage operator-(const MemoryUsage& after, const MemoryUsage& before) {
+    MemoryUsage difference;
+    difference.rssKb = after.rssKb - before.rssKb;
+    difference.anonKb = after.anonKb - before.anonKb;
+    difference.fileKb = after.fileKb - before.fileKb;
+    difference.shmemKb = after.shmemKb - before.shmemKb;
+    return difference;
+}
+
+std::string escapeJson(const std::string& value) {
+    std::string result;
+    for (char c : value) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        if (c == '\n' || c == '\t')
+            c = ' ';
+        result += c;
+    }
+    return result;
+}
+
+std::string quoteCsv(const std::string& value) {
+    std::string result = "\"";
+    for (char c : value)
+        result += c == '"' ? std::string("\"\"") : std::string(1, c);
+    return result + "\"";
+}
+
+std::string baseName(const std::string& path) {
+    const auto slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+std::string currentTimestamp() {
+    const std::time_t now = std::time(nullptr);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return buffer;
+}
+
+void writeHostInfoJson(std::ostream& os, const HostInfo& host, const std::string& indent) {
+    os << indent << "\"hostname\": \"" << escapeJson(host.hostname) << "\"," << std::endl
+       << indent << "\"kernel\": \"" << escapeJson(host.kernel) << "\"," << std::endl
+       << indent << "\"machine\": \"" << escapeJson(host.machine) << "\"," << std::endl
+       << indent << "\"cpu_model\": \"" << escapeJson(host.cpuModel) << "\"," << std::endl
+       << indent << "\"num_cpus\": " << host.numCpus << "," << std::endl
+       << indent << "\"governor\": \"" << escapeJson(host.governor) << "\"," << std::endl
+       << indent << "\"compiler\": \"" << escapeJson(host.compiler) << "\"," << std::endl
+       << indent << "\"cxx_flags\": \"" << escapeJson(host.cxxFlags) << "\"," << std::endl
+       << indent << "\"build_type\": \"" << escapeJson(host.buildType) << "\"" << std::endl;
+}
+
+void writeLatencyStatsJson(std::ostream& os, const LatencyStats& stats, const std::string& indent) {
+    os << indent << "\"count\": " << stats.count << "," << std::endl
+       << indent << "\"min_us\": " << stats.minUs << "," << std::endl
+       << indent << "\"median_us\": " << stats.medianUs << "," << std::endl
+       << indent << "\"p90_us\": " << stats.p90Us << "," << std::endl
+       << indent << "\"p99_us\": " << stats.p99Us << "," << std::endl
+       << indent << "\"p999_us\": " << stats.p999Us << "," << std::endl
+       << indent << "\"max_us\": " << stats.maxUs << "," << std::endl
+       << indent << "\"mean_us\": " << stats.meanUs << "," << std::endl
+       << indent << "\"stddev_us\": " << stats.stddevUs << "," << std::endl
+       << indent << "\"jitter_us\": " << stats.jitterUs << "," << std::endl
+       << indent << "\"throughput_hz\": " << stats.throughputHz << std::endl;
+}
+
+void writeMemoryUsageJson(std::ostream& os, const MemoryUsage& memory, const std::string& indent) {
+    os << indent << "\"rss_kb\": " << memory.rssKb << "," << std::endl
+       << indent << "\"anon_kb\": " << memory.anonKb << "," << std::endl
+       << indent << "\"file_kb\": " << memory.fileKb << "," << std::endl
+       << indent << "\"shmem_kb\": " << memory.shmemKb << std::endl;
+}
+
+}  // namespace Bench
+}  // namespace WrapperTools
@@ -0,0 +1,111 @@
+/*
+ * Benchmark utilities shared by the wrapper tools
+ *
+ * Latency statistics, real-time scheduling setup and a description of the host,
+ * so that the results of different runs and machines can be compared.
+ */
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace WrapperTools {
+namespace Bench {
+
+/** Latency distribution of a set of measurements, in microseconds */
+struct LatencyStats {
+    size_t count = 0;
+    double minUs = 0.0;
+    double medianUs = 0.0;
+    double p90Us = 0.0;
+    double p99Us = 0.0;
+    double p999Us = 0.0;
+    double maxUs = 0.0;
+    double meanUs = 0.0;
+    double stddevUs = 0.0;
+    double jitterUs = 0.0;       // p99 - median
+    double throughputHz = 0.0;   // Measurements per second of wall time (0 if unknown)
+};
+
+/**
+ * @brief Compute the statistics of a set of latencies
+ *
+ * @param latenciesUs  Latencies in microseconds (sorted in place)
+ * @param wallTimeUs   Total wall time of the measured loop, used for the throughput (0 to skip)
+ */
+LatencyStats computeLatencyStats(std::vector<double>& latenciesUs, double wallTimeUs = 0.0);
+
+/** Description of the machine and of the build */
+struct HostInfo {
+    std::string hostname;
+    std::string kernel;      // uname release
+    std::string machine;     // uname machine (x86_64, aarch64, ...)
+    std::string cpuModel;
+    unsigned numCpus = 0;
+    std::string governor;    // cpufreq scaling governor of the measured CPU ("unknown" if not available)
+    std::string compiler;
+    std::string cxxFlags;    // Compiler flags of the tools build
+    std::string buildType;
+};
+
+/**
+ * @brief Collect the host description
+ *
+ * @param cpu CPU whose governor is reported (the pinned one, -1 for cpu0)
+ */
+HostInfo getHostInfo(int cpu = -1);
+
+/** Scheduling requested for the measuring thread */
+struct RealtimeSettings {
+    int cpu = -1;           // Pin the thread to this CPU (-1: no pinning)
+    int fifoPriority = 0;   // SCHED_FIFO priority (0: keep the default policy)
+    bool lockMemory = false;  // mlockall the process memory
+};
+
+/**
+ * @brief Apply the scheduling settings to the calling thread
+ * Failures (usually missing privileges) are described in errors, the other settings are still applied.
+ *
+ * @return true if every setting was applied
+ */
+bool applyRealtimeSettings(const RealtimeSettings& settings, std::string& errors);
+
+/** Resident memory of the process, from /proc/self/status (all 0 if not available) */
+struct MemoryUsage {
+    long rssKb = 0;    // VmRSS: total resident memory
+    long anonKb = 0;   // RssAnon: anonymous pages (heap, stacks, anonymous mmaps)
+    long fileKb = 0;   // RssFile: file-backed pages (shared libraries, mmapped models)
+    long shmemKb = 0;  // RssShmem: shared memory
+};
+
+/** Read the current resident memory of the process */
+MemoryUsage getMemoryUsage();
+
+/** Difference between two memory readings (after - before) */
+MemoryUsage operator-(const MemoryUsage& after, const MemoryUsage& before);
+
+/** Escape a string for a JSON value */
+std::string escapeJson(const std::string& value);
+
+/** Quote a string for a CSV field */
+std::string quoteCsv(const std::string& value);
+
+/** File name part of a path */
+std::string baseName(const std::string& path);
+
+/** Current UTC time in ISO 8601 format, stored with the results */
+std::string currentTimestamp();
+
+/** Write the host description as the members of a JSON object (without braces) */
+void writeHostInfoJson(std::ostream& os, const HostInfo& host, const std::string& indent);
+
+/** Write the latency statistics as the members of a JSON object (without braces) */
+void writeLatencyStatsJson(std::ostream& os, const LatencyStats& stats, const std::string& indent);
+
+/** Write a memory reading as the members of a JSON object (without braces) */
+void writeMemoryUsageJson(std::ostream& os, const MemoryUsage& memory, const std::string& indent);
+
+}  // namespace Bench
+}  // namespace WrapperTools
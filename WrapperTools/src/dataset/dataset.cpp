@@ -0,0 +1,394 @@
+/*
+ * Feature dataset loader, see dataset.h
+ */
+#include "dataset.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace WrapperTools {
+namespace Dataset {
+
+namespace {
+
+/** Read-only memory map of a whole file */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+        fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("could not open " + filename + ": " + std::strerror(errno));
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0) {
+            close(fd);
+            throw std::runtime_error("could not stat " + filename + ": " + std::strerror(errno));
+        }
+        size = (size_t)fileStat.st_size;
+        if (size == 0)
+            return;
+        void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("could not map " + filename + ": " + std::strerror(errno));
+        }
+        data = static_cast<const char*>(address);
+        madvise(address, size, MADV_SEQUENTIAL);
+    }
+
+    ~MappedFile() {
+        if (data)
+            munmap(const_cast<char*>(data), size);
+        close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const { return data; }
+    const char* end() const { return data + size; }
+
+private:
+    int fd = -1;
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+/** Files smaller than this are parsed by one thread */
+constexpr size_t minBytesPerThread = 256 * 1024;
+
+bool isSeparator(char c) {
+    return c == ' ' || c == '\t' || c == '"' || c == '\r';
+}
+
+/** End of the line starting at cursor (the position of '\n', or end) */
+const char* findLineEnd(const char* cursor, const char* end) {
+    const void* newline = std::memchr(cursor, '\n', (size_t)(end - cursor));
+    return newline ? static_cast<const char*>(newline) : end;
+}
+
+bool isBlankLine(const char* begin, const char* end) {
+    for (const char* c = begin; c < end; ++c)
+        if (!isSeparator(*c))
+            return false;
+    return true;
+}
+
+/** strtof on a copy of the field, for the values std::from_chars does not take (and compilers without it) */
+bool parseWithStrtof(const char*& cursor, const char* end, float& value) {
+    char buffer[64];
+    const size_t length = std::min((size_t)(end - cursor), sizeof(buffer) - 1);
+    std::memcpy(buffer, cursor, length);
+    buffer[length] = '\0';
+    char* parsedEnd;
+    value = std::strtof(buffer, &parsedEnd);
+    if (parsedEnd == buffer)
+        return false;
+    cursor += parsedEnd - buffer;
+    return true;
+}
+
+bool parseFloat(const char*& cursor, const char* end, float& value) {
+    if (cursor < end && *cursor == '+')  // Not accepted by from_chars
+        ++cursor;
+#if defined(__cpp_lib_to_chars)
+    const auto result = std::from_chars(cursor, end, value);
+    if (result.ec == std::errc()) {
+        cursor = result.ptr;
+        return true;
+    }
+    if (result.ec == std::errc::invalid_argument)
+        return false;
+    // Out of range (e.g. denormals): let strtof round it
+#endif
+    return parseWithStrtof(cursor, end, value);
+}
+
+/**
+ * Parse the fields of one line into values (at most maxValues are stored)
+ * @return The number of fields of the line, or -1 if a field is not a number
+ */
+long parseLine(const char* begin, const char* end, float* values, size_t maxValues) {
+    size_t count = 0;
+    const char* cursor = begin;
+    while (true) {
+        while (cursor < end && isSeparator(*cursor))
+            ++cursor;
+        float value;
+        if (!parseFloat(cursor, end, value))
+            return -1;
+        if (count < maxValues)
+            values[count] = value;
+        ++count;
+        while (cursor < end && isSeparator(*cursor))
+            ++cursor;
+        if (cursor == end)
+            return (long)count;
+        if (*cursor != ',')
+            return -1;
+        ++cursor;
+    }
+}
+
+/** Run a function on every chunk, each one in its own thread, and rethrow the first exception */
+template <typename Function>
+void forEachChunk(size_t numChunks, Function function) {
+    std::vector<std::exception_ptr> errors(numChunks);
+    std::vector<std::thread> threads;
+    for (size_t chunk = 1; chunk < numChunks; ++chunk)
+        threads.emplace_back([&, chunk]() {
+            try {
+                function(chunk);
+            } catch (...) {
+                errors[chunk] = std::current_exception();
+            }
+        });
+    try {
+        function(0);
+    } catch (...) {
+        errors[0] = std::current_exception();
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (const auto& error : errors)
+        if (error)
+            std::rethrow_exception(error);
+}
+
+bool endsWith(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool isLittleEndian() {
+    const uint16_t one = 1;
+    return *reinterpret_cast<const uint8_t*>(&one) == 1;
+}
+
+/** Value of a key in the header dictionary of a .npy file, e.g. "'<f4'" for 'descr' */
+std::string getNpyHeaderValue(const std::string& header, const std::string& key) {
+    size_t pos = header.find("'" + key + "'");
+    if (pos == std::string::npos)
+        return "";
+    pos = header.find(':', pos);
+    if (pos == std::string::npos)
+        return "";
+    const size_t begin = header.find_first_not_of(' ', pos + 1);
+    if (begin == std::string::npos)
+        return "";
+    const size_t end = header[begin] == '(' ? header.find(')', begin) + 1 : header.find(',', begin);
+    return header.substr(begin, end - begin);
+}
+
+}  // namespace
+
+Matrix readCsv(const std::string& filename, bool skipHeader, unsigned numThreads) {
+    const MappedFile file(filename);
+    const char* dataBegin = file.begin();
+    const char* dataEnd = file.end();
+    Matrix matrix;
+    if (dataBegin == nullptr)
+        return matrix;
+
+    if (skipHeader) {
+        dataBegin = findLineEnd(dataBegin, dataEnd);
+        if (dataBegin < dataEnd)
+            ++dataBegin;
+    }
+
+    // Number of columns, from the first non-blank line
+    for (const char* line = dataBegin; line < dataEnd;) {
+        const char* lineEnd = findLineEnd(line, dataEnd);
+        if (!isBlankLine(line, lineEnd)) {
+            const long fields = parseLine(line, lineEnd, nullptr, 0);
+            if (fields <= 0)
+                throw std::runtime_error("invalid number in the first row of " + filename);
+            matrix.cols = (size_t)fields;
+            break;
+        }
+        line = lineEnd + 1;
+    }
+    if (matrix.cols == 0)
+        return matrix;
+
+    // Chunks of whole lines, one per thread
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t dataSize = (size_t)(dataEnd - dataBegin);
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(numThreads, dataSize / minBytesPerThread));
+    std::vector<const char*> chunkBegins(numChunks + 1, dataEnd);
+    chunkBegins[0] = dataBegin;
+    for (size_t chunk = 1; chunk < numChunks; ++chunk) {
+        const char* boundary = std::max(chunkBegins[chunk - 1], dataBegin + chunk * (dataSize / numChunks));
+        boundary = findLineEnd(boundary, dataEnd);
+        chunkBegins[chunk] = boundary < dataEnd ? boundary + 1 : dataEnd;
+    }
+
+    // Pass 1: count the rows of every chunk, to know where each chunk goes in the matrix
+    std::vector<size_t> chunkRows(numChunks, 0);
+    forEachChunk(numChunks, [&](size_t chunk) {
+        for (const char* line = chunkBegins[chunk]; line < chunkBegins[chunk + 1];) {
+            const char* lineEnd = findLineEnd(line, chunkBegins[chunk + 1]);
+            if (!isBlankLine(line, lineEnd))
+                ++chunkRows[chunk];
+            line = lineEnd + 1;
+        }
+    });
+    std::vector<size_t> chunkFirstRow(numChunks, 0);
+    for (size_t chunk = 1; chunk < numChunks; ++chunk)
+        chunkFirstRow[chunk] = chunkFirstRow[chunk - 1] + chunkRows[chunk - 1];
+    matrix.rows = chunkFirstRow.back() + chunkRows.back();
+    matrix.values.resize(matrix.rows * matrix.cols);
+
+    // Pass 2: parse every chunk into its rows
+    forEachChunk(numChunks, [&](size_t chunk) {
+        size_t row = chunkFirstRow[chunk];
+        for (const char* line = chunkBegins[chunk]; line < chunkBegins[chunk + 1];) {
+            const char* lineEnd = findLineEnd(line, chunkBegins[chunk + 1]);
+            if (!isBlankLine(line, lineEnd)) {
+                const long fields = parseLine(line, lineEnd, matrix.row(row), matrix.cols);
+                if (fields < 0)
+                    throw std::runtime_error("invalid number in row " + std::to_string(row + 1) + " of " + filename);
+                if ((size_t)fields != matrix.cols)
+                    throw std::runtime_error("row " + std::to_string(row + 1) + " of " + filename + " has " + std::to_string(fields) +
+                                             " values, expected " + std::to_string(matrix.cols));
+                ++row;
+            }
+            line = lineEnd + 1;
+        }
+    });
+    return matrix;
+}
+
+Matrix readNpy(const std::string& filename) {
+    if (!isLittleEndian())
+        throw std::runtime_error(".npy files are only supported on little-endian hosts");
+
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("could not open " + filename);
+
+    char preamble[8];
+    if (!file.read(preamble, sizeof(preamble)) || std::memcmp(preamble, "\x93NUMPY", 6) != 0)
+        throw std::runtime_error(filename + " is not a .npy file");
+    const int majorVersion = (unsigned char)preamble[6];
+
+    uint32_t headerLength = 0;
+    unsigned char lengthBytes[4] = {0, 0, 0, 0};
+    if (!file.read(reinterpret_cast<char*>(lengthBytes), majorVersion == 1 ? 2 : 4))
+        throw std::runtime_error("truncated .npy header in " + filename);
+    headerLength = lengthBytes[0] | (lengthBytes[1] << 8) | (lengthBytes[2] << 16) | ((uint32_t)lengthBytes[3] << 24);
+    std::string header(headerLength, '\0');
+    if (!file.read(&header[0], headerLength))
+        throw std::runtime_error("truncated .npy header in " + filename);
+
+    if (getNpyHeaderValue(header, "descr") != "'<f4'")
+        throw std::runtime_error(filename + " does not contain float32 values (descr " + getNpyHeaderValue(header, "descr") + ")");
+    if (getNpyHeaderValue(header, "fortran_order") != "False")
+        throw std::runtime_error(filename + " is not in C order");
+
+    // Shape: "(rows, cols)" or "(rows,)"
+    const std::string shape = getNpyHeaderValue(header, "shape");
+    std::vector<size_t> dims;
+    for (const char* cursor = shape.c_str(); *cursor != '\0'; ++cursor) {
+        if (*cursor >= '0' && *cursor <= '9') {
+            char* end;
+            dims.push_back((size_t)std::strtoull(cursor, &end, 10));
+            cursor = end - 1;
+        }
+    }
+    if (dims.empty() || dims.size() > 2)
+        throw std::runtime_error(filename + " is not a 1D or 2D array (shape " + shape + ")");
+
+    Matrix matrix;
+    matrix.rows = dims[0];
+    matrix.cols = dims.size() == 2 ? dims[1] : 1;
+    matrix.values.resize(matrix.rows * matrix.cols);
+    if (!file.read(reinterpret_cast<char*>(matrix.values.data()), (std::streamsize)(matrix.values.size() * sizeof(float))))
+        throw std::runtime_error("truncated data in " + filename);
+    return matrix;
+}
+
+void writeNpy(const std::string& filename, const Matrix& matrix) {
+    if (!isLittleEndian())
+        throw std::runtime_error(".npy files are only supported on little-endian hosts");
+
+    std::string header = "{'descr': '<f4', 'fortran_order': False, 'shape': (" + std::to_string(matrix.rows) + ", " +
+                         std::to_string(matrix.cols) + "), }";
+    // The data starts at a multiple of 64 bytes, the header ends with a newline
+    const size_t preambleLength = 10;
+    header.append(63 - (preambleLength + header.size()) % 64, ' ');
+    header += '\n';
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file)
+        throw std::runtime_error("could not create " + filename);
+    const unsigned char lengthBytes[2] = {(unsigned char)(header.size() & 0xff), (unsigned char)(header.size() >> 8)};
+    file.write("\x93NUMPY\x01\x00", 8);
+    file.write(reinterpret_cast<const char*>(lengthBytes), 2);
+    file.write(header.data(), (std::streamsize)header.size());
+    file.write(reinterpret_cast<const char*>(matrix.values.data()), (std::streamsize)(matrix.values.size() * sizeof(float)));
+    if (!file)
+        throw std::runtime_error("could not write " + filename);
+}
+
+std::string getCachePath(const std::string& csvFilename, bool skipHeader) {
+    return csvFilename + (skipHeader ? ".npy" : ".noheader.npy");
+}
+
+Matrix load(const std::string& filename, const LoadOptions& options) {
+    if (endsWith(filename, ".npy"))
+        return readNpy(filename);
+    if (!options.useCache)
+        return readCsv(filename, options.skipHeader, options.numThreads);
+
+    const std::string cachePath = getCachePath(filename, options.skipHeader);
+    struct stat csvStat, cacheStat;
+    if (stat(filename.c_str(), &csvStat) != 0)
+        throw std::runtime_error("could not open " + filename + ": " + std::strerror(errno));
+    if (stat(cachePath.c_str(), &cacheStat) == 0 && cacheStat.st_mtime >= csvStat.st_mtime) {
+        try {
+            return readNpy(cachePath);
+        } catch (const std::exception&) {
+            // Unreadable cache, parse the CSV file again and replace it
+        }
+    }
+
+    Matrix matrix = readCsv(filename, options.skipHeader, options.numThreads);
+
+    // Written under a temporary name, so that a concurrent run never reads a partial cache
+    const std::string temporaryPath = cachePath + ".tmp" + std::to_string(getpid());
+    try {
+        writeNpy(temporaryPath, matrix);
+        if (std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0)
+            std::remove(temporaryPath.c_str());
+    } catch (const std::exception&) {
+        std::remove(temporaryPath.c_str());  // Read-only directory: run without cache
+    }
+    return matrix;
+}
+
+std::vector<int> toLabels(const Matrix& matrix) {
+    if (matrix.rows > 0 && matrix.cols != 1)
+        throw std::runtime_error("labels must have one column, found " + std::to_string(matrix.cols));
+    std::vector<int> labels(matrix.rows);
+    for (size_t i = 0; i < matrix.rows; ++i)
+        labels[i] = (int)std::lround(matrix.values[i]);
+    return labels;
+}
+
+}  // namespace Dataset
+}  // namespace WrapperTools
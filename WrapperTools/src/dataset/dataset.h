@@ -0,0 +1,68 @@
+/*
+ * Feature dataset loader
+ *
+ * Reads the CSV files of feature vectors and labels used by the bulk evaluations into one contiguous
+ * row-major float matrix. The file is memory mapped and parsed with std::from_chars by several threads,
+ * each one on a chunk of whole lines. The parsed matrix can be cached next to the CSV file in the NumPy
+ * .npy format (float32, C order), which later runs read directly:
+ *
+ *     WrapperTools::Dataset::Matrix features = WrapperTools::Dataset::load("features.csv");
+ *     for (size_t i = 0; i < features.rows; ++i)
+ *         Backend::run(model, features.row(i), features.cols, output.data(), output.size());
+ *
+ * The cache of features.csv is features.csv.npy, and can also be opened with numpy.load.
+ * No dependency on the wrappers, so the test programs of the wrappers can use it too.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace WrapperTools {
+namespace Dataset {
+
+/** Row-major matrix of float values */
+struct Matrix {
+    size_t rows = 0;
+    size_t cols = 0;
+    std::vector<float> values;  // rows * cols values
+
+    const float* row(size_t index) const { return values.data() + index * cols; }
+    float* row(size_t index) { return values.data() + index * cols; }
+};
+
+struct LoadOptions {
+    bool skipHeader = true;  // The first line of the CSV file is a header
+    unsigned numThreads = 0;  // Parsing threads (0: one per CPU)
+    bool useCache = true;     // Read/write the .npy cache next to the CSV file
+};
+
+/**
+ * @brief Parse a CSV file of numbers
+ * Fields are separated by commas, may be surrounded by spaces and double quotes, empty lines are skipped.
+ * Every row must have the same number of fields. Throws std::runtime_error on errors.
+ */
+Matrix readCsv(const std::string& filename, bool skipHeader = true, unsigned numThreads = 0);
+
+/** Read a 1D or 2D little-endian float32 C-order .npy file (a 1D array is read as one column). Throws std::runtime_error on errors. */
+Matrix readNpy(const std::string& filename);
+
+/** Write a matrix as a 2D float32 .npy file (NumPy format version 1.0). Throws std::runtime_error on errors. */
+void writeNpy(const std::string& filename, const Matrix& matrix);
+
+/** Name of the cache file of a CSV file */
+std::string getCachePath(const std::string& csvFilename, bool skipHeader = true);
+
+/**
+ * @brief Load a dataset
+ * .npy files are read directly. For CSV files, the cache is used if it is at least as recent as the CSV file,
+ * otherwise the CSV file is parsed and the cache is (re)written. Failing to write the cache is not an error.
+ */
+Matrix load(const std::string& filename, const LoadOptions& options = LoadOptions());
+
+/** Convert a single-column matrix of class labels to integers */
+std::vector<int> toLabels(const Matrix& matrix);
+
+}  // namespace Dataset
+}  // namespace WrapperTools
@@ -0,0 +1,151 @@
+/*
+ * Confusion matrix of a classifier, see confusion.h
+ */
+#include "confusion.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+namespace WrapperTools {
+
+ConfusionMatrix::ConfusionMatrix(size_t numClasses) : numClasses(numClasses), counts(numClasses * numClasses, 0) {}
+
+void ConfusionMatrix::merge(const ConfusionMatrix& other) {
+    if (other.numClasses != numClasses)
+        throw std::logic_error("Cannot merge confusion matrices of " + std::to_string(other.numClasses) + " and " + std::to_string(numClasses) + " classes");
+    for (size_t i = 0; i < counts.size(); ++i)
+        counts[i] += other.counts[i];
+}
+
+uint64_t ConfusionMatrix::getTotal() const {
+    uint64_t total = 0;
+    for (uint64_t count : counts)
+        total += count;
+    return total;
+}
+
+uint64_t ConfusionMatrix::getCorrect() const {
+    uint64_t correct = 0;
+    for (size_t i = 0; i < numClasses; ++i)
+        correct += get(i, i);
+    return correct;
+}
+
+double ConfusionMatrix::getAccuracy() const {
+    const uint64_t total = getTotal();
+    return total > 0 ? (double)getCorrect() / (double)total : 0.0;
+}
+
+ConfusionMatrix::ClassMetrics ConfusionMatrix::getClassMetrics(size_t classIndex) const {
+    ClassMetrics metrics;
+    for (size_t i = 0; i < numClasses; ++i) {
+        metrics.support += get(classIndex, i);
+        metrics.predicted += get(i, classIndex);
+    }
+    metrics.truePositives = get(classIndex, classIndex);
+    if (metrics.predicted > 0)
+        metrics.precision = (double)metrics.truePositives / (double)metrics.predicted;
+    if (metrics.support > 0)
+        metrics.recall = (double)metrics.truePositives / (double)metrics.support;
+    if (metrics.precision + metrics.recall > 0.0)
+        metrics.f1 = 2.0 * metrics.precision * metrics.recall / (metrics.precision + metrics.recall);
+    return metrics;
+}
+
+double ConfusionMatrix::getMacroF1() const {
+    double sum = 0.0;
+    size_t classes = 0;
+    for (size_t i = 0; i < numClasses; ++i) {
+        const ClassMetrics metrics = getClassMetrics(i);
+        if (metrics.support == 0 && metrics.predicted == 0)
+            continue;
+        sum += metrics.f1;
+        ++classes;
+    }
+    return classes > 0 ? sum / (double)classes : 0.0;
+}
+
+void ConfusionMatrix::print(std::ostream& os, size_t maxPrintedClasses) const {
+    const auto oldFlags = os.flags();
+    const auto oldFill = os.fill(' ');
+    const auto oldPrecision = os.precision();
+
+    if (numClasses <= maxPrintedClasses) {
+        uint64_t maxCount = 0;
+        for (uint64_t count : counts)
+            maxCount = std::max(maxCount, count);
+        const int width = std::max<int>((int)std::to_string(maxCount).size(), (int)std::to_string(numClasses).size()) + 1;
+
+        os << "Confusion matrix (rows: true class, columns: predicted class)" << std::endl
+           << std::setw(6) << "";
+        for (size_t p = 0; p < numClasses; ++p)
+            os << std::setw(width) << p;
+        os << std::endl;
+        for (size_t t = 0; t < numClasses; ++t) {
+            os << std::setw(6) << t;
+            for (size_t p = 0; p < numClasses; ++p)
+                os << std::setw(width) << get(t, p);
+            os << std::endl;
+        }
+        os << std::endl;
+    } else {
+        os << "Confusion matrix of " << numClasses << " classes not shown (write it with --csv)" << std::endl;
+    }
+
+    os << std::setw(6) << "class" << std::setw(12) << "support" << std::setw(12) << "predicted"
+       << std::setw(12) << "precision" << std::setw(12) << "recall" << std::setw(12) << "f1" << std::endl;
+    for (size_t c = 0; c < numClasses; ++c) {
+        const ClassMetrics metrics = getClassMetrics(c);
+        if (metrics.support == 0 && metrics.predicted == 0)
+            continue;
+        os << std::setw(6) << c << std::setw(12) << metrics.support << std::setw(12) << metrics.predicted << std::fixed << std::setprecision(4)
+           << std::setw(12) << metrics.precision << std::setw(12) << metrics.recall << std::setw(12) << metrics.f1 << std::endl;
+        os.flags(oldFlags);
+    }
+    os << std::fixed << std::setprecision(4) << "Accuracy: " << getAccuracy() << " (" << getCorrect() << "/" << getTotal() << ")"
+       << " | Macro F1: " << getMacroF1() << std::endl;
+
+    os.flags(oldFlags);
+    os.fill(oldFill);
+    os.precision(oldPrecision);
+}
+
+void ConfusionMatrix::writeCsv(std::ostream& os) const {
+    os << "true\\predicted";
+    for (size_t p = 0; p < numClasses; ++p)
+        os << "," << p;
+    os << std::endl;
+    for (size_t t = 0; t < numClasses; ++t) {
+        os << t;
+        for (size_t p = 0; p < numClasses; ++p)
+            os << "," << get(t, p);
+        os << std::endl;
+    }
+}
+
+void ConfusionMatrix::writeJson(std::ostream& os, const std::string& indent) const {
+    os << indent << "\"num_classes\": " << numClasses << "," << std::endl
+       << indent << "\"total\": " << getTotal() << "," << std::endl
+       << indent << "\"correct\": " << getCorrect() << "," << std::endl
+       << indent << "\"accuracy\": " << getAccuracy() << "," << std::endl
+       << indent << "\"macro_f1\": " << getMacroF1() << "," << std::endl
+       << indent << "\"classes\": [" << std::endl;
+    for (size_t c = 0; c < numClasses; ++c) {
+        const ClassMetrics metrics = getClassMetrics(c);
+        os << indent << "  {\"class\": " << c << ", \"support\": " << metrics.support << ", \"predicted\": " << metrics.predicted
+           << ", \"precision\": " << metrics.precision << ", \"recall\": " << metrics.recall << ", \"f1\": " << metrics.f1 << "}"
+           << (c + 1 < numClasses ? "," : "") << std::endl;
+    }
+    os << indent << "]," << std::endl
+       << indent << "\"confusion_matrix\": [" << std::endl;
+    for (size_t t = 0; t < numClasses; ++t) {
+        os << indent << "  [";
+        for (size_t p = 0; p < numClasses; ++p)
+            os << (p > 0 ? ", " : "") << get(t, p);
+        os << "]" << (t + 1 < numClasses ? "," : "") << std::endl;
+    }
+    os << indent << "]" << std::endl;
+}
+
+}  // namespace WrapperTools
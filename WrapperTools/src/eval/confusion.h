@@ -0,0 +1,77 @@
+/*
+ * Confusion matrix of a classifier
+ *
+ * Counts (true class, predicted class) pairs for any number of classes and derives accuracy and the per-class
+ * precision, recall and F1 score. The bulk evaluation gives every worker thread its own matrix and merges them
+ * once the workers are done, so counting needs neither locks nor atomics:
+ *
+ *     WrapperTools::ConfusionMatrix local(numClasses);
+ *     for (size_t i = begin; i < end; ++i)
+ *         local.add(labels[i], predict(features.row(i)));
+ *     ...
+ *     total.merge(local);
+ *     total.print(std::cout);
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace WrapperTools {
+
+class ConfusionMatrix {
+public:
+    /** Metrics of one class */
+    struct ClassMetrics {
+        uint64_t support = 0;        // Vectors of this class (row sum)
+        uint64_t predicted = 0;      // Vectors predicted as this class (column sum)
+        uint64_t truePositives = 0;  // Diagonal element
+        double precision = 0.0;      // 0 if the class was never predicted
+        double recall = 0.0;         // 0 if the class does not occur
+        double f1 = 0.0;
+    };
+
+    explicit ConfusionMatrix(size_t numClasses = 0);
+
+    size_t getNumClasses() const { return numClasses; }
+
+    /** Count a vector of class trueClass predicted as predictedClass (both must be < getNumClasses()) */
+    void add(size_t trueClass, size_t predictedClass, uint64_t count = 1) { counts[trueClass * numClasses + predictedClass] += count; }
+
+    /** Number of vectors of class trueClass predicted as predictedClass */
+    uint64_t get(size_t trueClass, size_t predictedClass) const { return counts[trueClass * numClasses + predictedClass]; }
+
+    /** Add the counts of another matrix, which must have the same number of classes */
+    void merge(const ConfusionMatrix& other);
+
+    /** Number of vectors counted */
+    uint64_t getTotal() const;
+
+    /** Number of vectors predicted correctly (trace) */
+    uint64_t getCorrect() const;
+
+    double getAccuracy() const;
+
+    ClassMetrics getClassMetrics(size_t classIndex) const;
+
+    /** Unweighted mean of the F1 scores of the classes that occur or are predicted */
+    double getMacroF1() const;
+
+    /** Print the matrix (rows: true class, columns: predicted class) if it has at most maxPrintedClasses classes, then the metrics */
+    void print(std::ostream& os, size_t maxPrintedClasses = 32) const;
+
+    /** Write the matrix as CSV, one row per true class */
+    void writeCsv(std::ostream& os) const;
+
+    /** Write accuracy, per-class metrics and the matrix as the members of a JSON object, each line prefixed with indent */
+    void writeJson(std::ostream& os, const std::string& indent) const;
+
+private:
+    size_t numClasses;
+    std::vector<uint64_t> counts;  // Row-major, numClasses * numClasses
+};
+
+}  // namespace WrapperTools
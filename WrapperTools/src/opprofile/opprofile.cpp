@@ -0,0 +1,152 @@
+/*
+ * Per-operator profile report, see opprofile.h
+ */
+#include "opprofile.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace WrapperTools {
+
+static std::string formatShapes(const std::vector<std::vector<int64_t>>& shapes) {
+    std::stringstream stream;
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        if (i > 0)
+            stream << " ";
+        stream << "[";
+        for (size_t d = 0; d < shapes[i].size(); ++d)
+            stream << (d > 0 ? "," : "") << shapes[i][d];
+        stream << "]";
+    }
+    return stream.str();
+}
+
+static std::string escapeJson(const std::string& value) {
+    std::string result;
+    for (char c : value) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+static std::string escapeCsv(const std::string& value) {
+    std::string result;
+    for (char c : value) {
+        if (c == '"')
+            result += '"';
+        result += c;
+    }
+    return result;
+}
+
+OpProfile::OpProfile(int skipInvocations) : skipInvocations(skipInvocations) {}
+
+void OpProfile::add(const Backend::OpEvent& event) {
+    if (event.invocation < skipInvocations)
+        return;
+
+    if (firstInvocation < 0 || event.invocation < firstInvocation)
+        firstInvocation = event.invocation;
+    lastInvocation = std::max(lastInvocation, event.invocation);
+
+    const std::string shapes = formatShapes(event.inputShapes);
+    const std::string key = event.node + "|" + event.op + "|" + shapes;
+
+    auto found = lookup.find(key);
+    if (found == lookup.end()) {
+        Entry entry;
+        entry.op = event.op;
+        entry.node = event.node;
+        entry.shapes = shapes;
+        entry.minUs = event.durationUs;
+        entry.maxUs = event.durationUs;
+        found = lookup.emplace(key, entries.size()).first;
+        entries.push_back(entry);
+    }
+
+    Entry& entry = entries[found->second];
+    entry.calls++;
+    entry.totalUs += event.durationUs;
+    entry.minUs = std::min(entry.minUs, event.durationUs);
+    entry.maxUs = std::max(entry.maxUs, event.durationUs);
+}
+
+size_t OpProfile::getInvocationCount() const {
+    return firstInvocation < 0 ? 0 : (size_t)(lastInvocation - firstInvocation + 1);
+}
+
+double OpProfile::getTotalUsPerInvocation() const {
+    double total = 0.0;
+    for (const auto& entry : entries)
+        total += entry.totalUs;
+    const size_t invocations = getInvocationCount();
+    return invocations > 0 ? total / (double)invocations : 0.0;
+}
+
+std::vector<OpProfile::Entry> OpProfile::getEntries() const {
+    std::vector<Entry> sorted(entries);
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) { return a.totalUs > b.totalUs; });
+    return sorted;
+}
+
+void OpProfile::print(std::ostream& os, size_t maxRows) const {
+    const auto oldFlags = os.flags();
+    const auto oldFill = os.fill(' ');
+    const auto oldPrecision = os.precision();
+
+    const auto sorted = getEntries();
+    const size_t invocations = getInvocationCount();
+    double total = 0.0;
+    for (const auto& entry : sorted)
+        total += entry.totalUs;
+
+    os << "Operators: " << sorted.size() << " | Invocations: " << invocations
+       << " | Operator time per invocation: " << std::fixed << std::setprecision(2) << getTotalUsPerInvocation() << " us" << std::endl;
+
+    os << std::left << std::setw(20) << "op" << std::setw(28) << "node" << std::right << std::setw(8) << "calls"
+       << std::setw(12) << "avg us" << std::setw(12) << "min us" << std::setw(12) << "max us" << std::setw(8) << "%"
+       << "  " << std::left << "input shapes" << std::endl;
+
+    const size_t rows = maxRows > 0 ? std::min(maxRows, sorted.size()) : sorted.size();
+    for (size_t i = 0; i < rows; ++i) {
+        const auto& entry = sorted[i];
+        const double share = total > 0.0 ? 100.0 * entry.totalUs / total : 0.0;
+        os << std::left << std::setw(20) << entry.op << std::setw(28) << entry.node << std::right << std::setw(8) << entry.calls
+           << std::fixed << std::setprecision(2) << std::setw(12) << entry.getAverageUs() << std::setw(12) << entry.minUs
+           << std::setw(12) << entry.maxUs << std::setprecision(1) << std::setw(8) << share
+           << "  " << std::left << entry.shapes << std::endl;
+    }
+    if (rows < sorted.size())
+        os << "... " << sorted.size() - rows << " more operator(s) not shown" << std::endl;
+
+    os.flags(oldFlags);
+    os.fill(oldFill);
+    os.precision(oldPrecision);
+}
+
+void OpProfile::writeCsv(std::ostream& os) const {
+    os << "op,node,input_shapes,calls,total_us,avg_us,min_us,max_us" << std::endl;
+    for (const auto& entry : getEntries()) {
+        os << "\"" << escapeCsv(entry.op) << "\",\"" << escapeCsv(entry.node) << "\",\"" << entry.shapes << "\","
+           << entry.calls << "," << entry.totalUs << "," << entry.getAverageUs() << "," << entry.minUs << "," << entry.maxUs << std::endl;
+    }
+}
+
+void OpProfile::writeJson(std::ostream& os) const {
+    const auto sorted = getEntries();
+    os << "[" << std::endl;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const auto& entry = sorted[i];
+        os << "  {\"op\": \"" << escapeJson(entry.op) << "\", \"node\": \"" << escapeJson(entry.node)
+           << "\", \"input_shapes\": \"" << entry.shapes << "\", \"calls\": " << entry.calls
+           << ", \"total_us\": " << entry.totalUs << ", \"avg_us\": " << entry.getAverageUs()
+           << ", \"min_us\": " << entry.minUs << ", \"max_us\": " << entry.maxUs << "}"
+           << (i + 1 < sorted.size() ? "," : "") << std::endl;
+    }
+    os << "]" << std::endl;
+}
+
+}  // namespace WrapperTools
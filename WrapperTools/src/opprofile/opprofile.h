@@ -0,0 +1,79 @@
+/*
+ * Per-operator profile report
+ *
+ * Aggregates the operator events reported by the wrapper profilers (see Backend::enableProfiling)
+ * over many invocations. Events are grouped by node, operator type and input shapes, so the same
+ * operator type with different shapes (e.g. the conv layers of a model) gets one row per node.
+ *
+ * Typical use:
+ *
+ *     WrapperTools::OpProfile profile(warmup);
+ *     Backend::enableProfiling(model, [&](const Backend::OpEvent& e) { profile.add(e); });
+ *     for (int i = 0; i < warmup + iterations; ++i)
+ *         Backend::run(model, ...);
+ *     Backend::disableProfiling(model);
+ *     profile.print(std::cout);
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "backend.h"
+
+namespace WrapperTools {
+
+class OpProfile {
+public:
+    /** Statistics of one operator */
+    struct Entry {
+        std::string op;
+        std::string node;
+        std::string shapes;  // Input shapes, e.g. "[1,32,32,3] [8,3,3,3]"
+        size_t calls = 0;
+        double totalUs = 0.0;
+        double minUs = 0.0;
+        double maxUs = 0.0;
+
+        double getAverageUs() const { return calls > 0 ? totalUs / (double)calls : 0.0; }
+    };
+
+    /**
+     * @param skipInvocations Number of initial invocations whose events are ignored (warm-up)
+     */
+    explicit OpProfile(int skipInvocations = 0);
+
+    /** Add an event to the profile */
+    void add(const Backend::OpEvent& event);
+
+    /** Number of invocations aggregated (skipped ones excluded) */
+    size_t getInvocationCount() const;
+
+    /** Sum of the operator times, averaged over the invocations */
+    double getTotalUsPerInvocation() const;
+
+    /** Aggregated operators, sorted by decreasing total time */
+    std::vector<Entry> getEntries() const;
+
+    /** Print a table of the operators, at most maxRows of them (0 for all) */
+    void print(std::ostream& os, size_t maxRows = 0) const;
+
+    /** Write the operators as CSV, one row per operator */
+    void writeCsv(std::ostream& os) const;
+
+    /** Write the operators as a JSON array */
+    void writeJson(std::ostream& os) const;
+
+private:
+    int skipInvocations;
+    int firstInvocation = -1, lastInvocation = -1;
+
+    std::vector<Entry> entries;            // In order of first execution
+    std::map<std::string, size_t> lookup;  // node|op|shapes -> index in entries
+};
+
+}  // namespace WrapperTools
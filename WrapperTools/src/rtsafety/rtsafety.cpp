@@ -0,0 +1,319 @@
+/*
+ * Real-time safety tracker, see rtsafety.h
+ *
+ * The allocation functions forward to the __libc_* entry points of glibc, so
+ * they can be resolved without calling dlsym (which allocates). mmap and the
+ * lock functions are resolved with dlsym(RTLD_NEXT, ...) on first use.
+ */
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include "rtsafety.h"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace rtsafety {
+namespace {
+
+// Plain __thread variables: no constructors and no lazy TLS allocation inside the hooks
+__thread bool threadArmed = false;
+__thread bool insideHook = false;
+
+Event events[eventCapacity];
+std::atomic<size_t> numEvents{0};
+
+void record(EventKind kind, size_t size) {
+    if (!threadArmed || insideHook)
+        return;
+
+    insideHook = true;  // calls made while recording are not recorded
+
+    const size_t index = numEvents.fetch_add(1, std::memory_order_relaxed);
+    if (index < eventCapacity) {
+        Event& event = events[index];
+        event.kind = kind;
+        event.size = size;
+        event.numFrames = backtrace(event.frames, maxFrames);
+    }
+
+    insideHook = false;
+}
+
+using MmapFunction = void* (*)(void*, size_t, int, int, int, off_t);
+using MunmapFunction = int (*)(void*, size_t);
+using MutexLockFunction = int (*)(pthread_mutex_t*);
+using RwLockFunction = int (*)(pthread_rwlock_t*);
+using SemWaitFunction = int (*)(sem_t*);
+
+// Plain pointers rather than function-local statics: a static guard may itself lock
+MmapFunction nextMmap = nullptr;
+MunmapFunction nextMunmap = nullptr;
+MutexLockFunction nextMutexLock = nullptr;
+RwLockFunction nextRwLockRead = nullptr;
+RwLockFunction nextRwLockWrite = nullptr;
+SemWaitFunction nextSemWait = nullptr;
+
+/** Resolve (once) the next definition of an interposed function */
+template <typename FunctionType>
+FunctionType resolveNext(FunctionType& cached, const char* name) {
+    if (cached == nullptr)
+        cached = reinterpret_cast<FunctionType>(dlsym(RTLD_NEXT, name));
+    return cached;
+}
+
+void* allocateOrThrow(size_t size) {
+    record(EventKind::New, size);
+    void* ptr = __libc_malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* allocateAlignedOrThrow(size_t size, std::align_val_t alignment) {
+    record(EventKind::New, size);
+    void* ptr = __libc_memalign(static_cast<size_t>(alignment), size == 0 ? 1 : size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void deallocate(void* ptr) {
+    if (ptr != nullptr)
+        record(EventKind::Delete, 0);
+    __libc_free(ptr);
+}
+
+}  // namespace
+
+void init() {
+    // The first backtrace() loads libgcc_s, which allocates
+    void* frames[maxFrames];
+    backtrace(frames, maxFrames);
+
+    resolveNext(nextMmap, "mmap");
+    resolveNext(nextMunmap, "munmap");
+    resolveNext(nextMutexLock, "pthread_mutex_lock");
+    resolveNext(nextRwLockRead, "pthread_rwlock_rdlock");
+    resolveNext(nextRwLockWrite, "pthread_rwlock_wrlock");
+    resolveNext(nextSemWait, "sem_wait");
+}
+
+void arm() {
+    threadArmed = true;
+}
+
+void disarm() {
+    threadArmed = false;
+}
+
+bool isArmed() {
+    return threadArmed;
+}
+
+size_t getEventCount() {
+    return numEvents.load(std::memory_order_relaxed);
+}
+
+const Event& getEvent(size_t index) {
+    return events[index];
+}
+
+void clearEvents() {
+    numEvents.store(0, std::memory_order_relaxed);
+}
+
+const char* getEventName(EventKind kind) {
+    switch (kind) {
+        case EventKind::Malloc: return "malloc";
+        case EventKind::Calloc: return "calloc";
+        case EventKind::Realloc: return "realloc";
+        case EventKind::AlignedAlloc: return "aligned alloc";
+        case EventKind::Free: return "free";
+        case EventKind::New: return "operator new";
+        case EventKind::Delete: return "operator delete";
+        case EventKind::Mmap: return "mmap";
+        case EventKind::Munmap: return "munmap";
+        case EventKind::MutexLock: return "pthread_mutex_lock";
+        case EventKind::RwLock: return "pthread_rwlock lock";
+        case EventKind::SemWait: return "sem_wait";
+    }
+    return "unknown";
+}
+
+/** Demangle the function name in a line produced by backtrace_symbols ("binary(symbol+0x12) [0x...]") */
+static std::string demangleFrame(const char* frame) {
+    std::string line(frame);
+    const auto begin = line.find('(');
+    const auto end = line.find('+', begin);
+    if (begin == std::string::npos || end == std::string::npos || end == begin + 1)
+        return line;
+
+    int status = 0;
+    const std::string mangled = line.substr(begin + 1, end - begin - 1);
+    char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+    if (status != 0 || demangled == nullptr)
+        return line;
+
+    line = line.substr(0, begin + 1) + demangled + line.substr(end);
+    std::free(demangled);
+    return line;
+}
+
+void printReport(std::ostream& os, size_t maxEvents) {
+    const bool wasArmed = threadArmed;
+    threadArmed = false;
+
+    const size_t count = getEventCount();
+    os << "RTSAFETY: " << count << " non real-time safe call(s) recorded" << std::endl;
+
+    const size_t stored = count < eventCapacity ? count : eventCapacity;
+    for (size_t i = 0; i < stored && i < maxEvents; ++i) {
+        const Event& event = events[i];
+        os << "#" << i << " " << getEventName(event.kind);
+        if (event.size > 0)
+            os << " (" << event.size << " bytes)";
+        os << std::endl;
+
+        char** symbols = backtrace_symbols(event.frames, event.numFrames);
+        // Skip the frames of the tracker itself (record + hook)
+        for (int f = 2; f < event.numFrames; ++f)
+            os << "    " << (symbols != nullptr ? demangleFrame(symbols[f]) : std::string("?")) << std::endl;
+        std::free(symbols);
+    }
+
+    if (stored > maxEvents)
+        os << "... " << stored - maxEvents << " more event(s) not shown" << std::endl;
+
+    threadArmed = wasArmed;
+}
+
+}  // namespace rtsafety
+
+using rtsafety::EventKind;
+using rtsafety::record;
+using rtsafety::resolveNext;
+
+/***** Interposed C library functions *****/
+extern "C" {
+
+void* malloc(size_t size) {
+    record(EventKind::Malloc, size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    record(EventKind::Calloc, count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    record(EventKind::Realloc, size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    if (ptr != nullptr)
+        record(EventKind::Free, 0);
+    __libc_free(ptr);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    record(EventKind::AlignedAlloc, size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    record(EventKind::AlignedAlloc, size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size) {
+    record(EventKind::AlignedAlloc, size);
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    void* ptr = __libc_memalign(alignment, size);
+    if (ptr == nullptr)
+        return ENOMEM;
+    *memptr = ptr;
+    return 0;
+}
+
+void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
+    record(EventKind::Mmap, length);
+    return resolveNext(rtsafety::nextMmap, "mmap")(addr, length, prot, flags, fd, offset);
+}
+
+int munmap(void* addr, size_t length) {
+    record(EventKind::Munmap, length);
+    return resolveNext(rtsafety::nextMunmap, "munmap")(addr, length);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    record(EventKind::MutexLock, 0);
+    return resolveNext(rtsafety::nextMutexLock, "pthread_mutex_lock")(mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* rwlock) {
+    record(EventKind::RwLock, 0);
+    return resolveNext(rtsafety::nextRwLockRead, "pthread_rwlock_rdlock")(rwlock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* rwlock) {
+    record(EventKind::RwLock, 0);
+    return resolveNext(rtsafety::nextRwLockWrite, "pthread_rwlock_wrlock")(rwlock);
+}
+
+int sem_wait(sem_t* sem) {
+    record(EventKind::SemWait, 0);
+    return resolveNext(rtsafety::nextSemWait, "sem_wait")(sem);
+}
+
+}  // extern "C"
+
+/***** Replaced global allocation functions *****/
+void* operator new(size_t size) { return rtsafety::allocateOrThrow(size); }
+void* operator new[](size_t size) { return rtsafety::allocateOrThrow(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return rtsafety::allocateAlignedOrThrow(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return rtsafety::allocateAlignedOrThrow(size, alignment); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    record(EventKind::New, size);
+    return __libc_malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    record(EventKind::New, size);
+    return __libc_malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* ptr) noexcept { rtsafety::deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { rtsafety::deallocate(ptr); }
+void operator delete(void* ptr, size_t) noexcept { rtsafety::deallocate(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { rtsafety::deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { rtsafety::deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { rtsafety::deallocate(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { rtsafety::deallocate(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { rtsafety::deallocate(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { rtsafety::deallocate(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { rtsafety::deallocate(ptr); }
@@ -0,0 +1,108 @@
+/*
+ * Real-time safety tracker
+ *
+ * Linking this library into an executable interposes the allocation functions
+ * (malloc/calloc/realloc/free, the aligned variants, operator new/delete),
+ * mmap/munmap and the blocking lock functions of the C library.
+ * While a thread is armed (see ScopedArm), every call it makes to one of them
+ * is recorded in a preallocated ring buffer, together with a backtrace.
+ * Calls made by other threads, or by the armed thread while disarmed, are
+ * forwarded untouched.
+ *
+ * Typical use:
+ *
+ *     rtsafety::init();
+ *     auto model = createInterpreter(...);   // allowed to allocate
+ *     {
+ *         rtsafety::ScopedArm arm;
+ *         invoke(model, ...);                // must not allocate or lock
+ *     }
+ *     if (rtsafety::getEventCount() > 0)
+ *         rtsafety::printReport(std::cerr);
+ *
+ * Linux/glibc only.
+ */
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+namespace rtsafety {
+
+/** Kind of non real-time safe call that was recorded */
+enum class EventKind {
+    Malloc,
+    Calloc,
+    Realloc,
+    AlignedAlloc,
+    Free,
+    New,
+    Delete,
+    Mmap,
+    Munmap,
+    MutexLock,
+    RwLock,
+    SemWait,
+};
+
+/** Maximum number of stack frames stored for each event */
+constexpr int maxFrames = 32;
+
+/** Number of events that fit in the ring buffer, later events are only counted */
+constexpr size_t eventCapacity = 256;
+
+/** A recorded call */
+struct Event {
+    EventKind kind;
+    size_t size;  // Requested size for allocations and mappings, 0 otherwise
+    int numFrames;
+    void* frames[maxFrames];
+};
+
+/**
+ * @brief Prepare the tracker (do not use in real time threads)
+ * Resolves the interposed symbols and primes backtrace(), which allocates on first use.
+ * Call it once before the first arm().
+ */
+void init();
+
+/** Start recording the calls made by the current thread */
+void arm();
+
+/** Stop recording the calls made by the current thread */
+void disarm();
+
+/** Whether the current thread is armed */
+bool isArmed();
+
+/** Arms the current thread for the lifetime of the object */
+class ScopedArm {
+public:
+    ScopedArm() { arm(); }
+    ~ScopedArm() { disarm(); }
+
+    ScopedArm(const ScopedArm&) = delete;
+    ScopedArm& operator=(const ScopedArm&) = delete;
+};
+
+/** Number of events recorded since the last clearEvents(), including the ones that did not fit in the buffer */
+size_t getEventCount();
+
+/** Access a recorded event, index must be lower than min(getEventCount(), eventCapacity) */
+const Event& getEvent(size_t index);
+
+/** Forget all the recorded events (not while a thread is armed) */
+void clearEvents();
+
+/** Printable name of an event kind */
+const char* getEventName(EventKind kind);
+
+/**
+ * @brief Print the recorded events with symbolized backtraces (do not use in real time threads)
+ *
+ * @param os        Output stream
+ * @param maxEvents Maximum number of events to print
+ */
+void printReport(std::ostream& os, size_t maxEvents = 16);
+
+}  // namespace rtsafety
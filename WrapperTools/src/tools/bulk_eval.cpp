@@ -0,0 +1,435 @@
+/*
+ * bulk-eval
+ *
+ * Evaluates a classifier on a labelled dataset with all the cores of the machine. The evaluation is a pipeline:
+ *
+ *     reader -> batcher -> N inference workers -> aggregator
+ *
+ * The reader loads the features and labels (memory mapped, parsed in parallel or read from the .npy cache, see
+ * dataset.h) while the workers create their model, so the model creation overlaps the loading. The batcher then
+ * queues row ranges of the dataset in a bounded queue. Every worker owns its interpreter/classifier, pops batches,
+ * runs them and counts the results in its own confusion matrix, sized for any number of classes. Only the progress
+ * counters are shared (atomics), the matrices are merged by the aggregator once the workers are done, so the
+ * inference loop takes no lock. The aggregator reports the progress and the final metrics.
+ *
+ * Exit codes: 0 success, 1 usage error, 2 the dataset could not be read or does not match the model,
+ *             3 the model could not be created or run.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "backend.h"
+#include "bench.h"
+#include "confusion.h"
+#include "dataset.h"
+
+namespace Backend = WrapperTools::Backend;
+namespace Bench = WrapperTools::Bench;
+namespace Dataset = WrapperTools::Dataset;
+using WrapperTools::ConfusionMatrix;
+using Clock = std::chrono::steady_clock;
+
+static void printUsage(const char* execName) {
+    std::cerr << "USAGE:" << std::endl
+              << execName << " <model path> <features file> <labels file> [options]" << std::endl
+              << std::endl
+              << "  The features and labels are CSV files with a header row or .npy files (see Dataset::load)." << std::endl
+              << std::endl
+              << "  --workers N        inference threads, each with its own model (default: one per CPU)" << std::endl
+              << "  --batch N          vectors per batch handed to a worker (default 256)" << std::endl
+              << "  --queue N          batches queued ahead of the workers (default 4 per worker)" << std::endl
+              << "  --no-cache         do not read/write the .npy cache of the CSV files" << std::endl
+              << "  --label NAME       label stored with the results (default: model file name)" << std::endl
+              << "  --json FILE        write the results and metrics as JSON" << std::endl
+              << "  --csv FILE         write the confusion matrix as CSV" << std::endl
+              << "  --predictions FILE write the predicted class of every vector, one per line" << std::endl
+              << "  --quiet            no progress report" << std::endl
+              << "  --verbose          verbose model loading" << std::endl;
+}
+
+/** Bounded multi-producer/multi-consumer queue, push blocks while full, pop blocks while empty */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {}
+
+    /** Returns false if the queue was closed */
+    bool push(const T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+        if (closed)
+            return false;
+        items.push_back(item);
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /** Returns false once the queue is closed and empty */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty())
+            return false;
+        item = items.front();
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    /** No more items will be pushed, the remaining ones can still be popped */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+    /** Drop the remaining items and close (on errors) */
+    void abort() {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.clear();
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+private:
+    const size_t capacity;
+    std::deque<T> items;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable notFull, notEmpty;
+};
+
+/** Rows [begin, end) of the dataset */
+struct Batch {
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+/** State shared by the stages of the pipeline */
+struct Pipeline {
+    Pipeline(size_t queueCapacity) : batches(queueCapacity) {}
+
+    // Written by the reader before it queues the first batch, read-only afterwards
+    Dataset::Matrix features;
+    std::vector<int> labels;
+    int maxLabel = 0;
+    std::vector<int> predictions;  // One per row if requested, every row is written by exactly one worker
+    Clock::time_point inferenceStart;
+    double loadMs = 0.0;
+
+    BoundedQueue<Batch> batches;
+
+    // Progress, updated once per batch
+    std::atomic<size_t> totalRows{0};  // 0 until the dataset is loaded
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> correct{0};
+    std::atomic<unsigned> runningWorkers{0};
+
+    // First error, stops every stage
+    std::atomic<bool> failed{false};
+    std::mutex errorMutex;
+    std::string error;
+    int exitCode = 0;
+
+    void fail(int code, const std::string& message) {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (exitCode == 0) {
+                exitCode = code;
+                error = message;
+            }
+        }
+        failed = true;
+        batches.abort();
+    }
+};
+
+/** Results of one worker, merged by the aggregator */
+struct WorkerResult {
+    ConfusionMatrix matrix;
+    uint64_t vectors = 0;
+    size_t outputSize = 0;  // Number of classes the model can predict
+    double createMs = 0.0;  // Model creation
+    double busyS = 0.0;     // Time spent running batches
+};
+
+static void readerStage(Pipeline& pipeline, const std::string& featuresFilename, const std::string& labelsFilename,
+                        const Dataset::LoadOptions& loadOptions, size_t batchSize, bool keepPredictions) {
+    try {
+        const auto loadStart = Clock::now();
+        pipeline.features = Dataset::load(featuresFilename, loadOptions);
+        pipeline.labels = Dataset::toLabels(Dataset::load(labelsFilename, loadOptions));
+        pipeline.loadMs = std::chrono::duration<double, std::milli>(Clock::now() - loadStart).count();
+
+        if (pipeline.features.rows == 0)
+            throw std::runtime_error("no feature vectors in " + featuresFilename);
+        if (pipeline.labels.size() != pipeline.features.rows)
+            throw std::runtime_error(featuresFilename + " has " + std::to_string(pipeline.features.rows) + " vectors but " + labelsFilename + " has " +
+                                     std::to_string(pipeline.labels.size()) + " labels");
+        for (size_t i = 0; i < pipeline.labels.size(); ++i) {
+            if (pipeline.labels[i] < 0)
+                throw std::runtime_error("negative label " + std::to_string(pipeline.labels[i]) + " in row " + std::to_string(i) + " of " + labelsFilename);
+            pipeline.maxLabel = std::max(pipeline.maxLabel, pipeline.labels[i]);
+        }
+        if (keepPredictions)
+            pipeline.predictions.assign(pipeline.features.rows, -1);
+    } catch (const std::exception& e) {
+        pipeline.fail(2, e.what());
+        return;
+    }
+
+    // Batcher: everything above happens before the first push, so the workers see the dataset once they pop a batch
+    pipeline.inferenceStart = Clock::now();
+    pipeline.totalRows = pipeline.features.rows;
+    for (size_t begin = 0; begin < pipeline.features.rows; begin += batchSize) {
+        if (!pipeline.batches.push({begin, std::min(begin + batchSize, pipeline.features.rows)}))
+            return;
+    }
+    pipeline.batches.close();
+}
+
+static size_t argmax(const std::vector<float>& values) {
+    size_t index = 0;
+    float max = std::numeric_limits<float>::lowest();
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (values[i] > max) {
+            max = values[i];
+            index = i;
+        }
+    }
+    return index;
+}
+
+static void workerStage(Pipeline& pipeline, WorkerResult& result, const std::string& modelFilename, bool verbose) {
+    Backend::ModelPtr model = nullptr;
+    try {
+        const auto createStart = Clock::now();
+        model = Backend::load(modelFilename, verbose);
+        result.createMs = std::chrono::duration<double, std::milli>(Clock::now() - createStart).count();
+    } catch (const std::exception& e) {
+        pipeline.fail(3, std::string("could not load ") + modelFilename + " with " + Backend::getName() + ": " + e.what());
+        pipeline.runningWorkers--;
+        return;
+    }
+
+    try {
+        Batch batch;
+        bool first = true;
+        result.outputSize = Backend::getOutputSize(model);
+        std::vector<float> outputVector(result.outputSize);
+        const Dataset::Matrix& features = pipeline.features;
+
+        while (!pipeline.failed && pipeline.batches.pop(batch)) {
+            if (first) {
+                if (features.cols != Backend::getInputSize(model)) {
+                    pipeline.fail(2, "the rows of the features have " + std::to_string(features.cols) + " values, the model takes " +
+                                         std::to_string(Backend::getInputSize(model)));
+                    break;
+                }
+                // Labels the model cannot predict are counted too (always wrong), so the matrix covers both
+                result.matrix = ConfusionMatrix(std::max(outputVector.size(), (size_t)pipeline.maxLabel + 1));
+                first = false;
+            }
+
+            const auto batchStart = Clock::now();
+            uint64_t batchCorrect = 0;
+            for (size_t row = batch.begin; row < batch.end; ++row) {
+                Backend::run(model, features.row(row), features.cols, outputVector.data(), outputVector.size());
+                const size_t predicted = argmax(outputVector);
+                const size_t expected = (size_t)pipeline.labels[row];
+                result.matrix.add(expected, predicted);
+                batchCorrect += predicted == expected;
+                if (!pipeline.predictions.empty())
+                    pipeline.predictions[row] = (int)predicted;
+            }
+            result.busyS += std::chrono::duration<double>(Clock::now() - batchStart).count();
+            result.vectors += batch.end - batch.begin;
+            pipeline.processed.fetch_add(batch.end - batch.begin, std::memory_order_relaxed);
+            pipeline.correct.fetch_add(batchCorrect, std::memory_order_relaxed);
+        }
+    } catch (const std::exception& e) {
+        pipeline.fail(3, std::string("could not run ") + modelFilename + " with " + Backend::getName() + ": " + e.what());
+    }
+    Backend::unload(model);
+    pipeline.runningWorkers--;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4 || argv[1][0] == '-' || argv[2][0] == '-' || argv[3][0] == '-') {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const std::string filename(argv[1]), featuresFilename(argv[2]), labelsFilename(argv[3]);
+    int numWorkers = (int)std::max(1u, std::thread::hardware_concurrency());
+    int batchSize = 256, queueCapacity = 0;
+    std::string label, jsonFilename, csvFilename, predictionsFilename;
+    Dataset::LoadOptions loadOptions;
+    bool quiet = false, verbose = false;
+    for (int i = 4; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+            numWorkers = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+            batchSize = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--queue") == 0 && i + 1 < argc)
+            queueCapacity = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--no-cache") == 0)
+            loadOptions.useCache = false;
+        else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc)
+            label = argv[++i];
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonFilename = argv[++i];
+        else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csvFilename = argv[++i];
+        else if (std::strcmp(argv[i], "--predictions") == 0 && i + 1 < argc)
+            predictionsFilename = argv[++i];
+        else if (std::strcmp(argv[i], "--quiet") == 0)
+            quiet = true;
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (numWorkers <= 0 || batchSize <= 0 || queueCapacity < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (queueCapacity == 0)
+        queueCapacity = 4 * numWorkers;
+    if (label.empty())
+        label = Bench::baseName(filename);
+
+    Pipeline pipeline((size_t)queueCapacity);
+    std::vector<WorkerResult> results(numWorkers);
+    std::vector<std::thread> workers;
+
+    pipeline.runningWorkers = numWorkers;
+    std::thread reader(readerStage, std::ref(pipeline), featuresFilename, labelsFilename, loadOptions, (size_t)batchSize, !predictionsFilename.empty());
+    for (int i = 0; i < numWorkers; ++i)
+        workers.emplace_back(workerStage, std::ref(pipeline), std::ref(results[i]), filename, verbose);
+
+    // Aggregator: report the progress until the workers are done
+    auto lastReport = Clock::now();
+    bool reported = false;
+    while (pipeline.runningWorkers > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const auto now = Clock::now();
+        if (quiet || now - lastReport < std::chrono::seconds(1) || pipeline.totalRows == 0)
+            continue;
+        lastReport = now;
+        reported = true;
+        const uint64_t processed = pipeline.processed.load(std::memory_order_relaxed);
+        const double elapsedS = std::chrono::duration<double>(now - pipeline.inferenceStart).count();
+        std::cerr << "\r" << processed << "/" << pipeline.totalRows << " vectors, " << std::fixed << std::setprecision(0)
+                  << (elapsedS > 0.0 ? (double)processed / elapsedS : 0.0) << " vectors/s, accuracy " << std::setprecision(4)
+                  << (processed > 0 ? (double)pipeline.correct.load(std::memory_order_relaxed) / (double)processed : 0.0) << "   " << std::flush;
+        std::cerr.unsetf(std::ios::fixed);
+    }
+    const auto inferenceStop = Clock::now();
+    reader.join();
+    for (auto& worker : workers)
+        worker.join();
+    if (reported)
+        std::cerr << std::endl;
+
+    if (pipeline.exitCode != 0) {
+        std::cerr << "ERROR: " << pipeline.error << std::endl;
+        return pipeline.exitCode;
+    }
+
+    // Every worker sized its matrix the same way, those that got no batch have an empty one
+    ConfusionMatrix matrix;
+    size_t outputSize = 0;
+    double slowestCreateMs = 0.0;
+    for (const auto& result : results) {
+        if (result.vectors > 0 && matrix.getNumClasses() == 0)
+            matrix = ConfusionMatrix(result.matrix.getNumClasses());
+        if (result.vectors > 0)
+            matrix.merge(result.matrix);
+        outputSize = std::max(outputSize, result.outputSize);
+        slowestCreateMs = std::max(slowestCreateMs, result.createMs);
+    }
+
+    const size_t rows = pipeline.features.rows;
+    const double inferenceS = std::chrono::duration<double>(inferenceStop - pipeline.inferenceStart).count();
+    const double throughput = inferenceS > 0.0 ? (double)rows / inferenceS : 0.0;
+
+    std::cout << Backend::getName() << " " << filename << ": " << rows << " vectors of " << pipeline.features.cols << " features, "
+              << matrix.getNumClasses() << " classes, " << numWorkers << " worker(s), batches of " << batchSize << std::endl
+              << std::fixed << std::setprecision(1) << "Dataset loaded in " << pipeline.loadMs << " ms, models created in " << slowestCreateMs
+              << " ms (slowest worker, overlapping the loading)" << std::endl
+              << std::setprecision(3) << "Inference: " << inferenceS << " s, " << std::setprecision(0) << throughput << " vectors/s" << std::endl;
+    std::cout << std::setw(8) << "worker" << std::setw(12) << "vectors" << std::setw(12) << "busy_s" << std::setw(14) << "vectors/s" << std::endl;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        std::cout << std::setw(8) << i << std::setw(12) << result.vectors << std::setprecision(3) << std::setw(12) << result.busyS
+                  << std::setprecision(0) << std::setw(14) << (result.busyS > 0.0 ? (double)result.vectors / result.busyS : 0.0) << std::endl;
+    }
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6) << std::endl;
+    matrix.print(std::cout);
+    if ((size_t)pipeline.maxLabel >= outputSize)
+        std::cerr << "WARNING: labels go up to " << pipeline.maxLabel << " but the model has " << outputSize << " outputs" << std::endl;
+
+    if (!csvFilename.empty()) {
+        std::ofstream csv(csvFilename);
+        matrix.writeCsv(csv);
+    }
+
+    if (!predictionsFilename.empty()) {
+        std::ofstream predictions(predictionsFilename);
+        predictions << "predicted" << std::endl;
+        for (int prediction : pipeline.predictions)
+            predictions << prediction << "\n";
+    }
+
+    if (!jsonFilename.empty()) {
+        std::ofstream json(jsonFilename);
+        json << "{" << std::endl
+             << "  \"tool\": \"bulk-eval\"," << std::endl
+             << "  \"timestamp\": \"" << Bench::currentTimestamp() << "\"," << std::endl
+             << "  \"label\": \"" << Bench::escapeJson(label) << "\"," << std::endl
+             << "  \"backend\": \"" << Backend::getName() << "\"," << std::endl
+             << "  \"model\": \"" << Bench::escapeJson(filename) << "\"," << std::endl
+             << "  \"features\": \"" << Bench::escapeJson(featuresFilename) << "\"," << std::endl
+             << "  \"labels\": \"" << Bench::escapeJson(labelsFilename) << "\"," << std::endl
+             << "  \"config\": {" << std::endl
+             << "    \"workers\": " << numWorkers << "," << std::endl
+             << "    \"batch\": " << batchSize << "," << std::endl
+             << "    \"queue\": " << queueCapacity << std::endl
+             << "  }," << std::endl
+             << "  \"host\": {" << std::endl;
+        Bench::writeHostInfoJson(json, Bench::getHostInfo(), "    ");
+        json << "  }," << std::endl
+             << "  \"load_ms\": " << pipeline.loadMs << "," << std::endl
+             << "  \"create_ms\": " << slowestCreateMs << "," << std::endl
+             << "  \"inference_s\": " << inferenceS << "," << std::endl
+             << "  \"vectors_per_second\": " << throughput << "," << std::endl
+             << "  \"workers\": [" << std::endl;
+        for (size_t i = 0; i < results.size(); ++i) {
+            json << "    {\"vectors\": " << results[i].vectors << ", \"create_ms\": " << results[i].createMs << ", \"busy_s\": " << results[i].busyS << "}"
+                 << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        json << "  ]," << std::endl;
+        matrix.writeJson(json, "  ");
+        json << "}" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,236 @@
+/*
+ * latency-bench
+ *
+ * Measures the latency of the inference call of the selected backend.
+ * The model is loaded and primed, the measuring thread is optionally pinned to a CPU,
+ * moved to SCHED_FIFO and its memory locked, then every call is timed individually.
+ * Results are printed and can be written as JSON and/or appended to a CSV file,
+ * together with a description of the host and of the build.
+ *
+ * Exit codes: 0 success, 1 usage error, 3 the model could not be run, 4 the real-time settings could not be applied.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "backend.h"
+#include "bench.h"
+#include "dataset.h"
+
+namespace Backend = WrapperTools::Backend;
+namespace Bench = WrapperTools::Bench;
+namespace Dataset = WrapperTools::Dataset;
+
+static std::string profileNames() {
+    std::string names;
+    for (const auto& name : Backend::getProfileNames())
+        names += (names.empty() ? "" : ", ") + name;
+    return names;
+}
+
+static void printUsage(const char* execName) {
+    std::cerr << "USAGE:" << std::endl
+              << execName << " <model path> [options]" << std::endl
+              << std::endl
+              << "  --iterations N     timed inference calls (default 1000)" << std::endl
+              << "  --warmup N         untimed calls before measuring (default 100)" << std::endl
+              << "  --profile NAME     tuning profile of the wrapper (default: default, available: " << profileNames() << ")" << std::endl
+              << "  --features FILE    CSV (with header row) or .npy file of input vectors, used in a loop" << std::endl
+              << "                     (default: one random vector)" << std::endl
+              << "  --cpu N            pin the measuring thread to CPU N" << std::endl
+              << "  --fifo PRIO        run the measuring thread with SCHED_FIFO priority PRIO" << std::endl
+              << "  --mlock            lock the process memory" << std::endl
+              << "  --strict           fail (exit code 4) if --cpu/--fifo/--mlock cannot be applied" << std::endl
+              << "  --label NAME       label stored with the results (default: model file name)" << std::endl
+              << "  --json FILE        write the results as JSON" << std::endl
+              << "  --csv FILE         append the results as a CSV row (the header is written to new files)" << std::endl
+              << "  --raw FILE         write every latency in microseconds, one per line, in call order" << std::endl
+              << "  --verbose          verbose model loading" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argv[1][0] == '-') {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const std::string filename(argv[1]);
+    int iterations = 1000, warmup = 100;
+    std::string profile = "default";
+    std::string featuresFilename, label, jsonFilename, csvFilename, rawFilename;
+    Bench::RealtimeSettings realtime;
+    bool strict = false, verbose = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+            profile = argv[++i];
+        else if (std::strcmp(argv[i], "--features") == 0 && i + 1 < argc)
+            featuresFilename = argv[++i];
+        else if (std::strcmp(argv[i], "--cpu") == 0 && i + 1 < argc)
+            realtime.cpu = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--fifo") == 0 && i + 1 < argc)
+            realtime.fifoPriority = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--mlock") == 0)
+            realtime.lockMemory = true;
+        else if (std::strcmp(argv[i], "--strict") == 0)
+            strict = true;
+        else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc)
+            label = argv[++i];
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonFilename = argv[++i];
+        else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csvFilename = argv[++i];
+        else if (std::strcmp(argv[i], "--raw") == 0 && i + 1 < argc)
+            rawFilename = argv[++i];
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (iterations <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (label.empty())
+        label = Bench::baseName(filename) + (profile == "default" ? "" : "@" + profile);
+
+    Backend::ModelPtr model = nullptr;
+    size_t inputSize = 0, outputSize = 0;
+    Dataset::Matrix inputs;
+    try {
+        model = Backend::loadWithProfile(filename, profile, verbose);
+        inputSize = Backend::getInputSize(model);
+        outputSize = Backend::getOutputSize(model);
+
+        if (!featuresFilename.empty()) {
+            inputs = Dataset::load(featuresFilename);
+            if (inputs.rows == 0)
+                throw std::runtime_error("no input vectors in " + featuresFilename);
+            if (inputs.cols != inputSize)
+                throw std::runtime_error("the rows of " + featuresFilename + " have " + std::to_string(inputs.cols) + " values, the model takes " + std::to_string(inputSize));
+        } else {
+            std::mt19937 generator(42);
+            std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+            inputs.rows = 1;
+            inputs.cols = inputSize;
+            inputs.values.resize(inputSize);
+            for (auto& value : inputs.values)
+                value = distribution(generator);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: could not load/run " << filename << " with " << Backend::getName() << ": " << e.what() << std::endl;
+        if (model)
+            Backend::unload(model);
+        return 3;
+    }
+
+    std::string realtimeErrors;
+    const bool realtimeApplied = Bench::applyRealtimeSettings(realtime, realtimeErrors);
+    if (!realtimeApplied) {
+        std::cerr << (strict ? "ERROR: " : "WARNING: ") << realtimeErrors;
+        if (strict) {
+            Backend::unload(model);
+            return 4;
+        }
+    }
+
+    std::vector<float> outputVector(outputSize);
+    std::vector<double> latenciesUs((size_t)iterations);
+
+    for (int i = 0; i < warmup; ++i) {
+        Backend::run(model, inputs.row((size_t)i % inputs.rows), inputs.cols, outputVector.data(), outputVector.size());
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto loopStart = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        const float* input = inputs.row((size_t)i % inputs.rows);
+        const auto start = Clock::now();
+        Backend::run(model, input, inputs.cols, outputVector.data(), outputVector.size());
+        const auto stop = Clock::now();
+        latenciesUs[(size_t)i] = std::chrono::duration<double, std::micro>(stop - start).count();
+    }
+    const double wallTimeUs = std::chrono::duration<double, std::micro>(Clock::now() - loopStart).count();
+
+    Backend::unload(model);
+
+    if (!rawFilename.empty()) {
+        std::ofstream rawFile(rawFilename);
+        for (double latency : latenciesUs)
+            rawFile << latency << "\n";
+    }
+
+    const Bench::LatencyStats stats = Bench::computeLatencyStats(latenciesUs, wallTimeUs);
+    const Bench::HostInfo host = Bench::getHostInfo(realtime.cpu);
+    const std::string timestamp = Bench::currentTimestamp();
+
+    std::cout << Backend::getName() << " " << filename << " [" << inputSize << " -> " << outputSize << "] "
+              << iterations << " calls, " << warmup << " warmup" << std::endl
+              << std::fixed << std::setprecision(2)
+              << "  min " << stats.minUs << " | median " << stats.medianUs << " | p90 " << stats.p90Us
+              << " | p99 " << stats.p99Us << " | p99.9 " << stats.p999Us << " | max " << stats.maxUs << " us" << std::endl
+              << "  mean " << stats.meanUs << " | stddev " << stats.stddevUs << " | jitter (p99 - median) " << stats.jitterUs
+              << " us | throughput " << std::setprecision(1) << stats.throughputHz << " inferences/s" << std::endl
+              << "  " << host.cpuModel << " (" << host.numCpus << " cpus, governor " << host.governor << ")" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+
+    if (!jsonFilename.empty()) {
+        std::ofstream json(jsonFilename);
+        json << "{" << std::endl
+             << "  \"tool\": \"latency-bench\"," << std::endl
+             << "  \"timestamp\": \"" << timestamp << "\"," << std::endl
+             << "  \"label\": \"" << Bench::escapeJson(label) << "\"," << std::endl
+             << "  \"backend\": \"" << Backend::getName() << "\"," << std::endl
+             << "  \"model\": \"" << Bench::escapeJson(filename) << "\"," << std::endl
+             << "  \"input_size\": " << inputSize << "," << std::endl
+             << "  \"output_size\": " << outputSize << "," << std::endl
+             << "  \"config\": {" << std::endl
+             << "    \"iterations\": " << iterations << "," << std::endl
+             << "    \"warmup\": " << warmup << "," << std::endl
+             << "    \"features\": \"" << Bench::escapeJson(featuresFilename) << "\"," << std::endl
+             << "    \"cpu\": " << realtime.cpu << "," << std::endl
+             << "    \"fifo_priority\": " << realtime.fifoPriority << "," << std::endl
+             << "    \"mlock\": " << (realtime.lockMemory ? "true" : "false") << "," << std::endl
+             << "    \"realtime_applied\": " << (realtimeApplied ? "true" : "false") << std::endl
+             << "  }," << std::endl
+             << "  \"host\": {" << std::endl;
+        Bench::writeHostInfoJson(json, host, "    ");
+        json << "  }," << std::endl
+             << "  \"latency\": {" << std::endl;
+        Bench::writeLatencyStatsJson(json, stats, "    ");
+        json << "  }" << std::endl
+             << "}" << std::endl;
+    }
+
+    if (!csvFilename.empty()) {
+        const bool newFile = !std::ifstream(csvFilename).good() || std::ifstream(csvFilename).peek() == std::ifstream::traits_type::eof();
+        std::ofstream csv(csvFilename, std::ios::app);
+        if (newFile)
+            csv << "timestamp,label,backend,model,input_size,output_size,iterations,warmup,cpu,fifo_priority,mlock,realtime_applied,"
+                   "min_us,median_us,p90_us,p99_us,p999_us,max_us,mean_us,stddev_us,jitter_us,throughput_hz,"
+                   "hostname,kernel,machine,cpu_model,num_cpus,governor,compiler,cxx_flags,build_type"
+                << std::endl;
+        csv << timestamp << "," << Bench::quoteCsv(label) << "," << Backend::getName() << "," << Bench::quoteCsv(filename) << ","
+            << inputSize << "," << outputSize << "," << iterations << "," << warmup << "," << realtime.cpu << ","
+            << realtime.fifoPriority << "," << realtime.lockMemory << "," << realtimeApplied << ","
+            << stats.minUs << "," << stats.medianUs << "," << stats.p90Us << "," << stats.p99Us << "," << stats.p999Us << ","
+            << stats.maxUs << "," << stats.meanUs << "," << stats.stddevUs << "," << stats.jitterUs << "," << stats.throughputHz << ","
+            << Bench::quoteCsv(host.hostname) << "," << Bench::quoteCsv(host.kernel) << "," << Bench::quoteCsv(host.machine) << "," << Bench::quoteCsv(host.cpuModel) << ","
+            << host.numCpus << "," << Bench::quoteCsv(host.governor) << "," << Bench::quoteCsv(host.compiler) << "," << Bench::quoteCsv(host.cxxFlags) << ","
+            << Bench::quoteCsv(host.buildType) << std::endl;
+    }
+    return 0;
+}
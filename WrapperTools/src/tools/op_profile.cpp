@@ -0,0 +1,99 @@
+/*
+ * op-profile
+ *
+ * Loads a model with the selected backend, attaches the native profiler of the
+ * runtime and runs inference many times. The operator events are aggregated into
+ * a per-operator report (one row per node), sorted by total time.
+ *
+ * Exit codes: 0 success, 1 usage error, 3 the model could not be run or profiled.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "backend.h"
+#include "opprofile.h"
+
+namespace Backend = WrapperTools::Backend;
+
+static void printUsage(const char* execName) {
+    std::cerr << "USAGE:" << std::endl
+              << execName << " <model path> [--iterations N] [--warmup N] [--top N] [--csv FILE] [--json FILE] [--verbose]" << std::endl
+              << std::endl
+              << "  --iterations N   profiled inference calls (default 100)" << std::endl
+              << "  --warmup N       inference calls made with the profiler attached, but left out of the report (default 10)" << std::endl
+              << "  --top N          only print the N most expensive operators (default all)" << std::endl
+              << "  --csv FILE       also write the report as CSV" << std::endl
+              << "  --json FILE      also write the report as JSON" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argv[1][0] == '-') {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const std::string filename(argv[1]);
+    int iterations = 100, warmup = 10, top = 0;
+    std::string csvFilename, jsonFilename;
+    bool verbose = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--top") == 0 && i + 1 < argc)
+            top = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csvFilename = argv[++i];
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonFilename = argv[++i];
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    WrapperTools::OpProfile profile(warmup);
+    Backend::ModelPtr model = nullptr;
+    try {
+        model = Backend::load(filename, verbose);
+        std::vector<float> inputVector(Backend::getInputSize(model)), outputVector(Backend::getOutputSize(model));
+
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        for (auto& value : inputVector)
+            value = distribution(generator);
+
+        // The warm-up calls are profiled too: some runtimes need a new session to profile, which has to be primed again
+        Backend::enableProfiling(model, [&profile](const Backend::OpEvent& event) { profile.add(event); });
+        for (int i = 0; i < warmup + iterations; ++i)
+            Backend::run(model, inputVector.data(), inputVector.size(), outputVector.data(), outputVector.size());
+        Backend::disableProfiling(model);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: could not profile " << filename << " with " << Backend::getName() << ": " << e.what() << std::endl;
+        if (model)
+            Backend::unload(model);
+        return 3;
+    }
+    Backend::unload(model);
+
+    std::cout << Backend::getName() << " " << filename << " (" << iterations << " calls, " << warmup << " warmup)" << std::endl;
+    profile.print(std::cout, (size_t)(top > 0 ? top : 0));
+
+    if (!csvFilename.empty()) {
+        std::ofstream csvFile(csvFilename);
+        profile.writeCsv(csvFile);
+    }
+    if (!jsonFilename.empty()) {
+        std::ofstream jsonFile(jsonFilename);
+        profile.writeJson(jsonFile);
+    }
+    return 0;
+}
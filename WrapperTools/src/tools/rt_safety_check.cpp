@@ -0,0 +1,98 @@
+/*
+ * rt-safety-check
+ *
+ * Loads a model with the selected backend, then calls the inference function
+ * with the rtsafety tracker armed. Any allocation, mmap or blocking lock made by
+ * the inference call is reported with its backtrace.
+ *
+ * Exit codes: 0 real-time safe, 1 usage error, 2 non real-time safe calls found, 3 the model could not be run.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "backend.h"
+#include "rtsafety.h"
+
+namespace Backend = WrapperTools::Backend;
+
+static void printUsage(const char* execName) {
+    std::cerr << "USAGE:" << std::endl
+              << execName << " <model path> [--iterations N] [--warmup N] [--verbose]" << std::endl
+              << execName << " --model-extension" << std::endl
+              << std::endl
+              << "  --iterations N   armed inference calls (default 100)" << std::endl
+              << "  --warmup N       unchecked inference calls made after loading (default 0," << std::endl
+              << "                   i.e. the priming done while loading must be enough)" << std::endl
+              << "  --model-extension  print the model file extension of the backend and exit" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 2 && std::strcmp(argv[1], "--model-extension") == 0) {
+        std::cout << Backend::getModelExtension() << std::endl;
+        return 0;
+    }
+    if (argc < 2 || argv[1][0] == '-') {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const std::string filename(argv[1]);
+    int iterations = 100, warmup = 0;
+    bool verbose = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    rtsafety::init();
+
+    Backend::ModelPtr model = nullptr;
+    std::vector<float> inputVector, outputVector;
+    try {
+        model = Backend::load(filename, verbose);
+        inputVector.resize(Backend::getInputSize(model));
+        outputVector.resize(Backend::getOutputSize(model));
+
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        for (auto& value : inputVector)
+            value = distribution(generator);
+
+        for (int i = 0; i < warmup; ++i)
+            Backend::run(model, inputVector.data(), inputVector.size(), outputVector.data(), outputVector.size());
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: could not load/run " << filename << " with " << Backend::getName() << ": " << e.what() << std::endl;
+        return 3;
+    }
+
+    rtsafety::clearEvents();
+    {
+        rtsafety::ScopedArm arm;
+        for (int i = 0; i < iterations; ++i)
+            Backend::run(model, inputVector.data(), inputVector.size(), outputVector.data(), outputVector.size());
+    }
+    const size_t numEvents = rtsafety::getEventCount();
+
+    std::cout << Backend::getName() << " " << filename << " (" << iterations << " calls, " << warmup << " warmup): ";
+    if (numEvents == 0) {
+        std::cout << "PASS" << std::endl;
+    } else {
+        std::cout << "FAIL" << std::endl;
+        rtsafety::printReport(std::cout);
+    }
+
+    Backend::unload(model);
+    return numEvents == 0 ? 0 : 2;
+}
@@ -0,0 +1,270 @@
+/*
+ * startup-bench
+ *
+ * Measures the cost of creating and destroying an interpreter/classifier of the selected backend.
+ * The model is created, run a few times and deleted repeatedly in the same process. For each repetition
+ * the wall time of every creation phase reported by the wrapper (load, build, allocate, prime), the
+ * teardown time and the change of resident memory (total, anonymous and file-backed pages) are recorded.
+ * The first repetition includes the one-time initialization of the runtime and is reported as "cold".
+ *
+ * Exit codes: 0 success, 1 usage error, 3 the model could not be created or run.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "backend.h"
+#include "bench.h"
+
+namespace Backend = WrapperTools::Backend;
+namespace Bench = WrapperTools::Bench;
+
+/** Phase names reported by the wrappers, in execution order (the CSV has one column per phase) */
+static const std::vector<std::string> phaseNames = {"load", "build", "allocate", "prime"};
+
+/** Measurements of one create/run/delete cycle */
+struct StartupSample {
+    double createUs = 0.0;                   // Whole load call, as seen by the caller
+    std::map<std::string, double> phasesUs;  // Phases reported by the wrapper
+    double teardownUs = 0.0;
+    Bench::MemoryUsage createMemory;    // Increase caused by the creation
+    Bench::MemoryUsage runMemory;       // Further increase caused by the inference calls after priming
+    Bench::MemoryUsage residualMemory;  // Left after deleting the model (runtime caches, allocator arenas, leaks)
+};
+
+static void printUsage(const char* execName) {
+    std::cerr << "USAGE:" << std::endl
+              << execName << " <model path> [options]" << std::endl
+              << std::endl
+              << "  --repeats N    create/delete cycles (default 10, the first one is the cold start)" << std::endl
+              << "  --runs N       inference calls between creation and deletion (default 10)" << std::endl
+              << "  --label NAME   label stored with the results (default: model file name)" << std::endl
+              << "  --json FILE    write the results as JSON" << std::endl
+              << "  --csv FILE     append one CSV row per cycle (the header is written to new files)" << std::endl
+              << "  --verbose      verbose model loading" << std::endl;
+}
+
+static StartupSample measureStartup(const std::string& filename, int runs, bool verbose) {
+    using Clock = std::chrono::steady_clock;
+    StartupSample sample;
+
+    const Bench::MemoryUsage before = Bench::getMemoryUsage();
+    const auto createStart = Clock::now();
+    Backend::ModelPtr model = Backend::load(filename, verbose);
+    sample.createUs = std::chrono::duration<double, std::micro>(Clock::now() - createStart).count();
+    const Bench::MemoryUsage created = Bench::getMemoryUsage();
+
+    for (const auto& phase : Backend::getStartupPhases(model))
+        sample.phasesUs[phase.name] = phase.durationUs;
+
+    try {
+        std::vector<float> inputVector(Backend::getInputSize(model)), outputVector(Backend::getOutputSize(model));
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        for (auto& value : inputVector)
+            value = distribution(generator);
+        for (int i = 0; i < runs; ++i)
+            Backend::run(model, inputVector.data(), inputVector.size(), outputVector.data(), outputVector.size());
+    } catch (...) {
+        Backend::unload(model);
+        throw;
+    }
+    const Bench::MemoryUsage afterRuns = Bench::getMemoryUsage();
+
+    const auto teardownStart = Clock::now();
+    Backend::unload(model);
+    sample.teardownUs = std::chrono::duration<double, std::micro>(Clock::now() - teardownStart).count();
+    const Bench::MemoryUsage unloaded = Bench::getMemoryUsage();
+
+    sample.createMemory = created - before;
+    sample.runMemory = afterRuns - created;
+    sample.residualMemory = unloaded - before;
+    return sample;
+}
+
+static double median(std::vector<double> values) {
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+/** Median of a value over the warm cycles (all but the first) */
+template <typename Getter>
+static double warmMedian(const std::vector<StartupSample>& samples, Getter getter) {
+    std::vector<double> values;
+    for (size_t i = 1; i < samples.size(); ++i)
+        values.push_back(getter(samples[i]));
+    return median(values);
+}
+
+static void printReport(std::ostream& os, const std::vector<StartupSample>& samples) {
+    os << std::fixed << std::setprecision(1)
+       << std::setw(8) << "cycle" << std::setw(12) << "create_us";
+    for (const auto& name : phaseNames)
+        os << std::setw(12) << name + "_us";
+    os << std::setw(12) << "teardown_us" << std::setw(12) << "rss_kb" << std::setw(12) << "anon_kb" << std::setw(12) << "file_kb"
+       << std::setw(12) << "run_rss_kb" << std::setw(14) << "residual_kb" << std::endl;
+
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const auto& sample = samples[i];
+        os << std::setw(8) << (i == 0 ? std::string("cold") : std::to_string(i)) << std::setw(12) << sample.createUs;
+        for (const auto& name : phaseNames) {
+            const auto phase = sample.phasesUs.find(name);
+            if (phase == sample.phasesUs.end())
+                os << std::setw(12) << "-";
+            else
+                os << std::setw(12) << phase->second;
+        }
+        os << std::setw(12) << sample.teardownUs << std::setw(12) << sample.createMemory.rssKb << std::setw(12) << sample.createMemory.anonKb
+           << std::setw(12) << sample.createMemory.fileKb << std::setw(12) << sample.runMemory.rssKb << std::setw(14) << sample.residualMemory.rssKb
+           << std::endl;
+    }
+
+    if (samples.size() > 1) {
+        os << std::setw(8) << "warm" << std::setw(12) << warmMedian(samples, [](const StartupSample& s) { return s.createUs; });
+        for (const auto& name : phaseNames) {
+            if (samples[0].phasesUs.count(name) == 0) {
+                os << std::setw(12) << "-";
+                continue;
+            }
+            os << std::setw(12) << warmMedian(samples, [&name](const StartupSample& s) { return s.phasesUs.at(name); });
+        }
+        os << std::setw(12) << warmMedian(samples, [](const StartupSample& s) { return s.teardownUs; })
+           << "   (median of the warm cycles)" << std::endl;
+    }
+    os.unsetf(std::ios::fixed);
+    os << std::setprecision(6);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argv[1][0] == '-') {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const std::string filename(argv[1]);
+    int repeats = 10, runs = 10;
+    std::string label, jsonFilename, csvFilename;
+    bool verbose = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--repeats") == 0 && i + 1 < argc)
+            repeats = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+            runs = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc)
+            label = argv[++i];
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonFilename = argv[++i];
+        else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csvFilename = argv[++i];
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (repeats <= 0 || runs < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (label.empty())
+        label = Bench::baseName(filename);
+
+    std::vector<StartupSample> samples;
+    try {
+        for (int i = 0; i < repeats; ++i)
+            samples.push_back(measureStartup(filename, runs, verbose));
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: could not load/run " << filename << " with " << Backend::getName() << ": " << e.what() << std::endl;
+        return 3;
+    }
+
+    const Bench::HostInfo host = Bench::getHostInfo();
+    const std::string timestamp = Bench::currentTimestamp();
+
+    std::cout << Backend::getName() << " " << filename << " (" << repeats << " cycles, " << runs << " runs per cycle)" << std::endl;
+    printReport(std::cout, samples);
+
+    if (!jsonFilename.empty()) {
+        std::ofstream json(jsonFilename);
+        json << "{" << std::endl
+             << "  \"tool\": \"startup-bench\"," << std::endl
+             << "  \"timestamp\": \"" << timestamp << "\"," << std::endl
+             << "  \"label\": \"" << Bench::escapeJson(label) << "\"," << std::endl
+             << "  \"backend\": \"" << Backend::getName() << "\"," << std::endl
+             << "  \"model\": \"" << Bench::escapeJson(filename) << "\"," << std::endl
+             << "  \"config\": {" << std::endl
+             << "    \"repeats\": " << repeats << "," << std::endl
+             << "    \"runs\": " << runs << std::endl
+             << "  }," << std::endl
+             << "  \"host\": {" << std::endl;
+        Bench::writeHostInfoJson(json, host, "    ");
+        json << "  }," << std::endl
+             << "  \"cycles\": [" << std::endl;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            const auto& sample = samples[i];
+            json << "    {" << std::endl
+                 << "      \"cold\": " << (i == 0 ? "true" : "false") << "," << std::endl
+                 << "      \"create_us\": " << sample.createUs << "," << std::endl
+                 << "      \"phases_us\": {";
+            size_t phaseIndex = 0;
+            for (const auto& name : phaseNames) {
+                const auto phase = sample.phasesUs.find(name);
+                if (phase == sample.phasesUs.end())
+                    continue;
+                json << (phaseIndex++ > 0 ? ", " : "") << "\"" << name << "\": " << phase->second;
+            }
+            json << "}," << std::endl
+                 << "      \"teardown_us\": " << sample.teardownUs << "," << std::endl
+                 << "      \"create_memory\": {" << std::endl;
+            Bench::writeMemoryUsageJson(json, sample.createMemory, "        ");
+            json << "      }," << std::endl
+                 << "      \"run_memory\": {" << std::endl;
+            Bench::writeMemoryUsageJson(json, sample.runMemory, "        ");
+            json << "      }," << std::endl
+                 << "      \"residual_memory\": {" << std::endl;
+            Bench::writeMemoryUsageJson(json, sample.residualMemory, "        ");
+            json << "      }" << std::endl
+                 << "    }" << (i + 1 < samples.size() ? "," : "") << std::endl;
+        }
+        json << "  ]" << std::endl
+             << "}" << std::endl;
+    }
+
+    if (!csvFilename.empty()) {
+        const bool newFile = !std::ifstream(csvFilename).good() || std::ifstream(csvFilename).peek() == std::ifstream::traits_type::eof();
+        std::ofstream csv(csvFilename, std::ios::app);
+        if (newFile) {
+            csv << "timestamp,label,backend,model,cycle,cold,create_us,";
+            for (const auto& name : phaseNames)
+                csv << name << "_us,";
+            csv << "teardown_us,rss_kb,anon_kb,file_kb,run_rss_kb,residual_rss_kb,residual_anon_kb,hostname,cpu_model,compiler,build_type" << std::endl;
+        }
+        for (size_t i = 0; i < samples.size(); ++i) {
+            const auto& sample = samples[i];
+            csv << timestamp << "," << Bench::quoteCsv(label) << "," << Backend::getName() << "," << Bench::quoteCsv(filename) << ","
+                << i << "," << (i == 0) << "," << sample.createUs << ",";
+            for (const auto& name : phaseNames) {
+                const auto phase = sample.phasesUs.find(name);
+                if (phase != sample.phasesUs.end())
+                    csv << phase->second;
+                csv << ",";
+            }
+            csv << sample.teardownUs << "," << sample.createMemory.rssKb << "," << sample.createMemory.anonKb << "," << sample.createMemory.fileKb << ","
+                << sample.runMemory.rssKb << "," << sample.residualMemory.rssKb << "," << sample.residualMemory.anonKb << ","
+                << Bench::quoteCsv(host.hostname) << "," << Bench::quoteCsv(host.cpuModel) << "," << Bench::quoteCsv(host.compiler) << ","
+                << Bench::quoteCsv(host.buildType) << std::endl;
+        }
+    }
+    return 0;
+}